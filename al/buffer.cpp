@@ -64,191 +64,6 @@
 
 namespace {
 
-constexpr int MaxAdpcmChannels{2};
-
-/* IMA ADPCM Stepsize table */
-constexpr int IMAStep_size[89] = {
-       7,    8,    9,   10,   11,   12,   13,   14,   16,   17,   19,
-      21,   23,   25,   28,   31,   34,   37,   41,   45,   50,   55,
-      60,   66,   73,   80,   88,   97,  107,  118,  130,  143,  157,
-     173,  190,  209,  230,  253,  279,  307,  337,  371,  408,  449,
-     494,  544,  598,  658,  724,  796,  876,  963, 1060, 1166, 1282,
-    1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660,
-    4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493,10442,
-   11487,12635,13899,15289,16818,18500,20350,22358,24633,27086,29794,
-   32767
-};
-
-/* IMA4 ADPCM Codeword decode table */
-constexpr int IMA4Codeword[16] = {
-    1, 3, 5, 7, 9, 11, 13, 15,
-   -1,-3,-5,-7,-9,-11,-13,-15,
-};
-
-/* IMA4 ADPCM Step index adjust decode table */
-constexpr int IMA4Index_adjust[16] = {
-   -1,-1,-1,-1, 2, 4, 6, 8,
-   -1,-1,-1,-1, 2, 4, 6, 8
-};
-
-
-/* MSADPCM Adaption table */
-constexpr int MSADPCMAdaption[16] = {
-    230, 230, 230, 230, 307, 409, 512, 614,
-    768, 614, 512, 409, 307, 230, 230, 230
-};
-
-/* MSADPCM Adaption Coefficient tables */
-constexpr int MSADPCMAdaptionCoeff[7][2] = {
-    { 256,    0 },
-    { 512, -256 },
-    {   0,    0 },
-    { 192,   64 },
-    { 240,    0 },
-    { 460, -208 },
-    { 392, -232 }
-};
-
-
-void DecodeIMA4Block(int16_t *dst, const al::byte *src, size_t numchans, size_t align)
-{
-    int sample[MaxAdpcmChannels]{};
-    int index[MaxAdpcmChannels]{};
-    ALuint code[MaxAdpcmChannels]{};
-
-    for(size_t c{0};c < numchans;c++)
-    {
-        sample[c] = src[0] | (src[1]<<8);
-        sample[c] = (sample[c]^0x8000) - 32768;
-        src += 2;
-        index[c] = src[0] | (src[1]<<8);
-        index[c] = clampi((index[c]^0x8000) - 32768, 0, 88);
-        src += 2;
-
-        *(dst++) = static_cast<int16_t>(sample[c]);
-    }
-
-    for(size_t i{1};i < align;i++)
-    {
-        if((i&7) == 1)
-        {
-            for(size_t c{0};c < numchans;c++)
-            {
-                code[c] = ALuint{src[0]} | (ALuint{src[1]}<< 8) | (ALuint{src[2]}<<16)
-                    | (ALuint{src[3]}<<24);
-                src += 4;
-            }
-        }
-
-        for(size_t c{0};c < numchans;c++)
-        {
-            const ALuint nibble{code[c]&0xf};
-            code[c] >>= 4;
-
-            sample[c] += IMA4Codeword[nibble] * IMAStep_size[index[c]] / 8;
-            sample[c] = clampi(sample[c], -32768, 32767);
-
-            index[c] += IMA4Index_adjust[nibble];
-            index[c] = clampi(index[c], 0, 88);
-
-            *(dst++) = static_cast<int16_t>(sample[c]);
-        }
-    }
-}
-
-void DecodeMSADPCMBlock(int16_t *dst, const al::byte *src, size_t numchans, size_t align)
-{
-    uint8_t blockpred[MaxAdpcmChannels]{};
-    int delta[MaxAdpcmChannels]{};
-    int16_t samples[MaxAdpcmChannels][2]{};
-
-    for(size_t c{0};c < numchans;c++)
-    {
-        blockpred[c] = std::min<ALubyte>(src[0], 6);
-        ++src;
-    }
-    for(size_t c{0};c < numchans;c++)
-    {
-        delta[c] = src[0] | (src[1]<<8);
-        delta[c] = (delta[c]^0x8000) - 32768;
-        src += 2;
-    }
-    for(size_t c{0};c < numchans;c++)
-    {
-        samples[c][0] = static_cast<ALshort>(src[0] | (src[1]<<8));
-        src += 2;
-    }
-    for(size_t c{0};c < numchans;c++)
-    {
-        samples[c][1] = static_cast<ALshort>(src[0] | (src[1]<<8));
-        src += 2;
-    }
-
-    /* Second sample is written first. */
-    for(size_t c{0};c < numchans;c++)
-        *(dst++) = samples[c][1];
-    for(size_t c{0};c < numchans;c++)
-        *(dst++) = samples[c][0];
-
-    int num{0};
-    for(size_t i{2};i < align;i++)
-    {
-        for(size_t c{0};c < numchans;c++)
-        {
-            /* Read the nibble (first is in the upper bits). */
-            al::byte nibble;
-            if(!(num++ & 1))
-                nibble = *src >> 4;
-            else
-                nibble = *(src++) & 0x0f;
-
-            int pred{(samples[c][0]*MSADPCMAdaptionCoeff[blockpred[c]][0] +
-                samples[c][1]*MSADPCMAdaptionCoeff[blockpred[c]][1]) / 256};
-            pred += ((nibble^0x08) - 0x08) * delta[c];
-            pred  = clampi(pred, -32768, 32767);
-
-            samples[c][1] = samples[c][0];
-            samples[c][0] = static_cast<int16_t>(pred);
-
-            delta[c] = (MSADPCMAdaption[nibble] * delta[c]) / 256;
-            delta[c] = maxi(16, delta[c]);
-
-            *(dst++) = static_cast<int16_t>(pred);
-        }
-    }
-}
-
-void Convert_int16_ima4(int16_t *dst, const al::byte *src, size_t numchans, size_t len,
-    size_t align)
-{
-    assert(numchans <= MaxAdpcmChannels);
-    const size_t byte_align{((align-1)/2 + 4) * numchans};
-
-    len /= align;
-    while(len--)
-    {
-        DecodeIMA4Block(dst, src, numchans, align);
-        src += byte_align;
-        dst += align*numchans;
-    }
-}
-
-void Convert_int16_msadpcm(int16_t *dst, const al::byte *src, size_t numchans, size_t len,
-    size_t align)
-{
-    assert(numchans <= MaxAdpcmChannels);
-    const size_t byte_align{((align-2)/2 + 7) * numchans};
-
-    len /= align;
-    while(len--)
-    {
-        DecodeMSADPCMBlock(dst, src, numchans, align);
-        src += byte_align;
-        dst += align*numchans;
-    }
-}
-
-
 ALuint BytesFromUserFmt(UserFmtType type) noexcept
 {
     switch(type)
@@ -354,9 +169,8 @@ al::optional<FmtType> FmtFromUserFmt(UserFmtType type)
     case UserFmtDouble: return al::make_optional(FmtDouble);
     case UserFmtMulaw: return al::make_optional(FmtMulaw);
     case UserFmtAlaw: return al::make_optional(FmtAlaw);
-    /* ADPCM not handled here. */
-    case UserFmtIMA4: break;
-    case UserFmtMSADPCM: break;
+    case UserFmtIMA4: return al::make_optional(FmtIMA4);
+    case UserFmtMSADPCM: return al::make_optional(FmtMSADPCM);
     }
     return al::nullopt;
 }
@@ -462,6 +276,16 @@ void FreeBuffer(ALCdevice *device, ALbuffer *buffer)
     device->BufferList[lidx].FreeMask |= 1_u64 << slidx;
 }
 
+/* Gives the buffer a new data version, so anything derived from the previous
+ * samples can tell they changed. The counter is shared by all buffers, so a
+ * version is never reused even if the buffer's storage is.
+ */
+void UpdateDataVersion(ALbuffer *buffer) noexcept
+{
+    static std::atomic<uint64_t> NextDataVersion{1u};
+    buffer->mDataVersion = NextDataVersion.fetch_add(1u, std::memory_order_relaxed);
+}
+
 inline ALbuffer *LookupBuffer(ALCdevice *device, ALuint id)
 {
     const size_t lidx{(id-1) >> 6};
@@ -540,20 +364,10 @@ void LoadData(ALCcontext *context, ALbuffer *ALBuf, ALsizei freq, ALuint size,
     if UNLIKELY(!DstChannels)
         SETERR_RETURN(context, AL_INVALID_ENUM, , "Invalid format");
 
-    /* IMA4 and MSADPCM convert to 16-bit short.
-     *
-     * TODO: Currently we can only map samples when they're not converted. To
-     * allow it would need some kind of double-buffering to hold onto a copy of
-     * the original data.
+    /* Samples are stored in their original format, including IMA4 and
+     * MSADPCM, which get decoded as they're mixed.
      */
-    if((access&MAP_READ_WRITE_FLAGS))
-    {
-        if UNLIKELY(SrcType == UserFmtIMA4 || SrcType == UserFmtMSADPCM)
-            SETERR_RETURN(context, AL_INVALID_VALUE,, "%s samples cannot be mapped",
-                NameFromUserFmtType(SrcType));
-    }
-    auto DstType = (SrcType == UserFmtIMA4 || SrcType == UserFmtMSADPCM)
-        ? al::make_optional(FmtShort) : FmtFromUserFmt(SrcType);
+    auto DstType = FmtFromUserFmt(SrcType);
     if UNLIKELY(!DstType)
         SETERR_RETURN(context, AL_INVALID_ENUM, , "Invalid format");
 
@@ -594,15 +408,10 @@ void LoadData(ALCcontext *context, ALbuffer *ALBuf, ALsizei freq, ALuint size,
             "Buffer size overflow, %d blocks x %d samples per block", size/SrcByteAlign, align);
     const ALuint frames{size / SrcByteAlign * align};
 
-    /* Convert the sample frames to the number of bytes needed for internal
-     * storage.
+    /* Since the samples aren't converted, the internal storage is the same
+     * size as the input.
      */
-    ALuint NumChannels{ChannelsFromFmt(*DstChannels, ambiorder)};
-    ALuint FrameSize{NumChannels * BytesFromFmt(*DstType)};
-    if UNLIKELY(frames > std::numeric_limits<size_t>::max()/FrameSize)
-        SETERR_RETURN(context, AL_OUT_OF_MEMORY,,
-            "Buffer size overflow, %d frames x %d bytes per frame", frames, FrameSize);
-    size_t newsize{static_cast<size_t>(frames) * FrameSize};
+    size_t newsize{size};
 
 #ifdef ALSOFT_EAX
     if(ALBuf->eax_x_ram_mode == AL_STORAGE_HARDWARE)
@@ -632,29 +441,10 @@ void LoadData(ALCcontext *context, ALbuffer *ALBuf, ALsizei freq, ALuint size,
         newdata.swap(ALBuf->mData);
     }
 
-    if(SrcType == UserFmtIMA4)
-    {
-        assert(*DstType == FmtShort);
-        if(SrcData != nullptr && !ALBuf->mData.empty())
-            Convert_int16_ima4(reinterpret_cast<int16_t*>(ALBuf->mData.data()), SrcData,
-                NumChannels, frames, align);
-        ALBuf->OriginalAlign = align;
-    }
-    else if(SrcType == UserFmtMSADPCM)
-    {
-        assert(*DstType == FmtShort);
-        if(SrcData != nullptr && !ALBuf->mData.empty())
-            Convert_int16_msadpcm(reinterpret_cast<int16_t*>(ALBuf->mData.data()), SrcData,
-                NumChannels, frames, align);
-        ALBuf->OriginalAlign = align;
-    }
-    else
-    {
-        assert(DstType.has_value());
-        if(SrcData != nullptr && !ALBuf->mData.empty())
-            std::copy_n(SrcData, frames*FrameSize, ALBuf->mData.begin());
-        ALBuf->OriginalAlign = 1;
-    }
+    if(SrcData != nullptr && !ALBuf->mData.empty())
+        std::copy_n(SrcData, size, ALBuf->mData.begin());
+    UpdateDataVersion(ALBuf);
+    ALBuf->OriginalAlign = IsCompressedFmt(*DstType) ? align : 1;
     ALBuf->OriginalSize = size;
     ALBuf->OriginalType = SrcType;
 
@@ -669,6 +459,7 @@ void LoadData(ALCcontext *context, ALbuffer *ALBuf, ALsizei freq, ALuint size,
     ALBuf->mUserData = nullptr;
 
     ALBuf->mSampleLen = frames;
+    ALBuf->mBlockAlign = ALBuf->OriginalAlign;
     ALBuf->mLoopStart = 0;
     ALBuf->mLoopEnd = ALBuf->mSampleLen;
 
@@ -692,9 +483,9 @@ void PrepareCallback(ALCcontext *context, ALbuffer *ALBuf, ALsizei freq,
     if UNLIKELY(!DstChannels)
         SETERR_RETURN(context, AL_INVALID_ENUM,, "Invalid format");
 
-    /* IMA4 and MSADPCM convert to 16-bit short. Not supported with callbacks. */
+    /* IMA4 and MSADPCM are not supported with callbacks. */
     auto DstType = FmtFromUserFmt(SrcType);
-    if UNLIKELY(!DstType)
+    if UNLIKELY(!DstType || IsCompressedFmt(*DstType))
         SETERR_RETURN(context, AL_INVALID_ENUM,, "Unsupported callback format");
 
     const ALuint ambiorder{IsBFormat(*DstChannels) ? ALBuf->UnpackAmbiOrder :
@@ -703,6 +494,7 @@ void PrepareCallback(ALCcontext *context, ALbuffer *ALBuf, ALsizei freq,
     static constexpr uint line_size{BufferLineSize + MaxPostVoiceLoad};
     al::vector<al::byte,16>(FrameSizeFromFmt(*DstChannels, *DstType, ambiorder) *
         size_t{line_size}).swap(ALBuf->mData);
+    UpdateDataVersion(ALBuf);
 
 #ifdef ALSOFT_EAX
     eax_x_ram_clear(*context->mALDevice, *ALBuf);
@@ -722,6 +514,7 @@ void PrepareCallback(ALCcontext *context, ALbuffer *ALBuf, ALsizei freq,
     ALBuf->mAmbiOrder = ambiorder;
 
     ALBuf->mSampleLen = 0;
+    ALBuf->mBlockAlign = 1;
     ALBuf->mLoopStart = 0;
     ALBuf->mLoopEnd = ALBuf->mSampleLen;
 }
@@ -1026,6 +819,8 @@ START_API_FUNC
         context->setError(AL_INVALID_OPERATION, "Unmapping unmapped buffer %u", buffer);
     else
     {
+        if((albuf->MappedAccess&AL_MAP_WRITE_BIT_SOFT))
+            UpdateDataVersion(albuf);
         albuf->MappedAccess = 0;
         albuf->MappedOffset = 0;
         albuf->MappedSize = 0;
@@ -1061,6 +856,7 @@ START_API_FUNC
          * OpenAL's reading, and hope for the best...
          */
         std::atomic_thread_fence(std::memory_order_seq_cst);
+        UpdateDataVersion(albuf);
     }
 }
 END_API_FUNC
@@ -1105,13 +901,8 @@ START_API_FUNC
         context->setError(AL_INVALID_OPERATION, "Unpacking data into mapped buffer %u", buffer);
     else
     {
-        ALuint num_chans{albuf->channelsFromFmt()};
-        ALuint frame_size{num_chans * albuf->bytesFromFmt()};
-        ALuint byte_align{
-            (albuf->OriginalType == UserFmtIMA4) ? ((align-1)/2 + 4) * num_chans :
-            (albuf->OriginalType == UserFmtMSADPCM) ? ((align-2)/2 + 7) * num_chans :
-            (align * frame_size)
-        };
+        const ALuint byte_align{BlockSizeFromFmt(albuf->mChannels, albuf->mType,
+            albuf->mAmbiOrder, align)};
 
         if UNLIKELY(offset < 0 || length < 0 || static_cast<ALuint>(offset) > albuf->OriginalSize
             || static_cast<ALuint>(length) > albuf->OriginalSize-static_cast<ALuint>(offset))
@@ -1127,22 +918,12 @@ START_API_FUNC
                 length, byte_align, align);
         else
         {
-            /* offset -> byte offset, length -> sample count */
-            size_t byteoff{static_cast<ALuint>(offset)/byte_align * align * frame_size};
-            size_t samplen{static_cast<ALuint>(length)/byte_align * align};
-
-            void *dst = albuf->mData.data() + byteoff;
-            if(usrfmt->type == UserFmtIMA4 && albuf->mType == FmtShort)
-                Convert_int16_ima4(static_cast<int16_t*>(dst), static_cast<const al::byte*>(data),
-                    num_chans, samplen, align);
-            else if(usrfmt->type == UserFmtMSADPCM && albuf->mType == FmtShort)
-                Convert_int16_msadpcm(static_cast<int16_t*>(dst),
-                    static_cast<const al::byte*>(data), num_chans, samplen, align);
-            else
-            {
-                assert(long{usrfmt->type} == long{albuf->mType});
-                memcpy(dst, data, size_t{samplen} * frame_size);
-            }
+            /* Samples are stored in their original format, so the byte range
+             * maps directly onto the storage.
+             */
+            assert(long{usrfmt->type} == long{albuf->mType});
+            memcpy(albuf->mData.data()+offset, data, static_cast<ALuint>(length));
+            UpdateDataVersion(albuf);
         }
     }
 }
@@ -1481,7 +1262,10 @@ START_API_FUNC
         break;
 
     case AL_BITS:
-        *value = static_cast<ALint>(albuf->bytesFromFmt() * 8);
+        if(IsCompressedFmt(albuf->mType))
+            *value = 4;
+        else
+            *value = static_cast<ALint>(albuf->bytesFromFmt() * 8);
         break;
 
     case AL_CHANNELS:
@@ -1489,7 +1273,8 @@ START_API_FUNC
         break;
 
     case AL_SIZE:
-        *value = static_cast<ALint>(albuf->mSampleLen * albuf->frameSizeFromFmt());
+        *value = static_cast<ALint>(albuf->mSampleLen / albuf->mBlockAlign *
+            albuf->blockSizeFromFmt());
         break;
 
     case AL_UNPACK_BLOCK_ALIGNMENT_SOFT:
@@ -2,6 +2,7 @@
 #define AL_BUFFER_H
 
 #include <atomic>
+#include <stdint.h>
 
 #include "AL/al.h"
 
@@ -25,8 +26,8 @@ enum UserFmtType : unsigned char {
     UserFmtAlaw = FmtAlaw,
     UserFmtDouble = FmtDouble,
 
-    UserFmtIMA4 = 128,
-    UserFmtMSADPCM,
+    UserFmtIMA4 = FmtIMA4,
+    UserFmtMSADPCM = FmtMSADPCM,
 };
 enum UserFmtChannels : unsigned char {
     UserFmtMono = FmtMono,
@@ -64,6 +65,9 @@ struct ALbuffer : public BufferStorage {
     ALuint mLoopStart{0u};
     ALuint mLoopEnd{0u};
 
+    /* Updated from a global counter whenever the samples are modified. */
+    uint64_t mDataVersion{0u};
+
     /* Number of times buffer was attached to a source (deletion can only occur when 0) */
     RefCount ref{0u};
 
@@ -30,6 +30,7 @@ enum {
 extern bool DisabledEffects[MAX_EFFECTS];
 
 extern float ReverbBoost;
+extern bool ReverbReducedLateRate;
 
 struct EffectList {
     const char name[16];
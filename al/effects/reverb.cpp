@@ -5,6 +5,7 @@
 
 #include "AL/al.h"
 #include "AL/efx.h"
+#include "alc/inprogext.h"
 
 #include "alc/effects/base.h"
 #include "effects.h"
@@ -30,6 +31,12 @@ void Reverb_setParami(EffectProps *props, ALenum param, int val)
         props->Reverb.DecayHFLimit = val != AL_FALSE;
         break;
 
+    case AL_REVERB_REDUCED_LATE_RATE_SOFT:
+        if(!(val >= AL_FALSE && val <= AL_TRUE))
+            throw effect_exception{AL_INVALID_VALUE, "EAX Reverb reduced late rate out of range"};
+        props->Reverb.ReducedLateRate = val != AL_FALSE;
+        break;
+
     default:
         throw effect_exception{AL_INVALID_ENUM, "Invalid EAX reverb integer property 0x%04x",
             param};
@@ -198,6 +205,10 @@ void Reverb_getParami(const EffectProps *props, ALenum param, int *val)
         *val = props->Reverb.DecayHFLimit;
         break;
 
+    case AL_REVERB_REDUCED_LATE_RATE_SOFT:
+        *val = props->Reverb.ReducedLateRate;
+        break;
+
     default:
         throw effect_exception{AL_INVALID_ENUM, "Invalid EAX reverb integer property 0x%04x",
             param};
@@ -344,6 +355,7 @@ EffectProps genDefaultProps() noexcept
     props.Reverb.LFReference = AL_EAXREVERB_DEFAULT_LFREFERENCE;
     props.Reverb.RoomRolloffFactor = AL_EAXREVERB_DEFAULT_ROOM_ROLLOFF_FACTOR;
     props.Reverb.DecayHFLimit = AL_EAXREVERB_DEFAULT_DECAY_HFLIMIT;
+    props.Reverb.ReducedLateRate = false;
     return props;
 }
 
@@ -358,6 +370,12 @@ void StdReverb_setParami(EffectProps *props, ALenum param, int val)
         props->Reverb.DecayHFLimit = val != AL_FALSE;
         break;
 
+    case AL_REVERB_REDUCED_LATE_RATE_SOFT:
+        if(!(val >= AL_FALSE && val <= AL_TRUE))
+            throw effect_exception{AL_INVALID_VALUE, "Reverb reduced late rate out of range"};
+        props->Reverb.ReducedLateRate = val != AL_FALSE;
+        break;
+
     default:
         throw effect_exception{AL_INVALID_ENUM, "Invalid reverb integer property 0x%04x", param};
     }
@@ -455,6 +473,10 @@ void StdReverb_getParami(const EffectProps *props, ALenum param, int *val)
         *val = props->Reverb.DecayHFLimit;
         break;
 
+    case AL_REVERB_REDUCED_LATE_RATE_SOFT:
+        *val = props->Reverb.ReducedLateRate;
+        break;
+
     default:
         throw effect_exception{AL_INVALID_ENUM, "Invalid reverb integer property 0x%04x", param};
     }
@@ -550,6 +572,7 @@ EffectProps genDefaultStdProps() noexcept
     props.Reverb.LFReference = 250.0f;
     props.Reverb.RoomRolloffFactor = AL_REVERB_DEFAULT_ROOM_ROLLOFF_FACTOR;
     props.Reverb.DecayHFLimit = AL_REVERB_DEFAULT_DECAY_HFLIMIT;
+    props.Reverb.ReducedLateRate = false;
     return props;
 }
 
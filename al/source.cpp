@@ -1475,6 +1475,7 @@ void SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop,
             newlist.back().mSampleLen = buffer->mSampleLen;
             newlist.back().mLoopStart = buffer->mLoopStart;
             newlist.back().mLoopEnd = buffer->mLoopEnd;
+            newlist.back().mBlockAlign = buffer->mBlockAlign;
             newlist.back().mSamples = buffer->mData.data();
             newlist.back().mBuffer = buffer;
             IncrementRef(buffer->ref);
@@ -2578,6 +2579,78 @@ START_API_FUNC
 }
 END_API_FUNC
 
+AL_API void AL_APIENTRY alSourcesParamsSOFT(ALsizei n, const ALuint *sources,
+    const ALfloat *positions, const ALfloat *velocities, const ALfloat *gains)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if UNLIKELY(!context) return;
+
+    if UNLIKELY(n < 0)
+        context->setError(AL_INVALID_VALUE, "Updating %d sources", n);
+    if UNLIKELY(n <= 0) return;
+    if UNLIKELY(!sources)
+    {
+        context->setError(AL_INVALID_VALUE, "NULL pointer");
+        return;
+    }
+
+    const auto count = static_cast<ALuint>(n);
+    std::lock_guard<std::mutex> _{context->mPropLock};
+    std::lock_guard<std::mutex> __{context->mSourceLock};
+
+    /* Check everything first, so an error leaves all the sources unchanged. */
+    auto is_finite3 = [](const ALfloat *vals) noexcept -> bool
+    { return std::isfinite(vals[0]) && std::isfinite(vals[1]) && std::isfinite(vals[2]); };
+    for(ALuint i{0};i < count;++i)
+    {
+        if UNLIKELY(!LookupSource(context.get(), sources[i]))
+        {
+            context->setError(AL_INVALID_NAME, "Invalid source ID %u", sources[i]);
+            return;
+        }
+        if UNLIKELY((positions && !is_finite3(positions + i*3))
+            || (velocities && !is_finite3(velocities + i*3))
+            || (gains && !(gains[i] >= 0.0f)))
+        {
+            context->setError(AL_INVALID_VALUE, "Value out of range for source %u", sources[i]);
+            return;
+        }
+    }
+
+    /* Unless updates are deferred, hold the mixer from applying updates until
+     * they're all provided, so they happen at once.
+     */
+    const bool hold_updates{!context->mDeferUpdates};
+    if(hold_updates)
+    {
+        context->mHoldUpdates.store(true, std::memory_order_release);
+        while((context->mUpdateCount.load(std::memory_order_acquire)&1) != 0) {
+            /* busy-wait */
+        }
+    }
+
+    for(ALuint i{0};i < count;++i)
+    {
+        ALsource *source{LookupSource(context.get(), sources[i])};
+        if(positions)
+            std::copy_n(positions + i*3, 3, source->Position.begin());
+        if(velocities)
+            std::copy_n(velocities + i*3, 3, source->Velocity.begin());
+        if(gains)
+            source->Gain = gains[i];
+
+        if(positions || velocities)
+            CommitAndUpdateSourceProps(source, context.get());
+        else
+            UpdateSourceProps(source, context.get());
+    }
+
+    if(hold_updates)
+        context->mHoldUpdates.store(false, std::memory_order_release);
+}
+END_API_FUNC
+
 
 AL_API void AL_APIENTRY alSourcedSOFT(ALuint source, ALenum param, ALdouble value)
 START_API_FUNC
@@ -3469,6 +3542,7 @@ START_API_FUNC
         if(!buffer) continue;
         BufferList->mSampleLen = buffer->mSampleLen;
         BufferList->mLoopEnd = buffer->mSampleLen;
+        BufferList->mBlockAlign = buffer->mBlockAlign;
         BufferList->mSamples = buffer->mData.data();
         BufferList->mBuffer = buffer;
         IncrementRef(buffer->ref);
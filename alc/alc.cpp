@@ -86,7 +86,9 @@
 #include "core/effectslot.h"
 #include "core/except.h"
 #include "core/helpers.h"
+#include "core/hrtf.h"
 #include "core/mastering.h"
+#include "core/mixer_pool.h"
 #include "core/mixer/hrtfdefs.h"
 #include "core/fpu_ctrl.h"
 #include "core/front_stablizer.h"
@@ -452,6 +454,8 @@ const struct {
     DECL(alAuxiliaryEffectSlotPlayvSOFT),
     DECL(alAuxiliaryEffectSlotStopSOFT),
     DECL(alAuxiliaryEffectSlotStopvSOFT),
+
+    DECL(alSourcesParamsSOFT),
 #ifdef ALSOFT_EAX
 }, eaxFunctions[] = {
     DECL(EAXGet),
@@ -536,6 +540,14 @@ constexpr struct {
 
     DECL(ALC_OUTPUT_LIMITER_SOFT),
 
+    DECL(ALC_MIXER_THREADS_SOFT),
+    DECL(ALC_MIXER_DETAIL_LEVEL_SOFT),
+    DECL(ALC_FULL_DETAIL_VOICES_SOFT),
+    DECL(ALC_REDUCED_RESAMPLER_VOICES_SOFT),
+    DECL(ALC_REDUCED_SPATIAL_VOICES_SOFT),
+    DECL(ALC_HRTF_COEFF_CACHE_HITS_SOFT),
+    DECL(ALC_HRTF_COEFF_CACHE_MISSES_SOFT),
+
     DECL(ALC_OUTPUT_MODE_SOFT),
     DECL(ALC_ANY_SOFT),
     DECL(ALC_STEREO_BASIC_SOFT),
@@ -966,6 +978,9 @@ constexpr ALCchar alcExtensionList[] =
     "ALC_SOFT_HRTF "
     "ALC_SOFT_loopback "
     "ALC_SOFT_loopback_bformat "
+    "ALC_SOFTX_hrtf_coeff_cache "
+    "ALC_SOFTX_mixer_budget "
+    "ALC_SOFTX_mixer_threads "
     "ALC_SOFT_output_limiter "
     "ALC_SOFT_output_mode "
     "ALC_SOFT_pause_device "
@@ -1063,6 +1078,9 @@ void alc_initconfig(void)
 #elif defined(HAVE_SSE)
     capfilter |= CPU_CAP_SSE;
 #endif
+#ifdef HAVE_AVX2
+    capfilter |= CPU_CAP_AVX2;
+#endif
 #ifdef HAVE_NEON
     capfilter |= CPU_CAP_NEON;
 #endif
@@ -1094,6 +1112,8 @@ void alc_initconfig(void)
                     capfilter &= ~CPU_CAP_SSE3;
                 else if(len == 6 && al::strncasecmp(str, "sse4.1", len) == 0)
                     capfilter &= ~CPU_CAP_SSE4_1;
+                else if(len == 4 && al::strncasecmp(str, "avx2", len) == 0)
+                    capfilter &= ~CPU_CAP_AVX2;
                 else if(len == 4 && al::strncasecmp(str, "neon", len) == 0)
                     capfilter &= ~CPU_CAP_NEON;
                 else
@@ -1109,11 +1129,12 @@ void alc_initconfig(void)
             TRACE("Name: \"%s\"\n", cpuopt->mName.c_str());
         }
         const int caps{cpuopt->mCaps};
-        TRACE("Extensions:%s%s%s%s%s%s\n",
+        TRACE("Extensions:%s%s%s%s%s%s%s\n",
             ((capfilter&CPU_CAP_SSE)    ? ((caps&CPU_CAP_SSE)    ? " +SSE"    : " -SSE")    : ""),
             ((capfilter&CPU_CAP_SSE2)   ? ((caps&CPU_CAP_SSE2)   ? " +SSE2"   : " -SSE2")   : ""),
             ((capfilter&CPU_CAP_SSE3)   ? ((caps&CPU_CAP_SSE3)   ? " +SSE3"   : " -SSE3")   : ""),
             ((capfilter&CPU_CAP_SSE4_1) ? ((caps&CPU_CAP_SSE4_1) ? " +SSE4.1" : " -SSE4.1") : ""),
+            ((capfilter&CPU_CAP_AVX2)   ? ((caps&CPU_CAP_AVX2)   ? " +AVX2"   : " -AVX2")   : ""),
             ((capfilter&CPU_CAP_NEON)   ? ((caps&CPU_CAP_NEON)   ? " +NEON"   : " -NEON")   : ""),
             ((!capfilter) ? " -none-" : ""));
         CPUCapFlags = caps & capfilter;
@@ -1172,6 +1193,8 @@ void alc_initconfig(void)
         const float valf{std::isfinite(*boostopt) ? clampf(*boostopt, -24.0f, 24.0f) : 0.0f};
         ReverbBoost *= std::pow(10.0f, valf / 20.0f);
     }
+    if(auto lateopt = ConfigValueBool(nullptr, "reverb", "reduced-late-rate"))
+        ReverbReducedLateRate = *lateopt;
 
     auto BackendListEnd = std::end(BackendList);
     auto devopt = al::getenv("ALSOFT_DRIVERS");
@@ -1599,6 +1622,7 @@ ALCenum UpdateDeviceParams(ALCdevice *device, const int *attrList)
 
     al::optional<StereoEncoding> stereomode{};
     al::optional<bool> optlimit{};
+    al::optional<uint> optthreads{};
     int hrtf_id{-1};
 
     // Check for attributes
@@ -1690,6 +1714,11 @@ ALCenum UpdateDeviceParams(ALCdevice *device, const int *attrList)
                 outmode = attrList[attrIdx + 1];
                 break;
 
+            case ATTRIBUTE(ALC_MIXER_THREADS_SOFT)
+                if(attrList[attrIdx + 1] >= 0)
+                    optthreads = static_cast<uint>(attrList[attrIdx + 1]);
+                break;
+
             default:
                 TRACE("0x%04X = %d (0x%x)\n", attrList[attrIdx],
                     attrList[attrIdx + 1], attrList[attrIdx + 1]);
@@ -1845,6 +1874,11 @@ ALCenum UpdateDeviceParams(ALCdevice *device, const int *attrList)
     if(device->Flags.test(DeviceRunning))
         return ALC_NO_ERROR;
 
+    /* Stop any HRTF still loading for a previous reset. */
+    device->stopHrtfLoader();
+    device->mPendingHrtf.store(nullptr, std::memory_order_relaxed);
+    device->mHrtfRenderer = nullptr;
+
     device->AvgSpeakerDist = 0.0f;
     device->mNFCtrlFilter = NfcFilter{};
     device->mUhjEncoder = nullptr;
@@ -1853,6 +1887,7 @@ ALCenum UpdateDeviceParams(ALCdevice *device, const int *attrList)
     device->PostProcess = nullptr;
 
     device->Limiter = nullptr;
+    device->mMixerWorkers = nullptr;
     device->ChannelDelays = nullptr;
 
     std::fill(std::begin(device->HrtfAccumData), std::end(device->HrtfAccumData), float2{});
@@ -2200,6 +2235,56 @@ ALCenum UpdateDeviceParams(ALCdevice *device, const int *attrList)
         TRACE("Output limiter enabled, %.4fdB limit\n", thrshld_dB);
     }
 
+    if(device->getConfigValueBool(nullptr, "virtual-voices", true))
+        device->Flags.set(VirtualVoices);
+    else
+        device->Flags.reset(VirtualVoices);
+
+    device->mMixBudget = 0.0f;
+    if(auto budgetopt = device->configValue<float>(nullptr, "mixer-budget"))
+    {
+        if(*budgetopt > 0.0f)
+            device->mMixBudget = minf(*budgetopt, 1.0f);
+    }
+    device->mMixLoad = 0.0f;
+    device->mOverBudgetCount = 0;
+    device->mUnderBudgetCount = 0;
+    device->mDetailLevel.store(0, std::memory_order_relaxed);
+    for(auto &count : device->mDetailTierCounts)
+        count.store(0, std::memory_order_relaxed);
+    device->mHrtfCacheStats.mHits.store(0u, std::memory_order_relaxed);
+    device->mHrtfCacheStats.mMisses.store(0u, std::memory_order_relaxed);
+    if(device->mMixBudget > 0.0f)
+        TRACE("Mixer time budget: %.0f%% of the update period\n", device->mMixBudget*100.0f);
+
+    if(auto threadsopt = device->configValue<uint>(nullptr, "mixer-threads"))
+        optthreads = threadsopt;
+
+    /* The mixer thread counts as one of the requested threads, so extra
+     * workers are only needed for more than one.
+     */
+    const uint numthreads{minu(optthreads.value_or(0u), MaxMixerThreads)};
+    if(numthreads < 2)
+        TRACE("Parallel voice mixing disabled\n");
+    else
+    {
+        const size_t numlines{device->Dry.Buffer.size()
+            + ((device->RealOut.Buffer.data() != device->Dry.Buffer.data())
+                ? device->RealOut.Buffer.size() : 0u)
+            + MaxWorkerSlotBuses*AmbiChannelsFromOrder(device->mAmbiOrder)};
+        try {
+            auto workers = std::make_unique<MixerWorkerPool>(numthreads-1, numlines);
+            if(workers->size() > 0)
+            {
+                TRACE("Parallel voice mixing enabled, %zu threads\n", workers->size()+1);
+                device->mMixerWorkers = std::move(workers);
+            }
+        }
+        catch(std::exception &e) {
+            ERR("Failed to create mixer worker pool: %s\n", e.what());
+        }
+    }
+
     /* Convert the sample delay from samples to nanosamples to nanoseconds. */
     device->FixedLatency += nanoseconds{seconds{sample_delay}} / device->Frequency;
     TRACE("Fixed device latency: %" PRId64 "ns\n", int64_t{device->FixedLatency.count()});
@@ -2212,7 +2297,7 @@ ALCenum UpdateDeviceParams(ALCdevice *device, const int *attrList)
         auto GetEffectBuffer = [](ALbuffer *buffer) noexcept -> EffectState::Buffer
         {
             if(!buffer) return EffectState::Buffer{};
-            return EffectState::Buffer{buffer, buffer->mData};
+            return EffectState::Buffer{buffer, buffer->mData, buffer->mDataVersion};
         };
         std::unique_lock<std::mutex> proplock{context->mPropLock};
         std::unique_lock<std::mutex> slotlock{context->mEffectSlotLock};
@@ -2606,6 +2691,16 @@ START_API_FUNC
 END_API_FUNC
 
 
+/* Returns the number of threads voices are mixed with, including the mixer
+ * thread.
+ */
+static int GetMixerThreadCount(ALCdevice *device) noexcept
+{
+    if(MixerWorkerPool *workers{device->mMixerWorkers.get()})
+        return static_cast<int>(workers->size() + 1);
+    return 1;
+}
+
 static size_t GetIntegerv(ALCdevice *device, ALCenum param, const al::span<int> values)
 {
     size_t i;
@@ -2651,6 +2746,13 @@ static size_t GetIntegerv(ALCdevice *device, ALCenum param, const al::span<int>
         case ALC_AMBISONIC_SCALING_SOFT:
         case ALC_AMBISONIC_ORDER_SOFT:
         case ALC_MAX_AMBISONIC_ORDER_SOFT:
+        case ALC_MIXER_THREADS_SOFT:
+        case ALC_MIXER_DETAIL_LEVEL_SOFT:
+        case ALC_FULL_DETAIL_VOICES_SOFT:
+        case ALC_REDUCED_RESAMPLER_VOICES_SOFT:
+        case ALC_REDUCED_SPATIAL_VOICES_SOFT:
+        case ALC_HRTF_COEFF_CACHE_HITS_SOFT:
+        case ALC_HRTF_COEFF_CACHE_MISSES_SOFT:
             alcSetError(nullptr, ALC_INVALID_DEVICE);
             return 0;
 
@@ -2713,8 +2815,8 @@ static size_t GetIntegerv(ALCdevice *device, ALCenum param, const al::span<int>
     auto NumAttrsForDevice = [](ALCdevice *aldev) noexcept
     {
         if(aldev->Type == DeviceType::Loopback && aldev->FmtChans == DevFmtAmbi3D)
-            return 37;
-        return 31;
+            return 39;
+        return 33;
     };
     switch(param)
     {
@@ -2792,6 +2894,9 @@ static size_t GetIntegerv(ALCdevice *device, ALCenum param, const al::span<int>
             values[i++] = ALC_OUTPUT_MODE_SOFT;
             values[i++] = static_cast<ALCenum>(device->getOutputMode1());
 
+            values[i++] = ALC_MIXER_THREADS_SOFT;
+            values[i++] = GetMixerThreadCount(device);
+
             values[i++] = 0;
         }
         return i;
@@ -2913,6 +3018,39 @@ static size_t GetIntegerv(ALCdevice *device, ALCenum param, const al::span<int>
         values[0] = device->Limiter ? ALC_TRUE : ALC_FALSE;
         return 1;
 
+    case ALC_MIXER_THREADS_SOFT:
+        values[0] = GetMixerThreadCount(device);
+        return 1;
+
+    case ALC_MIXER_DETAIL_LEVEL_SOFT:
+        values[0] = static_cast<int>(device->mDetailLevel.load(std::memory_order_relaxed));
+        return 1;
+
+    case ALC_FULL_DETAIL_VOICES_SOFT:
+        values[0] = static_cast<int>(
+            device->mDetailTierCounts[DetailFull].load(std::memory_order_relaxed));
+        return 1;
+
+    case ALC_REDUCED_RESAMPLER_VOICES_SOFT:
+        values[0] = static_cast<int>(
+            device->mDetailTierCounts[DetailReducedResampler].load(std::memory_order_relaxed));
+        return 1;
+
+    case ALC_REDUCED_SPATIAL_VOICES_SOFT:
+        values[0] = static_cast<int>(
+            device->mDetailTierCounts[DetailReducedSpatial].load(std::memory_order_relaxed));
+        return 1;
+
+    case ALC_HRTF_COEFF_CACHE_HITS_SOFT:
+        values[0] = static_cast<int>(minu(device->mHrtfCacheStats.mHits.load(
+            std::memory_order_relaxed), std::numeric_limits<int>::max()));
+        return 1;
+
+    case ALC_HRTF_COEFF_CACHE_MISSES_SOFT:
+        values[0] = static_cast<int>(minu(device->mHrtfCacheStats.mMisses.load(
+            std::memory_order_relaxed), std::numeric_limits<int>::max()));
+        return 1;
+
     case ALC_MAX_AMBISONIC_ORDER_SOFT:
         values[0] = MaxAmbiOrder;
         return 1;
@@ -2958,8 +3096,8 @@ START_API_FUNC
     auto NumAttrsForDevice = [](ALCdevice *aldev) noexcept
     {
         if(aldev->Type == DeviceType::Loopback && aldev->FmtChans == DevFmtAmbi3D)
-            return 41;
-        return 35;
+            return 43;
+        return 37;
     };
     std::lock_guard<std::mutex> _{dev->StateLock};
     switch(pname)
@@ -3034,6 +3172,9 @@ START_API_FUNC
             values[i++] = ALC_OUTPUT_MODE_SOFT;
             values[i++] = static_cast<ALCenum>(device->getOutputMode1());
 
+            values[i++] = ALC_MIXER_THREADS_SOFT;
+            values[i++] = GetMixerThreadCount(device);
+
             values[i++] = 0;
         }
         break;
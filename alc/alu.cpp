@@ -39,6 +39,10 @@
 #include <stdint.h>
 #include <utility>
 
+#ifdef HAVE_SSE_INTRINSICS
+#include <xmmintrin.h>
+#endif
+
 #include "almalloc.h"
 #include "alnumbers.h"
 #include "alnumeric.h"
@@ -67,6 +71,7 @@
 #include "core/mixer.h"
 #include "core/mixer/defs.h"
 #include "core/mixer/hrtfdefs.h"
+#include "core/mixer_pool.h"
 #include "core/resampler_limits.h"
 #include "core/uhjfilter.h"
 #include "core/voice.h"
@@ -89,6 +94,9 @@ struct SSE2Tag;
 #ifdef HAVE_SSE4_1
 struct SSE4Tag;
 #endif
+#ifdef HAVE_AVX2
+struct AVX2Tag;
+#endif
 #ifdef HAVE_NEON
 struct NEONTag;
 #endif
@@ -154,6 +162,10 @@ inline HrtfDirectMixerFunc SelectHrtfMixer(void)
     if((CPUCapFlags&CPU_CAP_NEON))
         return MixDirectHrtf_<NEONTag>;
 #endif
+#ifdef HAVE_AVX2
+    if((CPUCapFlags&CPU_CAP_AVX2))
+        return MixDirectHrtf_<AVX2Tag>;
+#endif
 #ifdef HAVE_SSE
     if((CPUCapFlags&CPU_CAP_SSE))
         return MixDirectHrtf_<SSETag>;
@@ -191,8 +203,16 @@ inline ResamplerFunc SelectResampler(Resampler resampler, uint increment)
     switch(resampler)
     {
     case Resampler::Point:
+#ifdef HAVE_AVX2
+        if((CPUCapFlags&CPU_CAP_AVX2))
+            return Resample_<PointTag,AVX2Tag>;
+#endif
         return Resample_<PointTag,CTag>;
     case Resampler::Linear:
+#ifdef HAVE_AVX2
+        if((CPUCapFlags&CPU_CAP_AVX2))
+            return Resample_<LerpTag,AVX2Tag>;
+#endif
 #ifdef HAVE_NEON
         if((CPUCapFlags&CPU_CAP_NEON))
             return Resample_<LerpTag,NEONTag>;
@@ -207,11 +227,19 @@ inline ResamplerFunc SelectResampler(Resampler resampler, uint increment)
 #endif
         return Resample_<LerpTag,CTag>;
     case Resampler::Cubic:
+#ifdef HAVE_AVX2
+        if((CPUCapFlags&CPU_CAP_AVX2))
+            return Resample_<CubicTag,AVX2Tag>;
+#endif
         return Resample_<CubicTag,CTag>;
     case Resampler::BSinc12:
     case Resampler::BSinc24:
         if(increment > MixerFracOne)
         {
+#ifdef HAVE_AVX2
+            if((CPUCapFlags&CPU_CAP_AVX2))
+                return Resample_<BSincTag,AVX2Tag>;
+#endif
 #ifdef HAVE_NEON
             if((CPUCapFlags&CPU_CAP_NEON))
                 return Resample_<BSincTag,NEONTag>;
@@ -225,6 +253,10 @@ inline ResamplerFunc SelectResampler(Resampler resampler, uint increment)
         /* fall-through */
     case Resampler::FastBSinc12:
     case Resampler::FastBSinc24:
+#ifdef HAVE_AVX2
+        if((CPUCapFlags&CPU_CAP_AVX2))
+            return Resample_<FastBSincTag,AVX2Tag>;
+#endif
 #ifdef HAVE_NEON
         if((CPUCapFlags&CPU_CAP_NEON))
             return Resample_<FastBSincTag,NEONTag>;
@@ -281,6 +313,40 @@ void DeviceBase::ProcessHrtf(const size_t SamplesToDo)
         mHrtfState->mTemp.data(), mHrtfState->mChannels.data(), mHrtfState->mIrSize, SamplesToDo);
 }
 
+void DeviceBase::ProcessHrtfFade(const size_t SamplesToDo)
+{
+    /* Crossfade from the stereo decode to HRTF over this update, then use
+     * HRTF by itself.
+     */
+    const uint lidx{RealOut.ChannelIndex[FrontLeft]};
+    const uint ridx{RealOut.ChannelIndex[FrontRight]};
+    auto &fadebuf = mHrtfRenderer->mFadeBuffer;
+    const float delta{1.0f / static_cast<float>(SamplesToDo)};
+    auto mix_faded = [this,&fadebuf,SamplesToDo,delta](const uint idx, const float start,
+        const float step)
+    {
+        const float *src{fadebuf[idx].data()};
+        float *dst{RealOut.Buffer[idx].data()};
+        for(size_t i{0};i < SamplesToDo;++i)
+            dst[i] += src[i] * (start + step*static_cast<float>(i)*delta);
+    };
+
+    for(auto &buffer : fadebuf)
+        std::fill_n(buffer.begin(), SamplesToDo, 0.0f);
+    AmbiDecoder->process(fadebuf, Dry.Buffer.data(), SamplesToDo);
+    mix_faded(lidx, 1.0f, -1.0f);
+    mix_faded(ridx, 1.0f, -1.0f);
+
+    for(auto &buffer : fadebuf)
+        std::fill_n(buffer.begin(), SamplesToDo, 0.0f);
+    MixDirectHrtf(fadebuf[lidx], fadebuf[ridx], Dry.Buffer, HrtfAccumData,
+        mHrtfState->mTemp.data(), mHrtfState->mChannels.data(), mHrtfState->mIrSize, SamplesToDo);
+    mix_faded(lidx, 0.0f, 1.0f);
+    mix_faded(ridx, 0.0f, 1.0f);
+
+    PostProcess = &DeviceBase::ProcessHrtf;
+}
+
 void DeviceBase::ProcessAmbiDec(const size_t SamplesToDo)
 {
     AmbiDecoder->process(RealOut.Buffer, Dry.Buffer.data(), SamplesToDo);
@@ -763,7 +829,20 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
         break;
     }
 
+    const al::span<FloatBufferLine> prev_buffer{voice->mDirect.Buffer};
+    const bool had_hrtf{voice->mFlags.test(VoiceHasHrtf)};
+    const bool had_nfc{voice->mFlags.test(VoiceHasNfc)};
     voice->mFlags.reset(VoiceHasHrtf).reset(VoiceHasNfc);
+    voice->mDirect.Buffer = Device->Dry.Buffer;
+    /* Voices started before near-field control was set up for a background
+     * loaded HRTF need their filters reset for it.
+     */
+    if(Device->AvgSpeakerDist > 0.0f && !had_nfc)
+    {
+        for(auto &chandata : voice->mChans)
+            chandata.mDryParams.NFCtrlFilter = Device->mNFCtrlFilter;
+    }
+    voice->mHrtfPriority = 0.0f;
     if(auto *decoder{voice->mDecoder.get()})
         decoder->mWidthControl = minf(props->EnhWidth, 0.7f);
 
@@ -948,12 +1027,14 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
             }
         }
     }
-    else if(Device->mRenderMode == RenderMode::Hrtf)
+    else if(Device->mRenderMode == RenderMode::Hrtf && voice->mDetailTier != DetailReducedSpatial
+        && !(Device->mHrtfDirectVoices > 0 && voice->mFlags.test(VoiceHrtfPanned)))
     {
         /* Full HRTF rendering. Skip the virtual channels and render to the
          * real outputs.
          */
         voice->mDirect.Buffer = Device->RealOut.Buffer;
+        voice->mHrtfPriority = DryGain.Base;
 
         if(Distance > std::numeric_limits<float>::epsilon())
         {
@@ -965,7 +1046,7 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
              */
             GetHrtfCoeffs(Device->mHrtf.get(), ev, az, Distance, Spread,
                 voice->mChans[0].mDryParams.Hrtf.Target.Coeffs,
-                voice->mChans[0].mDryParams.Hrtf.Target.Delay);
+                voice->mChans[0].mDryParams.Hrtf.Target.Delay, Device->mHrtfCacheStats);
             voice->mChans[0].mDryParams.Hrtf.Target.Gain = DryGain.Base;
 
             /* Remaining channels use the same results as the first. */
@@ -1012,7 +1093,7 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
                 GetHrtfCoeffs(Device->mHrtf.get(), chans[c].elevation, chans[c].angle,
                     std::numeric_limits<float>::infinity(), Spread,
                     voice->mChans[c].mDryParams.Hrtf.Target.Coeffs,
-                    voice->mChans[c].mDryParams.Hrtf.Target.Delay);
+                    voice->mChans[c].mDryParams.Hrtf.Target.Delay, Device->mHrtfCacheStats);
                 voice->mChans[c].mDryParams.Hrtf.Target.Gain = DryGain.Base;
 
                 /* Normal panning for auxiliary sends. */
@@ -1032,6 +1113,8 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
     else
     {
         /* Non-HRTF rendering. Use normal panning to the output. */
+        if(Device->mRenderMode == RenderMode::Hrtf)
+            voice->mHrtfPriority = DryGain.Base;
 
         if(Distance > std::numeric_limits<float>::epsilon())
         {
@@ -1132,6 +1215,34 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
         }
     }
 
+    if(voice->mFlags.test(VoiceIsFading) && voice->mFlags.test(VoiceHasHrtf) != had_hrtf)
+    {
+        if(voice->mFlags.test(VoiceSwitchingHrtf))
+        {
+            /* Switched back before the previous switch was mixed, so the
+             * previous path's parameters are still intact.
+             */
+            voice->mFlags.reset(VoiceSwitchingHrtf);
+        }
+        else
+        {
+            /* The voice switched between HRTF and panning while playing, from
+             * a change in its level of detail or importance. The previous path
+             * fades out as the new path fades in from silence.
+             */
+            voice->mPrevDirectBuffer = prev_buffer;
+            voice->mFlags.set(VoiceSwitchingHrtf).set(VoiceHadNfc, had_nfc);
+            for(auto &chandata : voice->mChans)
+            {
+                /* The HRTF history is kept current while panned. */
+                if(had_hrtf)
+                    chandata.mDryParams.Gains.Current.fill(0.0f);
+                else
+                    chandata.mDryParams.Hrtf.Old = HrtfFilter{};
+            }
+        }
+    }
+
     {
         const float hfNorm{props->Direct.HFReference / Frequency};
         const float lfNorm{props->Direct.LFReference / Frequency};
@@ -1171,12 +1282,46 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
     }
 }
 
+/* Selects the level of detail to mix a voice with, given the context's
+ * current detail level and how loud the voice is. Only quiet voices are
+ * reduced until the highest level, which reduces the resampler for all voices.
+ */
+uint CalcVoiceDetailTier(const uint level, const GainTriplet &DryGain,
+    const al::span<const GainTriplet,MAX_SENDS> WetGain, EffectSlot *(&SendSlots)[MAX_SENDS],
+    const DeviceBase *Device)
+{
+    /* Voices below -12dB are considered quiet. */
+    static constexpr float QuietVoiceGain{0.25f};
+
+    if(level == 0)
+        return DetailFull;
+
+    float gain{DryGain.Base};
+    for(uint i{0};i < Device->NumAuxSends;i++)
+    {
+        if(SendSlots[i])
+            gain = maxf(gain, WetGain[i].Base);
+    }
+
+    /* Spatialization can only be reduced when it would use direct HRTF. */
+    if(gain < QuietVoiceGain)
+        return (level > 1 && Device->mRenderMode == RenderMode::Hrtf) ? DetailReducedSpatial
+            : DetailReducedResampler;
+    return (level > 2) ? DetailReducedResampler : DetailFull;
+}
+
+inline Resampler GetDetailResampler(const Resampler resampler, const uint tier) noexcept
+{
+    if(tier != DetailFull && resampler > Resampler::Linear)
+        return Resampler::Linear;
+    return resampler;
+}
+
 void CalcNonAttnSourceParams(Voice *voice, const VoiceProps *props, const ContextBase *context)
 {
     const DeviceBase *Device{context->mDevice};
     EffectSlot *SendSlots[MAX_SENDS];
 
-    voice->mDirect.Buffer = Device->Dry.Buffer;
     for(uint i{0};i < Device->NumAuxSends;i++)
     {
         SendSlots[i] = props->Send[i].Slot;
@@ -1187,6 +1332,7 @@ void CalcNonAttnSourceParams(Voice *voice, const VoiceProps *props, const Contex
         }
         else
             voice->mSend[i].Buffer = SendSlots[i]->Wet.Buffer;
+        voice->mSend[i].Slot = SendSlots[i];
     }
 
     /* Calculate the stepping value */
@@ -1196,7 +1342,6 @@ void CalcNonAttnSourceParams(Voice *voice, const VoiceProps *props, const Contex
         voice->mStep = MaxPitch<<MixerFracBits;
     else
         voice->mStep = maxu(fastf2u(Pitch * MixerFracOne), 1);
-    voice->mResampler = PrepareResampler(props->mResampler, voice->mStep, &voice->mResampleState);
 
     /* Calculate gains */
     GainTriplet DryGain;
@@ -1213,142 +1358,437 @@ void CalcNonAttnSourceParams(Voice *voice, const VoiceProps *props, const Contex
         WetGain[i].LF = props->Send[i].GainLF;
     }
 
+    voice->mDetailTier = CalcVoiceDetailTier(context->mDetailLevel, DryGain, WetGain, SendSlots,
+        Device);
+    voice->mResampler = PrepareResampler(GetDetailResampler(props->mResampler,
+        voice->mDetailTier), voice->mStep, &voice->mResampleState);
+
     CalcPanningAndFilters(voice, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, DryGain, WetGain, SendSlots, props,
         context->mParams, Device);
 }
 
-void CalcAttnSourceParams(Voice *voice, const VoiceProps *props, const ContextBase *context)
-{
-    const DeviceBase *Device{context->mDevice};
-    const uint NumSends{Device->NumAuxSends};
+/* Attenuated sources are updated in batches of up to this many voices. The
+ * listener-space geometry, distance attenuation, cone, and doppler pitch for
+ * a batch are calculated together before each voice's panning and filters.
+ */
+constexpr size_t AttnBatchSize{16};
 
-    /* Set mixing buffers and get send parameters. */
-    voice->mDirect.Buffer = Device->Dry.Buffer;
-    EffectSlot *SendSlots[MAX_SENDS];
-    uint UseDryAttnForRoom{0};
-    for(uint i{0};i < NumSends;i++)
+enum AttnModel : uint {
+    AttnNone,
+    AttnInverse,
+    AttnLinear,
+    AttnExponent
+};
+
+/* Source properties and results for a batch of attenuated voices, stored as
+ * separate arrays so they can be processed four voices at a time. Unused
+ * lanes past Count are padded out to a multiple of four, and are calculated
+ * but otherwise ignored.
+ */
+struct AttnBatch {
+    size_t Count{0};
+    std::array<Voice*,AttnBatchSize> Voices;
+
+    /* Source-relative inputs, which become the normalized listener-space
+     * results.
+     */
+    alignas(16) std::array<float,AttnBatchSize> PosX, PosY, PosZ;
+    alignas(16) std::array<float,AttnBatchSize> VelX, VelY, VelZ;
+    alignas(16) std::array<float,AttnBatchSize> DirX, DirY, DirZ;
+    alignas(16) std::array<float,AttnBatchSize> HeadRelative;
+
+    /* Distance model inputs. ClampMin and ClampMax are -inf and +inf for the
+     * unclamped models.
+     */
+    alignas(16) std::array<float,AttnBatchSize> Model;
+    alignas(16) std::array<float,AttnBatchSize> RefDist, MaxDist, ClampMin, ClampMax;
+    alignas(16) std::array<float,AttnBatchSize> Rolloff, RoomRolloff;
+    alignas(16) std::array<float,AttnBatchSize> Doppler;
+
+    /* Outputs. DryGain, WetGain, and Pitch start as the source's gain and
+     * pitch.
+     */
+    alignas(16) std::array<float,AttnBatchSize> Distance, ClampedDist;
+    alignas(16) std::array<float,AttnBatchSize> DirLength, ConeDot;
+    alignas(16) std::array<float,AttnBatchSize> DryGain, WetGain, Pitch;
+    alignas(16) std::array<float,AttnBatchSize> ConeHF, WetConeHF;
+};
+
+void AttnBatchAddVoice(AttnBatch &batch, Voice *voice, const ContextBase *context)
+{
+    const VoiceProps *props{&voice->mProps};
+    const size_t idx{batch.Count++};
+    batch.Voices[idx] = voice;
+
+    batch.PosX[idx] = props->Position[0];
+    batch.PosY[idx] = props->Position[1];
+    batch.PosZ[idx] = props->Position[2];
+    batch.VelX[idx] = props->Velocity[0];
+    batch.VelY[idx] = props->Velocity[1];
+    batch.VelZ[idx] = props->Velocity[2];
+    batch.DirX[idx] = props->Direction[0];
+    batch.DirY[idx] = props->Direction[1];
+    batch.DirZ[idx] = props->Direction[2];
+    batch.HeadRelative[idx] = props->HeadRelative ? 1.0f : 0.0f;
+
+    /* Resolve the distance model to the attenuation function to apply, if
+     * any. The clamped models don't attenuate when the max distance is less
+     * than the reference distance.
+     */
+    static constexpr float inf{std::numeric_limits<float>::infinity()};
+    AttnModel model{AttnNone};
+    float clampmin{-inf}, clampmax{inf};
+    switch(context->mParams.SourceDistanceModel ? props->mDistanceModel
+        : context->mParams.mDistanceModel)
     {
-        SendSlots[i] = props->Send[i].Slot;
-        if(!SendSlots[i] || SendSlots[i]->EffectType == EffectSlotType::None)
-            SendSlots[i] = nullptr;
-        else if(!SendSlots[i]->AuxSendAuto)
-        {
-            /* If the slot's auxiliary send auto is off, the data sent to the
-             * effect slot is the same as the dry path, sans filter effects.
-             */
-            UseDryAttnForRoom |= 1u<<i;
-        }
+    case DistanceModel::InverseClamped:
+        if(props->MaxDistance < props->RefDistance) break;
+        clampmin = props->RefDistance;
+        clampmax = props->MaxDistance;
+        /*fall-through*/
+    case DistanceModel::Inverse:
+        if(props->RefDistance > 0.0f)
+            model = AttnInverse;
+        break;
 
-        if(!SendSlots[i])
-            voice->mSend[i].Buffer = {};
-        else
-            voice->mSend[i].Buffer = SendSlots[i]->Wet.Buffer;
+    case DistanceModel::LinearClamped:
+        if(props->MaxDistance < props->RefDistance) break;
+        clampmin = props->RefDistance;
+        clampmax = props->MaxDistance;
+        /*fall-through*/
+    case DistanceModel::Linear:
+        if(props->MaxDistance != props->RefDistance)
+            model = AttnLinear;
+        break;
+
+    case DistanceModel::ExponentClamped:
+        if(props->MaxDistance < props->RefDistance) break;
+        clampmin = props->RefDistance;
+        clampmax = props->MaxDistance;
+        /*fall-through*/
+    case DistanceModel::Exponent:
+        model = AttnExponent;
+        break;
+
+    case DistanceModel::Disable:
+        break;
     }
+    batch.Model[idx] = static_cast<float>(model);
+    batch.RefDist[idx] = props->RefDistance;
+    batch.MaxDist[idx] = props->MaxDistance;
+    batch.ClampMin[idx] = clampmin;
+    batch.ClampMax[idx] = clampmax;
+    batch.Rolloff[idx] = props->RolloffFactor;
+    batch.RoomRolloff[idx] = props->RoomRolloffFactor;
+    batch.Doppler[idx] = props->DopplerFactor * context->mParams.DopplerFactor;
+
+    batch.DryGain[idx] = props->Gain;
+    batch.WetGain[idx] = props->Gain;
+    batch.Pitch[idx] = props->Pitch;
+}
+
+#ifdef HAVE_SSE_INTRINSICS
 
-    /* Transform source to listener space (convert to head relative) */
-    alu::Vector Position{props->Position[0], props->Position[1], props->Position[2], 1.0f};
-    alu::Vector Velocity{props->Velocity[0], props->Velocity[1], props->Velocity[2], 0.0f};
-    alu::Vector Direction{props->Direction[0], props->Direction[1], props->Direction[2], 0.0f};
-    if(!props->HeadRelative)
+/* Transforms a set of vectors by the upper 3x3 of the matrix, the same as
+ * alu::Matrix * alu::Vector with a 0 w component.
+ */
+inline void TransformSSE(const alu::Matrix &mtx, __m128 &x, __m128 &y, __m128 &z) noexcept
+{
+    const __m128 zero{_mm_setzero_ps()};
+    __m128 res[3];
+    for(size_t c{0};c < 3;++c)
     {
-        /* Transform source vectors */
-        Position = context->mParams.Matrix * (Position - context->mParams.Position);
-        Velocity = context->mParams.Matrix * Velocity;
-        Direction = context->mParams.Matrix * Direction;
+        __m128 r{_mm_mul_ps(x, _mm_set1_ps(mtx[0][c]))};
+        r = _mm_add_ps(r, _mm_mul_ps(y, _mm_set1_ps(mtx[1][c])));
+        r = _mm_add_ps(r, _mm_mul_ps(z, _mm_set1_ps(mtx[2][c])));
+        res[c] = _mm_add_ps(r, _mm_mul_ps(zero, _mm_set1_ps(mtx[3][c])));
     }
-    else
+    x = res[0];
+    y = res[1];
+    z = res[2];
+}
+
+/* Normalizes a set of vectors and returns their lengths, the same as
+ * alu::Vector::normalize.
+ */
+inline __m128 NormalizeSSE(__m128 &x, __m128 &y, __m128 &z) noexcept
+{
+    static constexpr float eps{std::numeric_limits<float>::epsilon()};
+    __m128 lensqr{_mm_mul_ps(x, x)};
+    lensqr = _mm_add_ps(lensqr, _mm_mul_ps(y, y));
+    lensqr = _mm_add_ps(lensqr, _mm_mul_ps(z, z));
+
+    const __m128 valid{_mm_cmpgt_ps(lensqr, _mm_set1_ps(eps*eps))};
+    const __m128 length{_mm_sqrt_ps(lensqr)};
+    const __m128 inv_length{_mm_div_ps(_mm_set1_ps(1.0f), length)};
+    x = _mm_and_ps(_mm_mul_ps(x, inv_length), valid);
+    y = _mm_and_ps(_mm_mul_ps(y, inv_length), valid);
+    z = _mm_and_ps(_mm_mul_ps(z, inv_length), valid);
+    return _mm_and_ps(length, valid);
+}
+
+inline __m128 SelectSSE(const __m128 mask, const __m128 a, const __m128 b) noexcept
+{ return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+
+#endif
+
+/* Calculates the listener-space direction and distance, the inverse and
+ * linear distance attenuation, and the doppler-shifted pitch of each voice in
+ * the batch.
+ */
+void CalcAttnBatchGeometry(AttnBatch &batch, const ContextBase *context)
+{
+    const alu::Matrix &mtx = context->mParams.Matrix;
+    const alu::Vector &lpos = context->mParams.Position;
+    const alu::Vector &lvel = context->mParams.Velocity;
+    const float SpeedOfSound{context->mParams.SpeedOfSound};
+
+#ifdef HAVE_SSE_INTRINSICS
+    const __m128 zero{_mm_setzero_ps()};
+    const __m128 one{_mm_set1_ps(1.0f)};
+    const __m128 sos4{_mm_set1_ps(SpeedOfSound)};
+    for(size_t i{0};i < batch.Count;i += 4)
     {
-        /* Offset the source velocity to be relative of the listener velocity */
-        Velocity += context->mParams.Velocity;
+        const __m128 headrel{_mm_cmpneq_ps(_mm_load_ps(&batch.HeadRelative[i]), zero)};
+
+        /* Transform source vectors to listener space, or offset the velocity
+         * of head-relative sources to be relative of the listener velocity.
+         */
+        __m128 px{_mm_sub_ps(_mm_load_ps(&batch.PosX[i]), _mm_set1_ps(lpos[0]))};
+        __m128 py{_mm_sub_ps(_mm_load_ps(&batch.PosY[i]), _mm_set1_ps(lpos[1]))};
+        __m128 pz{_mm_sub_ps(_mm_load_ps(&batch.PosZ[i]), _mm_set1_ps(lpos[2]))};
+        TransformSSE(mtx, px, py, pz);
+        px = SelectSSE(headrel, _mm_load_ps(&batch.PosX[i]), px);
+        py = SelectSSE(headrel, _mm_load_ps(&batch.PosY[i]), py);
+        pz = SelectSSE(headrel, _mm_load_ps(&batch.PosZ[i]), pz);
+
+        __m128 vx{_mm_load_ps(&batch.VelX[i])};
+        __m128 vy{_mm_load_ps(&batch.VelY[i])};
+        __m128 vz{_mm_load_ps(&batch.VelZ[i])};
+        const __m128 hvx{_mm_add_ps(vx, _mm_set1_ps(lvel[0]))};
+        const __m128 hvy{_mm_add_ps(vy, _mm_set1_ps(lvel[1]))};
+        const __m128 hvz{_mm_add_ps(vz, _mm_set1_ps(lvel[2]))};
+        TransformSSE(mtx, vx, vy, vz);
+        vx = SelectSSE(headrel, hvx, vx);
+        vy = SelectSSE(headrel, hvy, vy);
+        vz = SelectSSE(headrel, hvz, vz);
+
+        __m128 dx{_mm_load_ps(&batch.DirX[i])};
+        __m128 dy{_mm_load_ps(&batch.DirY[i])};
+        __m128 dz{_mm_load_ps(&batch.DirZ[i])};
+        const __m128 hdx{dx}, hdy{dy}, hdz{dz};
+        TransformSSE(mtx, dx, dy, dz);
+        dx = SelectSSE(headrel, hdx, dx);
+        dy = SelectSSE(headrel, hdy, dy);
+        dz = SelectSSE(headrel, hdz, dz);
+
+        _mm_store_ps(&batch.DirLength[i], NormalizeSSE(dx, dy, dz));
+        const __m128 dist{NormalizeSSE(px, py, pz)};
+        _mm_store_ps(&batch.PosX[i], px);
+        _mm_store_ps(&batch.PosY[i], py);
+        _mm_store_ps(&batch.PosZ[i], pz);
+        _mm_store_ps(&batch.Distance[i], dist);
+
+        __m128 conedot{_mm_mul_ps(dx, px)};
+        conedot = _mm_add_ps(conedot, _mm_mul_ps(dy, py));
+        conedot = _mm_add_ps(conedot, _mm_mul_ps(dz, pz));
+        _mm_store_ps(&batch.ConeDot[i], _mm_sub_ps(zero, conedot));
+
+        /* Calculate distance attenuation. */
+        const __m128 model{_mm_load_ps(&batch.Model[i])};
+        const __m128 refdist{_mm_load_ps(&batch.RefDist[i])};
+        const __m128 clamped{_mm_min_ps(_mm_max_ps(_mm_load_ps(&batch.ClampMin[i]), dist),
+            _mm_load_ps(&batch.ClampMax[i]))};
+        _mm_store_ps(&batch.ClampedDist[i], clamped);
+
+        const __m128 rolloff{_mm_load_ps(&batch.Rolloff[i])};
+        const __m128 roomrolloff{_mm_load_ps(&batch.RoomRolloff[i])};
+        __m128 drygain{_mm_load_ps(&batch.DryGain[i])};
+        __m128 wetgain{_mm_load_ps(&batch.WetGain[i])};
+
+        const __m128 isinv{_mm_cmpeq_ps(model, _mm_set1_ps(float{AttnInverse}))};
+        const __m128 reldist{_mm_sub_ps(clamped, refdist)};
+        const __m128 drydist{_mm_add_ps(refdist, _mm_mul_ps(reldist, rolloff))};
+        const __m128 wetdist{_mm_add_ps(refdist, _mm_mul_ps(reldist, roomrolloff))};
+        drygain = SelectSSE(_mm_and_ps(isinv, _mm_cmpgt_ps(drydist, zero)),
+            _mm_mul_ps(drygain, _mm_div_ps(refdist, drydist)), drygain);
+        wetgain = SelectSSE(_mm_and_ps(isinv, _mm_cmpgt_ps(wetdist, zero)),
+            _mm_mul_ps(wetgain, _mm_div_ps(refdist, wetdist)), wetgain);
+
+        const __m128 islin{_mm_cmpeq_ps(model, _mm_set1_ps(float{AttnLinear}))};
+        const __m128 linscale{_mm_div_ps(reldist,
+            _mm_sub_ps(_mm_load_ps(&batch.MaxDist[i]), refdist))};
+        const __m128 dryattn{_mm_mul_ps(linscale, rolloff)};
+        const __m128 wetattn{_mm_mul_ps(linscale, roomrolloff)};
+        drygain = SelectSSE(islin, _mm_mul_ps(drygain, _mm_max_ps(_mm_sub_ps(one, dryattn), zero)),
+            drygain);
+        wetgain = SelectSSE(islin, _mm_mul_ps(wetgain, _mm_max_ps(_mm_sub_ps(one, wetattn), zero)),
+            wetgain);
+        _mm_store_ps(&batch.DryGain[i], drygain);
+        _mm_store_ps(&batch.WetGain[i], wetgain);
+
+        /* Calculate velocity-based doppler effect. */
+        const __m128 doppler{_mm_load_ps(&batch.Doppler[i])};
+        const __m128 negdoppler{_mm_sub_ps(zero, doppler)};
+        __m128 vss{_mm_mul_ps(vx, px)};
+        vss = _mm_add_ps(vss, _mm_mul_ps(vy, py));
+        vss = _mm_mul_ps(_mm_add_ps(vss, _mm_mul_ps(vz, pz)), negdoppler);
+        __m128 vls{_mm_mul_ps(_mm_set1_ps(lvel[0]), px)};
+        vls = _mm_add_ps(vls, _mm_mul_ps(_mm_set1_ps(lvel[1]), py));
+        vls = _mm_mul_ps(_mm_add_ps(vls, _mm_mul_ps(_mm_set1_ps(lvel[2]), pz)), negdoppler);
+
+        const __m128 pitch{_mm_load_ps(&batch.Pitch[i])};
+        __m128 shifted{_mm_mul_ps(pitch, _mm_div_ps(_mm_sub_ps(sos4, vls),
+            _mm_sub_ps(sos4, vss)))};
+        shifted = SelectSSE(_mm_cmplt_ps(vss, sos4), shifted,
+            _mm_set1_ps(std::numeric_limits<float>::infinity()));
+        shifted = _mm_and_ps(shifted, _mm_cmplt_ps(vls, sos4));
+        _mm_store_ps(&batch.Pitch[i], SelectSSE(_mm_cmpgt_ps(doppler, zero), shifted, pitch));
     }
+#else
+    for(size_t i{0};i < batch.Count;++i)
+    {
+        alu::Vector Position{batch.PosX[i], batch.PosY[i], batch.PosZ[i], 1.0f};
+        alu::Vector Velocity{batch.VelX[i], batch.VelY[i], batch.VelZ[i], 0.0f};
+        alu::Vector Direction{batch.DirX[i], batch.DirY[i], batch.DirZ[i], 0.0f};
+        if(!(batch.HeadRelative[i] != 0.0f))
+        {
+            Position = mtx * (Position - lpos);
+            Velocity = mtx * Velocity;
+            Direction = mtx * Direction;
+        }
+        else
+            Velocity += lvel;
+
+        batch.DirLength[i] = Direction.normalize();
+        const float Distance{Position.normalize()};
+        batch.PosX[i] = Position[0];
+        batch.PosY[i] = Position[1];
+        batch.PosZ[i] = Position[2];
+        batch.Distance[i] = Distance;
+        batch.ConeDot[i] = -Direction.dot_product(Position);
+
+        const float RefDist{batch.RefDist[i]};
+        const float ClampedDist{clampf(Distance, batch.ClampMin[i], batch.ClampMax[i])};
+        batch.ClampedDist[i] = ClampedDist;
+        if(batch.Model[i] == float{AttnInverse})
+        {
+            float dist{lerpf(RefDist, ClampedDist, batch.Rolloff[i])};
+            if(dist > 0.0f) batch.DryGain[i] *= RefDist / dist;
 
-    const bool directional{Direction.normalize() > 0.0f};
-    alu::Vector ToSource{Position[0], Position[1], Position[2], 0.0f};
-    const float Distance{ToSource.normalize()};
+            dist = lerpf(RefDist, ClampedDist, batch.RoomRolloff[i]);
+            if(dist > 0.0f) batch.WetGain[i] *= RefDist / dist;
+        }
+        else if(batch.Model[i] == float{AttnLinear})
+        {
+            const float scale{(ClampedDist-RefDist) / (batch.MaxDist[i]-RefDist)};
+            batch.DryGain[i] *= maxf(1.0f - scale*batch.Rolloff[i], 0.0f);
+            batch.WetGain[i] *= maxf(1.0f - scale*batch.RoomRolloff[i], 0.0f);
+        }
 
-    /* Calculate distance attenuation */
-    float ClampedDist{Distance};
-    float DryGainBase{props->Gain};
-    float WetGainBase{props->Gain};
+        const float DopplerFactor{batch.Doppler[i]};
+        if(DopplerFactor > 0.0f)
+        {
+            const float vss{Velocity.dot_product(Position) * -DopplerFactor};
+            const float vls{lvel.dot_product(Position) * -DopplerFactor};
+            if(!(vls < SpeedOfSound))
+                batch.Pitch[i] = 0.0f;
+            else if(!(vss < SpeedOfSound))
+                batch.Pitch[i] = std::numeric_limits<float>::infinity();
+            else
+                batch.Pitch[i] *= (SpeedOfSound-vls) / (SpeedOfSound-vss);
+        }
+    }
+#endif
+}
 
-    switch(context->mParams.SourceDistanceModel ? props->mDistanceModel
-        : context->mParams.mDistanceModel)
+/* Applies the distance and cone attenuation that aren't calculated with the
+ * rest of the batch geometry.
+ */
+void CalcAttnBatchCones(AttnBatch &batch)
+{
+    for(size_t i{0};i < batch.Count;++i)
     {
-        case DistanceModel::InverseClamped:
-            if(props->MaxDistance < props->RefDistance) break;
-            ClampedDist = clampf(ClampedDist, props->RefDistance, props->MaxDistance);
-            /*fall-through*/
-        case DistanceModel::Inverse:
-            if(props->RefDistance > 0.0f)
-            {
-                float dist{lerpf(props->RefDistance, ClampedDist, props->RolloffFactor)};
-                if(dist > 0.0f) DryGainBase *= props->RefDistance / dist;
+        const VoiceProps *props{&batch.Voices[i]->mProps};
 
-                dist = lerpf(props->RefDistance, ClampedDist, props->RoomRolloffFactor);
-                if(dist > 0.0f) WetGainBase *= props->RefDistance / dist;
-            }
-            break;
-
-        case DistanceModel::LinearClamped:
-            if(props->MaxDistance < props->RefDistance) break;
-            ClampedDist = clampf(ClampedDist, props->RefDistance, props->MaxDistance);
-            /*fall-through*/
-        case DistanceModel::Linear:
-            if(props->MaxDistance != props->RefDistance)
+        if(batch.Model[i] == float{AttnExponent})
+        {
+            const float ClampedDist{batch.ClampedDist[i]};
+            if(ClampedDist > 0.0f && props->RefDistance > 0.0f)
             {
-                float attn{(ClampedDist-props->RefDistance) /
-                    (props->MaxDistance-props->RefDistance) * props->RolloffFactor};
-                DryGainBase *= maxf(1.0f - attn, 0.0f);
-
-                attn = (ClampedDist-props->RefDistance) /
-                    (props->MaxDistance-props->RefDistance) * props->RoomRolloffFactor;
-                WetGainBase *= maxf(1.0f - attn, 0.0f);
+                const float dist_ratio{ClampedDist/props->RefDistance};
+                batch.DryGain[i] *= std::pow(dist_ratio, -props->RolloffFactor);
+                batch.WetGain[i] *= std::pow(dist_ratio, -props->RoomRolloffFactor);
             }
-            break;
+        }
 
-        case DistanceModel::ExponentClamped:
-            if(props->MaxDistance < props->RefDistance) break;
-            ClampedDist = clampf(ClampedDist, props->RefDistance, props->MaxDistance);
-            /*fall-through*/
-        case DistanceModel::Exponent:
-            if(ClampedDist > 0.0f && props->RefDistance > 0.0f)
+        /* Calculate directional soundcones */
+        float ConeHF{1.0f}, WetConeHF{1.0f};
+        if(batch.DirLength[i] > 0.0f && props->InnerAngle < 360.0f)
+        {
+            static constexpr float Rad2Deg{static_cast<float>(180.0 / al::numbers::pi)};
+            const float Angle{Rad2Deg*2.0f * std::acos(batch.ConeDot[i]) * ConeScale};
+
+            float ConeGain{1.0f};
+            if(Angle >= props->OuterAngle)
             {
-                const float dist_ratio{ClampedDist/props->RefDistance};
-                DryGainBase *= std::pow(dist_ratio, -props->RolloffFactor);
-                WetGainBase *= std::pow(dist_ratio, -props->RoomRolloffFactor);
+                ConeGain = props->OuterGain;
+                ConeHF = lerpf(1.0f, props->OuterGainHF, props->DryGainHFAuto);
             }
-            break;
+            else if(Angle >= props->InnerAngle)
+            {
+                const float scale{(Angle-props->InnerAngle) / (props->OuterAngle-props->InnerAngle)};
+                ConeGain = lerpf(1.0f, props->OuterGain, scale);
+                ConeHF = lerpf(1.0f, props->OuterGainHF, scale * props->DryGainHFAuto);
+            }
+
+            batch.DryGain[i] *= ConeGain;
+            batch.WetGain[i] *= lerpf(1.0f, ConeGain, props->WetGainAuto);
 
-        case DistanceModel::Disable:
-            break;
+            WetConeHF = lerpf(1.0f, ConeHF, props->WetGainHFAuto);
+        }
+        batch.ConeHF[i] = ConeHF;
+        batch.WetConeHF[i] = WetConeHF;
     }
+}
 
-    /* Calculate directional soundcones */
-    float ConeHF{1.0f}, WetConeHF{1.0f};
-    if(directional && props->InnerAngle < 360.0f)
-    {
-        static constexpr float Rad2Deg{static_cast<float>(180.0 / al::numbers::pi)};
-        const float Angle{Rad2Deg*2.0f * std::acos(-Direction.dot_product(ToSource)) * ConeScale};
+void CalcAttnSourceParams(const AttnBatch &batch, const size_t idx, const ContextBase *context)
+{
+    Voice *voice{batch.Voices[idx]};
+    const VoiceProps *props{&voice->mProps};
+    const DeviceBase *Device{context->mDevice};
+    const uint NumSends{Device->NumAuxSends};
 
-        float ConeGain{1.0f};
-        if(Angle >= props->OuterAngle)
-        {
-            ConeGain = props->OuterGain;
-            ConeHF = lerpf(1.0f, props->OuterGainHF, props->DryGainHFAuto);
-        }
-        else if(Angle >= props->InnerAngle)
+    /* Set send mixing buffers and get send parameters. */
+    EffectSlot *SendSlots[MAX_SENDS];
+    uint UseDryAttnForRoom{0};
+    for(uint i{0};i < NumSends;i++)
+    {
+        SendSlots[i] = props->Send[i].Slot;
+        if(!SendSlots[i] || SendSlots[i]->EffectType == EffectSlotType::None)
+            SendSlots[i] = nullptr;
+        else if(!SendSlots[i]->AuxSendAuto)
         {
-            const float scale{(Angle-props->InnerAngle) / (props->OuterAngle-props->InnerAngle)};
-            ConeGain = lerpf(1.0f, props->OuterGain, scale);
-            ConeHF = lerpf(1.0f, props->OuterGainHF, scale * props->DryGainHFAuto);
+            /* If the slot's auxiliary send auto is off, the data sent to the
+             * effect slot is the same as the dry path, sans filter effects.
+             */
+            UseDryAttnForRoom |= 1u<<i;
         }
 
-        DryGainBase *= ConeGain;
-        WetGainBase *= lerpf(1.0f, ConeGain, props->WetGainAuto);
-
-        WetConeHF = lerpf(1.0f, ConeHF, props->WetGainHFAuto);
+        if(!SendSlots[i])
+            voice->mSend[i].Buffer = {};
+        else
+            voice->mSend[i].Buffer = SendSlots[i]->Wet.Buffer;
+        voice->mSend[i].Slot = SendSlots[i];
     }
 
+    const float Distance{batch.Distance[idx]};
+    const alu::Vector ToSource{batch.PosX[idx], batch.PosY[idx], batch.PosZ[idx], 0.0f};
+    float DryGainBase{batch.DryGain[idx]};
+    float WetGainBase{batch.WetGain[idx]};
+    const float ConeHF{batch.ConeHF[idx]};
+    const float WetConeHF{batch.WetConeHF[idx]};
+
     /* Apply gain and frequency filters */
     DryGainBase = clampf(DryGainBase, props->MinGain, props->MaxGain) * context->mParams.Gain;
     WetGainBase = clampf(WetGainBase, props->MinGain, props->MaxGain) * context->mParams.Gain;
@@ -1461,40 +1901,8 @@ void CalcAttnSourceParams(Voice *voice, const VoiceProps *props, const ContextBa
     }
 
 
-    /* Initial source pitch */
-    float Pitch{props->Pitch};
-
-    /* Calculate velocity-based doppler effect */
-    float DopplerFactor{props->DopplerFactor * context->mParams.DopplerFactor};
-    if(DopplerFactor > 0.0f)
-    {
-        const alu::Vector &lvelocity = context->mParams.Velocity;
-        float vss{Velocity.dot_product(ToSource) * -DopplerFactor};
-        float vls{lvelocity.dot_product(ToSource) * -DopplerFactor};
-
-        const float SpeedOfSound{context->mParams.SpeedOfSound};
-        if(!(vls < SpeedOfSound))
-        {
-            /* Listener moving away from the source at the speed of sound.
-             * Sound waves can't catch it.
-             */
-            Pitch = 0.0f;
-        }
-        else if(!(vss < SpeedOfSound))
-        {
-            /* Source moving toward the listener at the speed of sound. Sound
-             * waves bunch up to extreme frequencies.
-             */
-            Pitch = std::numeric_limits<float>::infinity();
-        }
-        else
-        {
-            /* Source and listener movement is nominal. Calculate the proper
-             * doppler shift.
-             */
-            Pitch *= (SpeedOfSound-vls) / (SpeedOfSound-vss);
-        }
-    }
+    /* Source pitch, with any doppler shift applied. */
+    float Pitch{batch.Pitch[idx]};
 
     /* Adjust pitch based on the buffer and output frequencies, and calculate
      * fixed-point stepping value.
@@ -1504,7 +1912,11 @@ void CalcAttnSourceParams(Voice *voice, const VoiceProps *props, const ContextBa
         voice->mStep = MaxPitch<<MixerFracBits;
     else
         voice->mStep = maxu(fastf2u(Pitch * MixerFracOne), 1);
-    voice->mResampler = PrepareResampler(props->mResampler, voice->mStep, &voice->mResampleState);
+
+    voice->mDetailTier = CalcVoiceDetailTier(context->mDetailLevel, DryGain, WetGain, SendSlots,
+        Device);
+    voice->mResampler = PrepareResampler(GetDetailResampler(props->mResampler,
+        voice->mDetailTier), voice->mStep, &voice->mResampleState);
 
     float spread{0.0f};
     if(props->Radius > Distance)
@@ -1517,7 +1929,16 @@ void CalcAttnSourceParams(Voice *voice, const VoiceProps *props, const ContextBa
         context->mParams, Device);
 }
 
-void CalcSourceParams(Voice *voice, ContextBase *context, bool force)
+void CalcAttnBatchParams(AttnBatch &batch, const ContextBase *context)
+{
+    CalcAttnBatchGeometry(batch, context);
+    CalcAttnBatchCones(batch);
+    for(size_t i{0};i < batch.Count;++i)
+        CalcAttnSourceParams(batch, i, context);
+    batch.Count = 0;
+}
+
+void CalcSourceParams(Voice *voice, ContextBase *context, bool force, AttnBatch &batch)
 {
     VoicePropsItem *props{voice->mUpdate.exchange(nullptr, std::memory_order_acq_rel)};
     if(!props && !force) return;
@@ -1535,7 +1956,80 @@ void CalcSourceParams(Voice *voice, ContextBase *context, bool force)
         || (voice->mProps.mSpatializeMode==SpatializeMode::Auto && voice->mFmtChannels != FmtMono))
         CalcNonAttnSourceParams(voice, &voice->mProps, context);
     else
-        CalcAttnSourceParams(voice, &voice->mProps, context);
+    {
+        /* Attenuated sources are deferred to be updated together. */
+        AttnBatchAddVoice(batch, voice, context);
+        if(batch.Count == AttnBatchSize)
+            CalcAttnBatchParams(batch, context);
+    }
+}
+
+/* In hybrid HRTF mode, only the most important voices (the loudest, after
+ * distance attenuation) get direct HRTF rendering, with the rest panned to
+ * the ambisonic mix. Voices that switch are recalculated, and crossfade
+ * between the two paths.
+ */
+void RankHrtfVoices(ContextBase *context, const al::span<Voice*> voices, AttnBatch &batch)
+{
+    /* Voices that already have direct HRTF are boosted by ~3.5dB for ranking,
+     * so voices at similar levels don't keep trading places.
+     */
+    static constexpr float DirectBoost{1.5f};
+
+    struct RankedVoice {
+        float priority;
+        Voice *voice;
+    };
+    std::array<RankedVoice,MaxHrtfDirectVoices> ranked;
+    const size_t maxranked{minu(context->mDevice->mHrtfDirectVoices, MaxHrtfDirectVoices)};
+    size_t numranked{0};
+
+    for(Voice *voice : voices)
+    {
+        if(voice->mSourceID.load(std::memory_order_relaxed) == 0
+            || !(voice->mHrtfPriority > 0.0f))
+            continue;
+        const Voice::State vstate{voice->mPlayState.load(std::memory_order_acquire)};
+        if(vstate != Voice::Playing && vstate != Voice::Pending)
+            continue;
+
+        float priority{voice->mHrtfPriority};
+        if(!voice->mFlags.test(VoiceHrtfPanned))
+            priority *= DirectBoost;
+        if(numranked == maxranked && !(priority > ranked[numranked-1].priority))
+            continue;
+
+        /* Insert the voice in order, dropping the lowest if full. */
+        size_t pos{numranked};
+        if(numranked < maxranked)
+            ++numranked;
+        else
+            --pos;
+        while(pos > 0 && ranked[pos-1].priority < priority)
+        {
+            ranked[pos] = ranked[pos-1];
+            --pos;
+        }
+        ranked[pos] = RankedVoice{priority, voice};
+    }
+
+    auto is_ranked = [&ranked,numranked](const Voice *voice) noexcept -> bool
+    {
+        auto match_voice = [voice](const RankedVoice &rv) noexcept { return rv.voice == voice; };
+        return std::any_of(ranked.cbegin(), ranked.cbegin()+numranked, match_voice);
+    };
+    for(Voice *voice : voices)
+    {
+        if(voice->mSourceID.load(std::memory_order_relaxed) == 0)
+            continue;
+
+        const bool panned{voice->mHrtfPriority > 0.0f && !is_ranked(voice)};
+        if(panned != voice->mFlags.test(VoiceHrtfPanned))
+        {
+            voice->mFlags.set(VoiceHrtfPanned, panned);
+            CalcSourceParams(voice, context, true, batch);
+        }
+    }
 }
 
 
@@ -1674,24 +2168,221 @@ void ProcessParamUpdates(ContextBase *ctx, const EffectSlotArray &slots,
     if LIKELY(!ctx->mHoldUpdates.load(std::memory_order_acquire))
     {
         bool force{CalcContextParams(ctx)};
+        /* A change in the mixer's level of detail needs all voices updated. */
+        const uint detail_level{ctx->mDevice->mDetailLevel.load(std::memory_order_relaxed)};
+        if(detail_level != ctx->mDetailLevel)
+        {
+            ctx->mDetailLevel = detail_level;
+            force = true;
+        }
+        /* As does switching to an HRTF renderer loaded in the background. */
+        if(ctx->mRendererCount != ctx->mDevice->mRendererCount)
+        {
+            ctx->mRendererCount = ctx->mDevice->mRendererCount;
+            force = true;
+        }
         auto sorted_slots = const_cast<EffectSlot**>(slots.data() + slots.size());
         for(EffectSlot *slot : slots)
             force |= CalcEffectSlotParams(slot, sorted_slots, ctx);
 
+        AttnBatch batch{};
         for(Voice *voice : voices)
         {
             /* Only update voices that have a source. */
             if(voice->mSourceID.load(std::memory_order_relaxed) != 0)
-                CalcSourceParams(voice, ctx, force);
+                CalcSourceParams(voice, ctx, force, batch);
+        }
+        if(batch.Count > 0)
+            CalcAttnBatchParams(batch, ctx);
+
+        if(ctx->mDevice->mHrtfDirectVoices > 0 && ctx->mDevice->mRenderMode == RenderMode::Hrtf)
+        {
+            RankHrtfVoices(ctx, voices, batch);
+            if(batch.Count > 0)
+                CalcAttnBatchParams(batch, ctx);
         }
     }
     IncrementRef(ctx->mUpdateCount);
 }
 
+void MixVoices(DeviceBase *device, ContextBase *ctx, const EffectSlotArray &auxslots,
+    const al::span<Voice*> voices, const uint SamplesToDo)
+{
+    /* The minimum number of voices each part should get for using the mixer
+     * workers to be worth it.
+     */
+    static constexpr size_t MinVoicesPerPart{16};
+
+    auto mix_voices = [ctx,SamplesToDo](const al::span<Voice*> vlist, MixerScratch &scratch)
+    {
+        for(Voice *voice : vlist)
+        {
+            const Voice::State vstate{voice->mPlayState.load(std::memory_order_acquire)};
+            if(vstate != Voice::Stopped && vstate != Voice::Pending)
+                voice->mix(vstate, ctx, SamplesToDo, scratch);
+        }
+    };
+
+    MixerWorkerPool *workers{device->mMixerWorkers.get()};
+    const size_t numparts{workers ? minz(workers->size()+1, voices.size()/MinVoicesPerPart) : 0};
+    if(numparts < 2)
+        return mix_voices(voices, device->mMixScratch);
+
+    /* Workers mix into partial buffers for the dry output, the real output
+     * (for direct channels, if different), and each active effect slot's wet
+     * buffer.
+     */
+    std::array<al::span<FloatBufferLine>,MaxWorkerSlotBuses+2> buses;
+    size_t numbuses{0};
+    if(auxslots.size() <= MaxWorkerSlotBuses)
+    {
+        buses[numbuses++] = device->Dry.Buffer;
+        if(device->RealOut.Buffer.data() != device->Dry.Buffer.data())
+            buses[numbuses++] = device->RealOut.Buffer;
+        for(EffectSlot *slot : auxslots)
+            buses[numbuses++] = slot->Wet.Buffer;
+    }
+    if(!numbuses || !workers->mapBuses({buses.data(), numbuses}, numparts, SamplesToDo))
+    {
+        /* Too many effect slots for the workers' partial buffers. */
+        return mix_voices(voices, device->mMixScratch);
+    }
+
+    /* Split the voices into contiguous parts. Each part always gets the same
+     * voices (for a given voice and part count), keeping the summation order
+     * stable between updates.
+     */
+    const size_t partsize{(voices.size() + numparts-1) / numparts};
+    workers->execute(numparts, device->mMixScratch,
+        [voices,partsize,&mix_voices](const size_t index, MixerScratch &scratch)
+        {
+            const size_t offset{minz(index*partsize, voices.size())};
+            mix_voices(voices.subspan(offset, minz(partsize, voices.size()-offset)), scratch);
+        });
+
+    workers->reduceBuses(numparts, device->HrtfAccumData, SamplesToDo);
+}
+
+void ProcessVoices(DeviceBase *device, ContextBase *ctx, const EffectSlotArray &auxslots,
+    const al::span<Voice*> voices, const uint SamplesToDo)
+{
+    MixVoices(device, ctx, auxslots, voices, SamplesToDo);
+
+    /* Send the voices' events once they're all mixed, so only the mixer
+     * thread writes to the event queue.
+     */
+    for(Voice *voice : voices)
+        voice->sendEvents(ctx);
+}
+
+/* Returns the number of target slots between the slot and the device output. */
+inline uint GetSlotDepth(const EffectSlot *slot) noexcept
+{
+    uint depth{0u};
+    while((slot=slot->Target) != nullptr)
+        ++depth;
+    return depth;
+}
+
+void ProcessSlotLevel(DeviceBase *device, const al::span<EffectSlot*> slots,
+    const uint SamplesToDo)
+{
+    auto process_slots = [slots,SamplesToDo](const size_t start, const size_t step,
+        MixerScratch &scratch)
+    {
+        for(size_t i{start};i < slots.size();i += step)
+        {
+            EffectSlot *slot{slots[i]};
+            EffectState *state{slot->mEffectState};
+
+            /* Once the input has been silent for longer than the effect's
+             * tail, there's nothing left for it to output. Its wet buffer is
+             * left cleared and the effect sleeps until it gets input again.
+             */
+            if(slot->mInputActive.exchange(false, std::memory_order_relaxed))
+                slot->mSilentSamples = 0;
+            else
+            {
+                const uint tail{state->tailLength()};
+                if(tail == InfiniteEffectTail)
+                    slot->mSilentSamples = 0;
+                else if(slot->mSilentSamples < tail)
+                    slot->mSilentSamples += minu(SamplesToDo, tail-slot->mSilentSamples);
+                else
+                {
+                    slot->mSleeping = true;
+                    continue;
+                }
+            }
+            slot->mSleeping = false;
+
+            state->process(SamplesToDo, slot->Wet.Buffer, scratch.getBus(state->mOutTarget));
+            if(EffectSlot *target{slot->Target})
+                target->mInputActive.store(true, std::memory_order_relaxed);
+        }
+    };
+
+    MixerWorkerPool *workers{device->mMixerWorkers.get()};
+    const size_t numparts{workers ? minz(workers->size()+1, slots.size()) : 0};
+    if(numparts < 2)
+        return process_slots(0, 1, device->mMixScratch);
+
+    /* Workers process into partial buffers for each output the slots on this
+     * level write to. These are either the device outputs or the wet buffers
+     * of slots on a lower level.
+     */
+    std::array<al::span<FloatBufferLine>,MaxWorkerSlotBuses+2> buses;
+    size_t numbuses{0};
+    for(const EffectSlot *slot : slots)
+    {
+        const al::span<FloatBufferLine> target{slot->mEffectState->mOutTarget};
+        auto bus_end = buses.begin() + numbuses;
+        auto same_bus = [target](const al::span<FloatBufferLine> bus) noexcept -> bool
+        { return bus.data() == target.data(); };
+        if(std::find_if(buses.begin(), bus_end, same_bus) != bus_end)
+            continue;
+        if(numbuses == buses.size())
+            return process_slots(0, 1, device->mMixScratch);
+        buses[numbuses++] = target;
+    }
+    if(!workers->mapBuses({buses.data(), numbuses}, numparts, SamplesToDo))
+        return process_slots(0, 1, device->mMixScratch);
+
+    /* Interleave the slots between the parts, so expensive effects that tend
+     * to be created together (e.g. a set of reverbs) get spread out.
+     */
+    workers->execute(numparts, device->mMixScratch,
+        [numparts,&process_slots](const size_t index, MixerScratch &scratch)
+        { process_slots(index, numparts, scratch); });
+
+    workers->reduceBuses(numparts, device->HrtfAccumData, SamplesToDo);
+}
+
+void ProcessEffectSlots(DeviceBase *device, const al::span<EffectSlot*> sorted_slots,
+    const uint SamplesToDo)
+{
+    /* Slots on the same dependency level don't feed into each other, so each
+     * level can be processed at once. All of a level's output has to be
+     * written before the next level reads it, though.
+     */
+    auto level_begin = sorted_slots.begin();
+    while(level_begin != sorted_slots.end())
+    {
+        const uint depth{GetSlotDepth(*level_begin)};
+        auto level_end = std::find_if(level_begin+1, sorted_slots.end(),
+            [depth](const EffectSlot *slot) noexcept -> bool
+            { return GetSlotDepth(slot) != depth; });
+
+        ProcessSlotLevel(device, {level_begin, level_end}, SamplesToDo);
+        level_begin = level_end;
+    }
+}
+
 void ProcessContexts(DeviceBase *device, const uint SamplesToDo)
 {
     ASSUME(SamplesToDo > 0);
 
+    std::array<uint,DetailTierCount> tier_counts{};
     for(ContextBase *ctx : *device->mContexts.load(std::memory_order_acquire))
     {
         const EffectSlotArray &auxslots = *ctx->mActiveAuxSlots.load(std::memory_order_acquire);
@@ -1700,19 +2391,29 @@ void ProcessContexts(DeviceBase *device, const uint SamplesToDo)
         /* Process pending propery updates for objects on the context. */
         ProcessParamUpdates(ctx, auxslots, voices);
 
-        /* Clear auxiliary effect slot mixing buffers. */
+        /* Clear auxiliary effect slot mixing buffers. Sleeping slots were
+         * left cleared.
+         */
         for(EffectSlot *slot : auxslots)
         {
+            if(slot->mSleeping)
+                continue;
             for(auto &buffer : slot->Wet.Buffer)
                 buffer.fill(0.0f);
         }
 
         /* Process voices that have a playing source. */
-        for(Voice *voice : voices)
+        ProcessVoices(device, ctx, auxslots, voices, SamplesToDo);
+
+        /* Tally the level of detail playing voices are mixed with. */
+        if(device->mMixBudget > 0.0f)
         {
-            const Voice::State vstate{voice->mPlayState.load(std::memory_order_acquire)};
-            if(vstate != Voice::Stopped && vstate != Voice::Pending)
-                voice->mix(vstate, ctx, SamplesToDo);
+            for(Voice *voice : voices)
+            {
+                if(voice->mPlayState.load(std::memory_order_acquire) == Voice::Playing
+                    && voice->mSourceID.load(std::memory_order_relaxed) != 0)
+                    ++tier_counts[voice->mDetailTier];
+            }
         }
 
         /* Process effects. */
@@ -1769,13 +2470,19 @@ void ProcessContexts(DeviceBase *device, const uint SamplesToDo)
                             { return slot->Target != *next_target; });
                     } while(split_point - sorted_slots.begin() > 1);
                 }
-            }
 
-            for(const EffectSlot *slot : sorted_slots)
-            {
-                EffectState *state{slot->mEffectState};
-                state->process(SamplesToDo, slot->Wet.Buffer, state->mOutTarget);
+                /* Finally, group the slots by their dependency level, with
+                 * the deepest slots first. A slot's level is always higher
+                 * than its target's, so this preserves the above ordering
+                 * while letting slots on the same level be processed
+                 * together.
+                 */
+                std::sort(sorted_slots.begin(), sorted_slots.end(),
+                    [](const EffectSlot *lhs, const EffectSlot *rhs) noexcept -> bool
+                    { return GetSlotDepth(lhs) > GetSlotDepth(rhs); });
             }
+
+            ProcessEffectSlots(device, sorted_slots, SamplesToDo);
         }
 
         /* Signal the event handler if there are any events to read. */
@@ -1783,6 +2490,54 @@ void ProcessContexts(DeviceBase *device, const uint SamplesToDo)
         if(ring->readSpace() > 0)
             ctx->mEventSem.post();
     }
+
+    if(device->mMixBudget > 0.0f)
+    {
+        for(size_t i{0};i < tier_counts.size();++i)
+            device->mDetailTierCounts[i].store(tier_counts[i], std::memory_order_relaxed);
+    }
+}
+
+/* Adjusts the mixer's level of detail according to how much of the update
+ * period was spent mixing. The level is raised quickly when over budget, and
+ * only lowered again after there's been plenty of headroom for a while.
+ */
+void UpdateDetailLevel(DeviceBase *device, const uint SamplesToDo,
+    const std::chrono::nanoseconds mixTime)
+{
+    static constexpr uint RaiseDelay{2};
+    static constexpr uint LowerDelay{64};
+
+    const std::chrono::nanoseconds period{std::chrono::seconds{SamplesToDo}};
+    const float load{static_cast<float>(mixTime.count()) /
+        static_cast<float>((period / device->Frequency).count())};
+    /* Track increases in load faster than decreases. */
+    device->mMixLoad = lerpf(device->mMixLoad, load, (load > device->mMixLoad) ? 0.5f : 0.125f);
+
+    const uint level{device->mDetailLevel.load(std::memory_order_relaxed)};
+    if(device->mMixLoad > device->mMixBudget)
+    {
+        device->mUnderBudgetCount = 0;
+        if(level < MaxDetailLevel && ++device->mOverBudgetCount >= RaiseDelay)
+        {
+            device->mDetailLevel.store(level+1, std::memory_order_relaxed);
+            device->mOverBudgetCount = 0;
+        }
+    }
+    else if(device->mMixLoad < device->mMixBudget*0.5f)
+    {
+        device->mOverBudgetCount = 0;
+        if(level > 0 && ++device->mUnderBudgetCount >= LowerDelay)
+        {
+            device->mDetailLevel.store(level-1, std::memory_order_relaxed);
+            device->mUnderBudgetCount = 0;
+        }
+    }
+    else
+    {
+        device->mOverBudgetCount = 0;
+        device->mUnderBudgetCount = 0;
+    }
 }
 
 
@@ -1909,6 +2664,25 @@ uint DeviceBase::renderSamples(const uint numSamples)
 {
     const uint samplesToDo{minu(numSamples, BufferLineSize)};
 
+    /* Switch to an HRTF renderer that finished loading in the background.
+     * The old decoder is kept to fade out from, and contexts see the new
+     * count to update their voices for it. Any old HRTF state is swapped into
+     * the renderer, which gets freed with the next device reset rather than
+     * here.
+     */
+    if UNLIKELY(mPendingHrtf.load(std::memory_order_relaxed))
+    {
+        HrtfRenderer *renderer{mPendingHrtf.exchange(nullptr, std::memory_order_acquire)};
+        std::swap(mHrtfState, renderer->mState);
+        mIrSize = renderer->mIrSize;
+        mRenderMode = renderer->mRenderMode;
+        AvgSpeakerDist = renderer->mAvgSpeakerDist;
+        std::copy(renderer->mNumChannelsPerOrder.cbegin(), renderer->mNumChannelsPerOrder.cend(),
+            std::begin(NumChannelsPerOrder));
+        PostProcess = &DeviceBase::ProcessHrtfFade;
+        ++mRendererCount;
+    }
+
     /* Clear main mixing buffers. */
     for(FloatBufferLine &buffer : MixBuffer)
         buffer.fill(0.0f);
@@ -1916,8 +2690,17 @@ uint DeviceBase::renderSamples(const uint numSamples)
     /* Increment the mix count at the start (lsb should now be 1). */
     IncrementRef(MixCount);
 
-    /* Process and mix each context's sources and effects. */
-    ProcessContexts(this, samplesToDo);
+    /* Process and mix each context's sources and effects, timing it when the
+     * mixer has a time budget.
+     */
+    if(mMixBudget > 0.0f)
+    {
+        const auto mixStart = std::chrono::steady_clock::now();
+        ProcessContexts(this, samplesToDo);
+        UpdateDetailLevel(this, samplesToDo, std::chrono::steady_clock::now() - mixStart);
+    }
+    else
+        ProcessContexts(this, samplesToDo);
 
     /* Increment the clock time. Every second's worth of samples is converted
      * and added to clock base so that large sample counts don't overflow
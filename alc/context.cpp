@@ -62,6 +62,7 @@ constexpr ALchar alExtList[] =
     "AL_EXT_SOURCE_RADIUS "
     "AL_EXT_STEREO_ANGLES "
     "AL_LOKI_quadriphonic "
+    "AL_SOFTX_batch_source_params "
     "AL_SOFT_bformat_ex "
     "AL_SOFTX_bformat_hoa "
     "AL_SOFT_block_alignment "
@@ -77,6 +78,7 @@ constexpr ALchar alExtList[] =
     "AL_SOFT_loop_points "
     "AL_SOFTX_map_buffer "
     "AL_SOFT_MSADPCM "
+    "AL_SOFTX_reverb_late_rate "
     "AL_SOFT_source_latency "
     "AL_SOFT_source_length "
     "AL_SOFT_source_resampler "
@@ -32,6 +32,8 @@ ALCdevice::~ALCdevice()
 {
     TRACE("Freeing device %p\n", voidp{this});
 
+    stopHrtfLoader();
+
     Backend = nullptr;
 
     size_t count{std::accumulate(BufferList.cbegin(), BufferList.cend(), size_t{0u},
@@ -53,6 +55,16 @@ ALCdevice::~ALCdevice()
         WARN("%zu Filter%s not deleted\n", count, (count==1)?"":"s");
 }
 
+void ALCdevice::stopHrtfLoader()
+{
+    if(mHrtfLoader.joinable())
+    {
+        mHrtfLoaderQuit.store(true, std::memory_order_release);
+        mHrtfLoader.join();
+    }
+    mHrtfLoaderQuit.store(false, std::memory_order_relaxed);
+}
+
 void ALCdevice::enumerateHrtfs()
 {
     mHrtfList = EnumerateHrtf(configValue<std::string>(nullptr, "hrtf-paths"));
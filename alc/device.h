@@ -6,6 +6,7 @@
 #include <mutex>
 #include <stdint.h>
 #include <string>
+#include <thread>
 #include <utility>
 
 #include "AL/alc.h"
@@ -97,6 +98,12 @@ struct ALCdevice : public al::intrusive_ref<ALCdevice>, DeviceBase {
     al::vector<std::string> mHrtfList;
     ALCenum mHrtfStatus{ALC_FALSE};
 
+    /* With the hrtf-async option, the HRTF is loaded and its renderer built
+     * on this thread while the device renders with plain stereo panning.
+     */
+    std::thread mHrtfLoader;
+    std::atomic<bool> mHrtfLoaderQuit{false};
+
     enum class OutputMode1 : ALCenum {
         Any = ALC_ANY_SOFT,
         Mono = ALC_MONO_SOFT,
@@ -137,6 +144,9 @@ struct ALCdevice : public al::intrusive_ref<ALCdevice>, DeviceBase {
 
     void enumerateHrtfs();
 
+    /** Stops and waits for any background HRTF loading to finish. */
+    void stopHrtfLoader();
+
     bool getConfigValueBool(const char *block, const char *key, bool def)
     { return GetConfigValueBool(DeviceName.c_str(), block, key, def); }
 
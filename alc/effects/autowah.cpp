@@ -57,6 +57,7 @@ struct AutowahState final : public EffectState {
     float mFreqMinNorm;
     float mBandwidthNorm;
     float mEnvDelay;
+    uint mTailSamples;
 
     /* Filter components derived from the envelope. */
     struct {
@@ -84,6 +85,7 @@ struct AutowahState final : public EffectState {
         const EffectTarget target) override;
     void process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn,
         const al::span<FloatBufferLine> samplesOut) override;
+    uint tailLength() const noexcept override { return mTailSamples; }
 
     DEF_NEWDEL(AutowahState)
 };
@@ -99,6 +101,7 @@ void AutowahState::deviceUpdate(const DeviceBase*, const Buffer&)
     mFreqMinNorm   = 4.5e-4f;
     mBandwidthNorm = 0.05f;
     mEnvDelay      = 0.0f;
+    mTailSamples   = 0;
 
     for(auto &e : mEnv)
     {
@@ -130,6 +133,12 @@ void AutowahState::update(const ContextBase *context, const EffectSlot *slot,
     mFreqMinNorm   = MinFreq / frequency;
     mBandwidthNorm = (MaxFreq-MinFreq) / frequency;
 
+    /* The filter resonance rings the longest at the lowest frequency, where
+     * the envelope settles once the input goes silent.
+     */
+    mTailSamples = float2uint(QFactor * -std::log(EffectTailGain) /
+        (al::numbers::pi_v<float>*mFreqMinNorm) + 0.5f);
+
     mOutTarget = target.Main->Buffer;
     auto set_gains = [slot,target](auto &chan, al::span<const float,MaxAmbiChannels> coeffs)
     { ComputePanGains(target.Main, coeffs.data(), slot->Gain, chan.TargetGains); };
@@ -33,6 +33,7 @@
 #include "alspan.h"
 #include "core/bufferline.h"
 #include "core/context.h"
+#include "core/cpu_caps.h"
 #include "core/devformat.h"
 #include "core/device.h"
 #include "core/effectslot.h"
@@ -43,6 +44,11 @@
 #include "opthelpers.h"
 #include "vector.h"
 
+struct CTag;
+struct SSE2Tag;
+struct AVX2Tag;
+struct NEONTag;
+
 
 namespace {
 
@@ -50,6 +56,62 @@ using uint = unsigned int;
 
 #define MAX_UPDATE_SAMPLES 256
 
+using ModDelayLfoFunc = void(*)(uint *delays, const uint offset, const float scale,
+    const float depth, const int delay, const size_t todo);
+using ModDelayTapFunc = void(*)(const float *delaybuf, const size_t bufmask, const uint offset,
+    const uint *delays, float *dst, const size_t todo);
+
+inline ModDelayLfoFunc SelectLfo(const ChorusWaveform waveform)
+{
+    if(waveform == ChorusWaveform::Sinusoid)
+    {
+#ifdef HAVE_NEON
+        if((CPUCapFlags&CPU_CAP_NEON))
+            return ModDelaySinusoid_<NEONTag>;
+#endif
+#ifdef HAVE_AVX2
+        if((CPUCapFlags&CPU_CAP_AVX2))
+            return ModDelaySinusoid_<AVX2Tag>;
+#endif
+#ifdef HAVE_SSE2
+        if((CPUCapFlags&CPU_CAP_SSE2))
+            return ModDelaySinusoid_<SSE2Tag>;
+#endif
+        return ModDelaySinusoid_<CTag>;
+    }
+
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+        return ModDelayTriangle_<NEONTag>;
+#endif
+#ifdef HAVE_AVX2
+    if((CPUCapFlags&CPU_CAP_AVX2))
+        return ModDelayTriangle_<AVX2Tag>;
+#endif
+#ifdef HAVE_SSE2
+    if((CPUCapFlags&CPU_CAP_SSE2))
+        return ModDelayTriangle_<SSE2Tag>;
+#endif
+    return ModDelayTriangle_<CTag>;
+}
+
+inline ModDelayTapFunc SelectTaps()
+{
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+        return ModDelayTaps_<NEONTag>;
+#endif
+#ifdef HAVE_AVX2
+    if((CPUCapFlags&CPU_CAP_AVX2))
+        return ModDelayTaps_<AVX2Tag>;
+#endif
+#ifdef HAVE_SSE2
+    if((CPUCapFlags&CPU_CAP_SSE2))
+        return ModDelayTaps_<SSE2Tag>;
+#endif
+    return ModDelayTaps_<CTag>;
+}
+
 struct ChorusState final : public EffectState {
     al::vector<float,16> mSampleBuffer;
     uint mOffset{0};
@@ -70,15 +132,19 @@ struct ChorusState final : public EffectState {
     int mDelay{0};
     float mDepth{0.0f};
     float mFeedback{0.0f};
+    uint mTailSamples{0};
 
-    void getTriangleDelays(uint (*delays)[MAX_UPDATE_SAMPLES], const size_t todo);
-    void getSinusoidDelays(uint (*delays)[MAX_UPDATE_SAMPLES], const size_t todo);
+    ModDelayLfoFunc mGenLfo{ModDelayTriangle_<CTag>};
+    ModDelayTapFunc mReadTaps{ModDelayTaps_<CTag>};
+
+    void getModDelays(uint (*delays)[MAX_UPDATE_SAMPLES], const size_t todo);
 
     void deviceUpdate(const DeviceBase *device, const Buffer &buffer) override;
     void update(const ContextBase *context, const EffectSlot *slot, const EffectProps *props,
         const EffectTarget target) override;
     void process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn,
         const al::span<FloatBufferLine> samplesOut) override;
+    uint tailLength() const noexcept override { return mTailSamples; }
 
     DEF_NEWDEL(ChorusState)
 };
@@ -87,8 +153,12 @@ void ChorusState::deviceUpdate(const DeviceBase *Device, const Buffer&)
 {
     constexpr float max_delay{maxf(ChorusMaxDelay, FlangerMaxDelay)};
 
+    /* The delay line is fed an update's worth of samples ahead of the taps,
+     * so make room for that on top of the maximum modulated delay.
+     */
     const auto frequency = static_cast<float>(Device->Frequency);
-    const size_t maxlen{NextPowerOf2(float2uint(max_delay*2.0f*frequency) + 1u)};
+    const size_t maxlen{NextPowerOf2(float2uint(max_delay*2.0f*frequency) + MAX_UPDATE_SAMPLES +
+        4u)};
     if(maxlen != mSampleBuffer.size())
         al::vector<float,16>(maxlen).swap(mSampleBuffer);
 
@@ -98,6 +168,8 @@ void ChorusState::deviceUpdate(const DeviceBase *Device, const Buffer&)
         std::fill(std::begin(e.Current), std::end(e.Current), 0.0f);
         std::fill(std::begin(e.Target), std::end(e.Target), 0.0f);
     }
+
+    mReadTaps = SelectTaps();
 }
 
 void ChorusState::update(const ContextBase *Context, const EffectSlot *Slot,
@@ -112,6 +184,7 @@ void ChorusState::update(const ContextBase *Context, const EffectSlot *Slot,
     const auto frequency = static_cast<float>(device->Frequency);
 
     mWaveform = props->Chorus.Waveform;
+    mGenLfo = SelectLfo(mWaveform);
 
     mDelay = maxi(float2int(props->Chorus.Delay*frequency*MixerFracOne + 0.5f), mindelay);
     mDepth = minf(props->Chorus.Depth * static_cast<float>(mDelay),
@@ -119,6 +192,23 @@ void ChorusState::update(const ContextBase *Context, const EffectSlot *Slot,
 
     mFeedback = props->Chorus.Feedback;
 
+    /* The output lasts for as many passes through the delay line as it takes
+     * the feedback to attenuate it below the tail gain.
+     */
+    const uint maxdelay{static_cast<uint>((static_cast<float>(mDelay)+mDepth) *
+        (1.0f/MixerFracOne)) + 1u};
+    const float feedback{std::fabs(mFeedback)};
+    if(!(feedback < 1.0f))
+        mTailSamples = InfiniteEffectTail;
+    else
+    {
+        const float passes{(feedback > EffectTailGain) ?
+            std::ceil(std::log(EffectTailGain) / std::log(feedback)) + 1.0f : 1.0f};
+        const float length{passes * static_cast<float>(maxdelay)};
+        mTailSamples = (length < static_cast<float>(InfiniteEffectTail)) ? float2uint(length)
+            : InfiniteEffectTail;
+    }
+
     /* Gains for left and right sides */
     const auto lcoeffs = CalcDirectionCoeffs({-1.0f, 0.0f, 0.0f}, 0.0f);
     const auto rcoeffs = CalcDirectionCoeffs({ 1.0f, 0.0f, 0.0f}, 0.0f);
@@ -162,7 +252,7 @@ void ChorusState::update(const ContextBase *Context, const EffectSlot *Slot,
 }
 
 
-void ChorusState::getTriangleDelays(uint (*delays)[MAX_UPDATE_SAMPLES], const size_t todo)
+void ChorusState::getModDelays(uint (*delays)[MAX_UPDATE_SAMPLES], const size_t todo)
 {
     const uint lfo_range{mLfoRange};
     const float lfo_scale{mLfoScale};
@@ -172,42 +262,22 @@ void ChorusState::getTriangleDelays(uint (*delays)[MAX_UPDATE_SAMPLES], const si
     ASSUME(lfo_range > 0);
     ASSUME(todo > 0);
 
-    uint offset{mLfoOffset};
-    auto gen_lfo = [&offset,lfo_range,lfo_scale,depth,delay]() -> uint
-    {
-        offset = (offset+1)%lfo_range;
-        const float offset_norm{static_cast<float>(offset) * lfo_scale};
-        return static_cast<uint>(fastf2i((1.0f-std::abs(2.0f-offset_norm)) * depth) + delay);
-    };
-    std::generate_n(delays[0], todo, gen_lfo);
-
-    offset = (mLfoOffset+mLfoDisp) % lfo_range;
-    std::generate_n(delays[1], todo, gen_lfo);
-
-    mLfoOffset = static_cast<uint>(mLfoOffset+todo) % lfo_range;
-}
-
-void ChorusState::getSinusoidDelays(uint (*delays)[MAX_UPDATE_SAMPLES], const size_t todo)
-{
-    const uint lfo_range{mLfoRange};
-    const float lfo_scale{mLfoScale};
-    const float depth{mDepth};
-    const int delay{mDelay};
-
-    ASSUME(lfo_range > 0);
-    ASSUME(todo > 0);
-
-    uint offset{mLfoOffset};
-    auto gen_lfo = [&offset,lfo_range,lfo_scale,depth,delay]() -> uint
+    /* Generate the LFO in runs that end where the offset wraps around, so the
+     * delays can be calculated from consecutive offsets.
+     */
+    auto gen_lfo = [this,lfo_range,lfo_scale,depth,delay,todo](uint *dst, uint offset)
     {
-        offset = (offset+1)%lfo_range;
-        const float offset_norm{static_cast<float>(offset) * lfo_scale};
-        return static_cast<uint>(fastf2i(std::sin(offset_norm)*depth) + delay);
+        for(size_t i{0};i < todo;)
+        {
+            offset = (offset+1) % lfo_range;
+            const size_t count{minz(todo-i, lfo_range-offset)};
+            mGenLfo(dst+i, offset, lfo_scale, depth, delay, count);
+            offset += static_cast<uint>(count-1);
+            i += count;
+        }
     };
-    std::generate_n(delays[0], todo, gen_lfo);
-
-    offset = (mLfoOffset+mLfoDisp) % lfo_range;
-    std::generate_n(delays[1], todo, gen_lfo);
+    gen_lfo(delays[0], mLfoOffset);
+    gen_lfo(delays[1], (mLfoOffset+mLfoDisp) % lfo_range);
 
     mLfoOffset = static_cast<uint>(mLfoOffset+todo) % lfo_range;
 }
@@ -225,34 +295,26 @@ void ChorusState::process(const size_t samplesToDo, const al::span<const FloatBu
         const size_t todo{minz(MAX_UPDATE_SAMPLES, samplesToDo-base)};
 
         uint moddelays[2][MAX_UPDATE_SAMPLES];
-        if(mWaveform == ChorusWaveform::Sinusoid)
-            getSinusoidDelays(moddelays, todo);
-        else /*if(mWaveform == ChorusWaveform::Triangle)*/
-            getTriangleDelays(moddelays, todo);
+        getModDelays(moddelays, todo);
 
-        alignas(16) float temps[2][MAX_UPDATE_SAMPLES];
+        /* Feed the delay line for the whole update first, accumulating
+         * feedback from the average delay of the taps. The taps are always
+         * more than a few samples behind the input, so they see the same
+         * samples as when feeding and tapping one sample at a time.
+         */
         for(size_t i{0u};i < todo;++i)
         {
-            // Feed the buffer's input first (necessary for delays < 1).
-            delaybuf[offset&bufmask] = samplesIn[0][base+i];
-
-            // Tap for the left output.
-            uint delay{offset - (moddelays[0][i]>>MixerFracBits)};
-            float mu{static_cast<float>(moddelays[0][i]&MixerFracMask) * (1.0f/MixerFracOne)};
-            temps[0][i] = cubic(delaybuf[(delay+1) & bufmask], delaybuf[(delay  ) & bufmask],
-                delaybuf[(delay-1) & bufmask], delaybuf[(delay-2) & bufmask], mu);
-
-            // Tap for the right output.
-            delay = offset - (moddelays[1][i]>>MixerFracBits);
-            mu = static_cast<float>(moddelays[1][i]&MixerFracMask) * (1.0f/MixerFracOne);
-            temps[1][i] = cubic(delaybuf[(delay+1) & bufmask], delaybuf[(delay  ) & bufmask],
-                delaybuf[(delay-1) & bufmask], delaybuf[(delay-2) & bufmask], mu);
-
-            // Accumulate feedback from the average delay of the taps.
-            delaybuf[offset&bufmask] += delaybuf[(offset-avgdelay) & bufmask] * feedback;
-            ++offset;
+            const uint pos{offset + static_cast<uint>(i)};
+            delaybuf[pos&bufmask] = samplesIn[0][base+i] +
+                delaybuf[(pos-avgdelay) & bufmask]*feedback;
         }
 
+        /* Tap for the left and right outputs. */
+        alignas(16) float temps[2][MAX_UPDATE_SAMPLES];
+        mReadTaps(delaybuf, bufmask, offset, moddelays[0], temps[0], todo);
+        mReadTaps(delaybuf, bufmask, offset, moddelays[1], temps[1], todo);
+        offset += static_cast<uint>(todo);
+
         for(size_t c{0};c < 2;++c)
             MixSamples({temps[c], todo}, samplesOut, mGains[c].Current, mGains[c].Target,
                 samplesToDo-base, base);
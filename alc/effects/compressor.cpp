@@ -71,6 +71,7 @@ struct CompressorState final : public EffectState {
     float mAttackMult{1.0f};
     float mReleaseMult{1.0f};
     float mEnvFollower{1.0f};
+    uint mReleaseSamples{0u};
 
 
     void deviceUpdate(const DeviceBase *device, const Buffer &buffer) override;
@@ -78,6 +79,10 @@ struct CompressorState final : public EffectState {
         const EffectTarget target) override;
     void process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn,
         const al::span<FloatBufferLine> samplesOut) override;
+    /* There's no output without input, but give the envelope time to fully
+     * release so it's in the same state when the input resumes.
+     */
+    uint tailLength() const noexcept override { return mReleaseSamples; }
 
     DEF_NEWDEL(CompressorState)
 };
@@ -95,6 +100,7 @@ void CompressorState::deviceUpdate(const DeviceBase *device, const Buffer&)
      */
     mAttackMult  = std::pow(AMP_ENVELOPE_MAX/AMP_ENVELOPE_MIN, 1.0f/attackCount);
     mReleaseMult = std::pow(AMP_ENVELOPE_MIN/AMP_ENVELOPE_MAX, 1.0f/releaseCount);
+    mReleaseSamples = float2uint(releaseCount + 0.5f);
 }
 
 void CompressorState::update(const ContextBase*, const EffectSlot *slot,
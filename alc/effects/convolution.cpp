@@ -3,12 +3,14 @@
 
 #include <algorithm>
 #include <array>
-#include <complex>
+#include <atomic>
 #include <cstddef>
 #include <functional>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <stdint.h>
+#include <thread>
 #include <utility>
 
 #ifdef HAVE_SSE_INTRINSICS
@@ -33,12 +35,22 @@
 #include "core/effectslot.h"
 #include "core/filters/splitter.h"
 #include "core/fmt_traits.h"
+#include "core/fpu_ctrl.h"
+#include "core/helpers.h"
+#include "core/logging.h"
 #include "core/mixer.h"
 #include "intrusive_ptr.h"
+#include "opthelpers.h"
 #include "polyphase_resampler.h"
+#include "threads.h"
 #include "vector.h"
 
 
+/* Must be less than 15 characters (16 including terminating null) for
+ * compatibility with pthread_setname_np limitations. */
+#define CONVOLVE_TAIL_THREAD_NAME "alsoft-convtail"
+
+
 namespace {
 
 /* Convolution reverb is implemented using a segmented overlap-add method. The
@@ -53,10 +65,10 @@ namespace {
  *
  * To apply the reverberation, each impulse response segment is convolved with
  * its paired input segment (using complex multiplies, far cheaper than FIRs),
- * accumulating into a 256-bin FFT buffer. The input history is then shifted to
- * align with later impulse response segments for next time.
+ * accumulating into 129 bins. The input history is then shifted to align with
+ * later impulse response segments for next time.
  *
- * An inverse FFT is then applied to the accumulated FFT buffer to get a 256-
+ * An inverse real FFT is then applied to the accumulated bins to get a 256-
  * sample time-domain response for output, which is split in two halves. The
  * first half is the 128-sample output, and the second half is a 128-sample
  * (really, 127) delayed extension, which gets added to the output next time.
@@ -69,13 +81,34 @@ namespace {
  * the first segment is applied directly in the time-domain as the samples come
  * in. Once enough have been retrieved, the FFT is applied on the input and
  * it's paired with the remaining (FFT'd) filter segments for processing.
+ *
+ * Longer impulse responses are split into stages with progressively larger
+ * segments, making it a non-uniform partitioned convolution. The first stage
+ * applies the impulse response up to 2048 samples using 128-sample segments as
+ * described above, the second stage applies it up to 16384 samples using 1024-
+ * sample segments, and the last stage applies the remainder using 8192-sample
+ * segments. A long impulse response needs far fewer complex multiplies per
+ * sample this way than if it only used 128-sample segments.
+ *
+ * Only the first stage is applied on the mixer thread. The later (tail)
+ * stages are handed off to a helper thread, shared by all convolution effects,
+ * once the second stage has a full segment of new input. They start two
+ * segments into the impulse response, so the helper has the time of one
+ * 1024-sample segment to produce their responses before they're needed. The
+ * helper gets a copy of the input segments and writes to a separate output,
+ * which the mixer adds in once a lock-free flag says it's ready. The mixer
+ * never waits on the helper; if the helper hasn't started on a hand-off by the
+ * time it's needed, the mixer takes it back and applies it itself.
  */
 
 
-void LoadSamples(double *RESTRICT dst, const al::byte *src, const size_t srcstep, FmtType srctype,
-    const size_t samples) noexcept
+void LoadSamples(double *RESTRICT dst, const al::byte *src, const size_t srcchan,
+    const size_t srcstep, FmtType srctype, const size_t blockalign, const size_t samples) noexcept
 {
-#define HANDLE_FMT(T)  case T: al::LoadSampleArray<T>(dst, src, srcstep, samples); break
+#define HANDLE_FMT(T)  case T:                                                \
+    al::LoadSampleArray<T>(dst, src + srcchan*BytesFromFmt(T), srcstep,       \
+        samples);                                                             \
+    break
     switch(srctype)
     {
     HANDLE_FMT(FmtUByte);
@@ -84,6 +117,18 @@ void LoadSamples(double *RESTRICT dst, const al::byte *src, const size_t srcstep
     HANDLE_FMT(FmtDouble);
     HANDLE_FMT(FmtMulaw);
     HANDLE_FMT(FmtAlaw);
+    case FmtIMA4:
+    {
+        al::AdpcmState state{};
+        al::LoadIMA4Array(dst, src, srcchan, 0, srcstep, blockalign, samples, state);
+        break;
+    }
+    case FmtMSADPCM:
+    {
+        al::AdpcmState state{};
+        al::LoadMSADPCMArray(dst, src, srcchan, 0, srcstep, blockalign, samples, state);
+        break;
+    }
     }
 #undef HANDLE_FMT
 }
@@ -124,11 +169,16 @@ constexpr float Deg2Rad(float x) noexcept
 { return static_cast<float>(al::numbers::pi / 180.0 * x); }
 
 
-using complex_d = std::complex<double>;
-
 constexpr size_t ConvolveUpdateSize{256};
 constexpr size_t ConvolveUpdateSamples{ConvolveUpdateSize / 2};
 
+/* The segment size of each convolution stage. The first stage starts one
+ * segment into the impulse response and the others start two segments in.
+ * Each stage ends where the next one starts, except the last which holds the
+ * remainder of the impulse response.
+ */
+constexpr std::array<size_t,3> ConvolveStageSizes{{ConvolveUpdateSamples, 1024, 8192}};
+
 
 void apply_fir(al::span<float> dst, const float *RESTRICT src, const float *RESTRICT filter)
 {
@@ -176,6 +226,328 @@ void apply_fir(al::span<float> dst, const float *RESTRICT src, const float *REST
 #endif
 }
 
+/* Multiplies the input segment's bins with the filter segment's bins, adding
+ * to the accumulated bins.
+ */
+void apply_segment(float *RESTRICT accre, float *RESTRICT accim, const float *RESTRICT input,
+    const float *RESTRICT filter, const size_t numbins)
+{
+    const float *RESTRICT inre{input};
+    const float *RESTRICT inim{input + numbins};
+    const float *RESTRICT filterre{filter};
+    const float *RESTRICT filterim{filter + numbins};
+#ifdef HAVE_SSE_INTRINSICS
+    for(size_t i{0};i < numbins;i+=4)
+    {
+        const __m128 ar{_mm_load_ps(&inre[i])}, ai{_mm_load_ps(&inim[i])};
+        const __m128 br{_mm_load_ps(&filterre[i])}, bi{_mm_load_ps(&filterim[i])};
+
+        __m128 r4{_mm_add_ps(_mm_load_ps(&accre[i]), _mm_mul_ps(ar, br))};
+        __m128 i4{_mm_add_ps(_mm_load_ps(&accim[i]), _mm_mul_ps(ar, bi))};
+        r4 = _mm_sub_ps(r4, _mm_mul_ps(ai, bi));
+        i4 = _mm_add_ps(i4, _mm_mul_ps(ai, br));
+        _mm_store_ps(&accre[i], r4);
+        _mm_store_ps(&accim[i], i4);
+    }
+
+#elif defined(HAVE_NEON)
+
+    for(size_t i{0};i < numbins;i+=4)
+    {
+        const float32x4_t ar{vld1q_f32(&inre[i])}, ai{vld1q_f32(&inim[i])};
+        const float32x4_t br{vld1q_f32(&filterre[i])}, bi{vld1q_f32(&filterim[i])};
+
+        float32x4_t r4{vmlaq_f32(vld1q_f32(&accre[i]), ar, br)};
+        float32x4_t i4{vmlaq_f32(vld1q_f32(&accim[i]), ar, bi)};
+        r4 = vmlsq_f32(r4, ai, bi);
+        i4 = vmlaq_f32(i4, ai, br);
+        vst1q_f32(&accre[i], r4);
+        vst1q_f32(&accim[i], i4);
+    }
+
+#else
+
+    for(size_t i{0};i < numbins;++i)
+    {
+        accre[i] += inre[i]*filterre[i] - inim[i]*filterim[i];
+        accim[i] += inre[i]*filterim[i] + inim[i]*filterre[i];
+    }
+#endif
+}
+
+/* The impulse response of a buffer prepared for convolution at a device's
+ * sample rate, with each channel's time-domain FIR for the first segment and
+ * FFT'd segments for each stage. The frequency-domain segments store the real
+ * components of the bins followed by the imaginary components, each padded to
+ * a multiple of 4 for the SIMD complex multiplies.
+ *
+ * Preparing the impulse response is expensive, so it's shared between all
+ * convolution effects that use the same buffer at the same sample rate.
+ */
+struct ConvolutionFilter {
+    struct Key {
+        const BufferStorage *mStorage;
+        uint64_t mVersion;
+        uint mDeviceRate;
+    };
+
+    struct Stage {
+        size_t mStartOffset;
+        size_t mSegmentSamples;
+        size_t mNumSegs;
+        size_t mNumBins;
+
+        /* Each channel's FFT'd segments. */
+        al::vector<float,16> mSegments;
+    };
+
+    RefCount mRef{1u};
+    Key mKey{};
+
+    size_t mNumChannels{0};
+    al::vector<std::array<float,ConvolveUpdateSamples>,16> mFir;
+    al::vector<Stage> mStages;
+
+    void add_ref();
+    void release();
+
+    DEF_NEWDEL(ConvolutionFilter)
+};
+using ConvolutionFilterPtr = al::intrusive_ptr<ConvolutionFilter>;
+
+inline bool operator==(const ConvolutionFilter::Key &lhs, const ConvolutionFilter::Key &rhs)
+    noexcept
+{
+    return lhs.mStorage == rhs.mStorage && lhs.mVersion == rhs.mVersion
+        && lhs.mDeviceRate == rhs.mDeviceRate;
+}
+
+std::mutex FilterCacheLock;
+al::vector<std::unique_ptr<ConvolutionFilter>> FilterCache;
+
+void ConvolutionFilter::add_ref()
+{ IncrementRef(mRef); }
+
+void ConvolutionFilter::release()
+{
+    if(DecrementRef(mRef) == 0)
+    {
+        std::lock_guard<std::mutex> _{FilterCacheLock};
+
+        /* Go through and remove all unused filters. */
+        auto remove_unused = [](std::unique_ptr<ConvolutionFilter> &filter) -> bool
+        {
+            if(ReadRef(filter->mRef) == 0)
+            {
+                TRACE("Freeing unused convolution filter %p\n",
+                    decltype(std::declval<void*>()){filter.get()});
+                filter = nullptr;
+                return true;
+            }
+            return false;
+        };
+        auto iter = std::remove_if(FilterCache.begin(), FilterCache.end(), remove_unused);
+        FilterCache.erase(iter, FilterCache.end());
+    }
+}
+
+
+std::unique_ptr<ConvolutionFilter> PrepareFilter(const ConvolutionFilter::Key &key,
+    const EffectState::Buffer &buffer, const size_t numChannels)
+{
+    auto filter = std::make_unique<ConvolutionFilter>();
+    filter->mKey = key;
+    filter->mNumChannels = numChannels;
+
+    const uint devrate{key.mDeviceRate};
+    auto realChannels = ChannelsFromFmt(buffer.storage->mChannels, buffer.storage->mAmbiOrder);
+
+    /* The impulse response needs to have the same sample rate as the input and
+     * output. The bsinc24 resampler is decent, but there is high-frequency
+     * attenation that some people may be able to pick up on. Since this is
+     * called very infrequently, go ahead and use the polyphase resampler.
+     */
+    PPhaseResampler resampler;
+    if(devrate != buffer.storage->mSampleRate)
+        resampler.init(buffer.storage->mSampleRate, devrate);
+    const auto resampledCount = static_cast<uint>(
+        (uint64_t{buffer.storage->mSampleLen}*devrate+(buffer.storage->mSampleRate-1)) /
+        buffer.storage->mSampleRate);
+
+    filter->mFir.resize(numChannels, {});
+
+    /* Calculate the number of segments each stage needs to hold its part of
+     * the impulse response (rounded up), and allocate them. The first stage
+     * excludes one segment which gets applied as a time-domain FIR filter.
+     * Make sure the first stage has at least one segment allocated to simplify
+     * handling.
+     */
+    for(size_t i{0};i < ConvolveStageSizes.size();++i)
+    {
+        const size_t segsamples{ConvolveStageSizes[i]};
+        const size_t start{segsamples * (i ? 2u : 1u)};
+        if(i > 0 && resampledCount <= start)
+            break;
+
+        const size_t end{(i+1 < ConvolveStageSizes.size()) ?
+            minz(resampledCount, ConvolveStageSizes[i+1]*2) : resampledCount};
+        const size_t numsegs{(end - minz(end, start) + (segsamples-1)) / segsamples};
+
+        filter->mStages.emplace_back();
+        ConvolutionFilter::Stage &stage = filter->mStages.back();
+        stage.mStartOffset = start;
+        stage.mSegmentSamples = segsamples;
+        stage.mNumSegs = maxz(numsegs, 1);
+        stage.mNumBins = (segsamples+1 + 3) & ~size_t{3};
+        stage.mSegments.resize(stage.mNumSegs * stage.mNumBins*2 * numChannels, 0.0f);
+    }
+
+    auto srcsamples = std::make_unique<double[]>(maxz(buffer.storage->mSampleLen, resampledCount));
+    al::vector<float,16> fftbuffer;
+    for(size_t c{0};c < numChannels;++c)
+    {
+        /* Load the samples from the buffer, and resample to match the device. */
+        LoadSamples(srcsamples.get(), buffer.samples.data(), c, realChannels,
+            buffer.storage->mType, buffer.storage->mBlockAlign, buffer.storage->mSampleLen);
+        if(devrate != buffer.storage->mSampleRate)
+            resampler.process(buffer.storage->mSampleLen, srcsamples.get(), resampledCount,
+                srcsamples.get());
+
+        /* Store the first segment's samples in reverse in the time-domain, to
+         * apply as a FIR filter.
+         */
+        const size_t first_size{minz(resampledCount, ConvolveUpdateSamples)};
+        std::transform(srcsamples.get(), srcsamples.get()+first_size, filter->mFir[c].rbegin(),
+            [](const double d) noexcept -> float { return static_cast<float>(d); });
+
+        /* Apply an FFT to each of the stages' segments. */
+        for(auto &stage : filter->mStages)
+        {
+            const size_t segsamples{stage.mSegmentSamples};
+            const size_t segsize{stage.mNumBins * 2};
+            RealFftPlan fft{segsamples*2};
+            fftbuffer.resize(segsamples*2);
+
+            float *filteriter{stage.mSegments.data() + c*stage.mNumSegs*segsize};
+            for(size_t s{0};s < stage.mNumSegs;++s)
+            {
+                const size_t start{minz(stage.mStartOffset + s*segsamples, resampledCount)};
+                const size_t todo{minz(resampledCount-start, segsamples)};
+
+                const double *segstart{srcsamples.get() + start};
+                auto iter = std::transform(segstart, segstart+todo, fftbuffer.begin(),
+                    [](const double d) noexcept -> float { return static_cast<float>(d); });
+                std::fill(iter, fftbuffer.end(), 0.0f);
+
+                fft.forward(fftbuffer.data(), filteriter, filteriter+stage.mNumBins);
+                filteriter += segsize;
+            }
+        }
+    }
+
+    TRACE("Prepared convolution filter %p (%zu channel%s, %u samples, %zu stage%s)\n",
+        decltype(std::declval<void*>()){filter.get()}, numChannels,
+        (numChannels==1) ? "" : "s", resampledCount, filter->mStages.size(),
+        (filter->mStages.size()==1) ? "" : "s");
+    return filter;
+}
+
+/* Gets the prepared impulse response for the buffer at the device's sample
+ * rate, preparing it if it's not already in use. The buffer's version changes
+ * along with its samples, so a buffer that's given new samples gets a newly
+ * prepared filter.
+ */
+ConvolutionFilterPtr GetConvolutionFilter(const uint devrate, const EffectState::Buffer &buffer,
+    const size_t numChannels)
+{
+    const ConvolutionFilter::Key key{buffer.storage, buffer.version, devrate};
+
+    auto find_filter = [&key]() -> ConvolutionFilterPtr
+    {
+        for(auto &filter : FilterCache)
+        {
+            if(filter->mKey == key)
+            {
+                filter->add_ref();
+                return ConvolutionFilterPtr{filter.get()};
+            }
+        }
+        return nullptr;
+    };
+
+    {
+        std::lock_guard<std::mutex> _{FilterCacheLock};
+        if(auto filter = find_filter())
+            return filter;
+    }
+
+    /* Prepare the filter without holding the lock, so other effects don't
+     * have to wait on it. Another effect may have prepared the same filter in
+     * the meantime, in which case use that one instead.
+     */
+    auto newfilter = PrepareFilter(key, buffer, numChannels);
+
+    std::lock_guard<std::mutex> _{FilterCacheLock};
+    if(auto filter = find_filter())
+        return filter;
+    FilterCache.emplace_back(std::move(newfilter));
+    return ConvolutionFilterPtr{FilterCache.back().get()};
+}
+
+
+struct ConvolutionState;
+
+/* A helper thread shared by all convolution effects with tail stages, which
+ * runs while any are registered with it. The mixer signals it after handing
+ * off a tail update, and it applies each registered effect's pending one.
+ */
+class ConvolveTailWorker {
+    std::mutex mThreadLock;
+    std::mutex mStateLock;
+    al::vector<ConvolutionState*> mStates;
+    al::semaphore mSem;
+    std::atomic<bool> mQuit{false};
+    std::thread mThread;
+
+    void run();
+
+public:
+    /* Registers the effect, starting the thread if needed. Returns false if
+     * the thread can't be started.
+     */
+    bool add(ConvolutionState *state);
+    /* Unregisters the effect, after which the thread won't access it. */
+    void remove(ConvolutionState *state);
+
+    void notify() { mSem.post(); }
+};
+
+/* Never destroyed, since effects may still be registered at exit. */
+ConvolveTailWorker &GetTailWorker()
+{
+    static auto *worker = new ConvolveTailWorker{};
+    return *worker;
+}
+
+
+/* A uniformly partitioned stage of the convolution, applying the filter's
+ * segments to the history of FFT'd input segments.
+ */
+struct ConvolveStage {
+    size_t mStartOffset{0};
+    size_t mSegmentSamples{0};
+    size_t mNumSegs{0};
+    size_t mNumBins{0};
+    size_t mCurrentSegment{0};
+
+    RealFftPlan mFft;
+    al::vector<float,16> mFftBuffer;
+    al::vector<float,16> mFftBins;
+
+    al::vector<float,16> mHistory;
+    const float *mFilter{nullptr};
+};
+
 struct ConvolutionState final : public EffectState {
     FmtChannels mChannels{};
     AmbiLayout mAmbiLayout{};
@@ -184,13 +556,48 @@ struct ConvolutionState final : public EffectState {
 
     size_t mFifoPos{0};
     std::array<float,ConvolveUpdateSamples*2> mInput{};
-    al::vector<std::array<float,ConvolveUpdateSamples>,16> mFilter;
-    al::vector<std::array<float,ConvolveUpdateSamples*2>,16> mOutput;
-
-    alignas(16) std::array<complex_d,ConvolveUpdateSize> mFftBuffer{};
+    ConvolutionFilterPtr mFilter;
 
-    size_t mCurrentSegment{0};
-    size_t mNumConvolveSegs{0};
+    /* The input history for the stages to get their segments from, and the
+     * accumulated output of the first stage and of the tail stages for each
+     * channel. The tail stages write their responses to the back output,
+     * which gets added to the tail output once they're done.
+     */
+    al::vector<float,16> mStageInput;
+    size_t mStageInputPos{0};
+    al::vector<float,16> mOutput;
+    al::vector<float,16> mTailOutput;
+    al::vector<float,16> mTailBackOutput;
+    size_t mTailOutputSize{0};
+    uint mTailSamples{0};
+    size_t mOutputPos{0};
+    uint64_t mOutputCount{0};
+    size_t mUpdateCount{0};
+
+    al::vector<ConvolveStage> mStages;
+
+    /* A hand-off of the tail stages, with their input segments copied for the
+     * helper. A hand-off is deferred while the helper is still busy with the
+     * last one.
+     */
+    struct TailUpdate {
+        size_t mCount;
+        size_t mOutputPos;
+        uint64_t mOutputCount;
+    };
+    enum TailState : uint {
+        TailIdle,
+        TailQueued,
+        TailRunning,
+        TailDone
+    };
+    std::atomic<uint> mTailState{TailIdle};
+    bool mTailWorker{false};
+    TailUpdate mTailUpdate{};
+    al::vector<float,16> mTailInput;
+    bool mTailDeferred{false};
+    TailUpdate mDeferredUpdate{};
+    al::vector<float,16> mDeferredInput;
 
     struct ChannelData {
         alignas(16) FloatBufferLine mBuffer{};
@@ -201,22 +608,30 @@ struct ConvolutionState final : public EffectState {
     };
     using ChannelDataArray = al::FlexArray<ChannelData>;
     std::unique_ptr<ChannelDataArray> mChans;
-    std::unique_ptr<complex_d[]> mComplexData;
 
 
     ConvolutionState() = default;
-    ~ConvolutionState() override = default;
+    ~ConvolutionState() override { stopTail(); }
 
     void NormalMix(const al::span<FloatBufferLine> samplesOut, const size_t samplesToDo);
     void UpsampleMix(const al::span<FloatBufferLine> samplesOut, const size_t samplesToDo);
     void (ConvolutionState::*mMix)(const al::span<FloatBufferLine>,const size_t)
     {&ConvolutionState::NormalMix};
 
+    void processStage(ConvolveStage &stage, const float *input, float *output,
+        const size_t outsize, const size_t outpos);
+    void processTail(const TailUpdate &update, const float *input);
+    void mergeTail(const TailUpdate &update);
+    void updateTail();
+    void runTail();
+    void stopTail();
+
     void deviceUpdate(const DeviceBase *device, const Buffer &buffer) override;
     void update(const ContextBase *context, const EffectSlot *slot, const EffectProps *props,
         const EffectTarget target) override;
     void process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn,
         const al::span<FloatBufferLine> samplesOut) override;
+    uint tailLength() const noexcept override { return mTailSamples; }
 
     DEF_NEWDEL(ConvolutionState)
 };
@@ -245,96 +660,98 @@ void ConvolutionState::deviceUpdate(const DeviceBase *device, const Buffer &buff
 {
     constexpr uint MaxConvolveAmbiOrder{1u};
 
+    stopTail();
+
     mFifoPos = 0;
     mInput.fill(0.0f);
-    decltype(mFilter){}.swap(mFilter);
+    mFilter = nullptr;
+    decltype(mStageInput){}.swap(mStageInput);
+    mStageInputPos = 0;
     decltype(mOutput){}.swap(mOutput);
-    mFftBuffer.fill(complex_d{});
-
-    mCurrentSegment = 0;
-    mNumConvolveSegs = 0;
+    decltype(mTailOutput){}.swap(mTailOutput);
+    decltype(mTailBackOutput){}.swap(mTailBackOutput);
+    mTailOutputSize = 0;
+    mTailSamples = 0;
+    mOutputPos = 0;
+    mOutputCount = 0;
+    mUpdateCount = 0;
+    mTailState.store(TailIdle, std::memory_order_relaxed);
+    decltype(mTailInput){}.swap(mTailInput);
+    mTailDeferred = false;
+    decltype(mDeferredInput){}.swap(mDeferredInput);
+    decltype(mStages){}.swap(mStages);
 
     mChans = nullptr;
-    mComplexData = nullptr;
 
     /* An empty buffer doesn't need a convolution filter. */
     if(!buffer.storage || buffer.storage->mSampleLen < 1) return;
 
-    constexpr size_t m{ConvolveUpdateSize/2 + 1};
-    auto bytesPerSample = BytesFromFmt(buffer.storage->mType);
-    auto realChannels = ChannelsFromFmt(buffer.storage->mChannels, buffer.storage->mAmbiOrder);
     auto numChannels = ChannelsFromFmt(buffer.storage->mChannels,
         minu(buffer.storage->mAmbiOrder, MaxConvolveAmbiOrder));
 
     mChans = ChannelDataArray::Create(numChannels);
 
-    /* The impulse response needs to have the same sample rate as the input and
-     * output. The bsinc24 resampler is decent, but there is high-frequency
-     * attenation that some people may be able to pick up on. Since this is
-     * called very infrequently, go ahead and use the polyphase resampler.
-     */
-    PPhaseResampler resampler;
-    if(device->Frequency != buffer.storage->mSampleRate)
-        resampler.init(buffer.storage->mSampleRate, device->Frequency);
-    const auto resampledCount = static_cast<uint>(
-        (uint64_t{buffer.storage->mSampleLen}*device->Frequency+(buffer.storage->mSampleRate-1)) /
-        buffer.storage->mSampleRate);
-
     const BandSplitter splitter{device->mXOverFreq / static_cast<float>(device->Frequency)};
     for(auto &e : *mChans)
         e.mFilter = splitter;
 
-    mFilter.resize(numChannels, {});
-    mOutput.resize(numChannels, {});
+    mFilter = GetConvolutionFilter(device->Frequency, buffer, numChannels);
+    mOutput.resize(ConvolveUpdateSamples*2 * numChannels, 0.0f);
 
-    /* Calculate the number of segments needed to hold the impulse response and
-     * the input history (rounded up), and allocate them. Exclude one segment
-     * which gets applied as a time-domain FIR filter. Make sure at least one
-     * segment is allocated to simplify handling.
+    /* Allocate the input history for each of the filter's stages. */
+    for(const auto &filterstage : mFilter->mStages)
+    {
+        const size_t segsamples{filterstage.mSegmentSamples};
+
+        mStages.emplace_back();
+        ConvolveStage &stage = mStages.back();
+        stage.mStartOffset = filterstage.mStartOffset;
+        stage.mSegmentSamples = segsamples;
+        stage.mNumSegs = filterstage.mNumSegs;
+        stage.mNumBins = filterstage.mNumBins;
+        stage.mFft = RealFftPlan{segsamples*2};
+        stage.mFftBuffer.resize(segsamples*2, 0.0f);
+        stage.mFftBins.resize(stage.mNumBins*2, 0.0f);
+        stage.mHistory.resize(stage.mNumSegs * stage.mNumBins*2, 0.0f);
+        stage.mFilter = filterstage.mSegments.data();
+    }
+
+    /* The stage input needs to hold the largest segment, which gets copied
+     * for the tail stages when handing them off. The tail output needs to
+     * hold the tail stages' responses from the end of their first segment,
+     * along with the output that gets mixed while a hand-off is pending.
      */
-    mNumConvolveSegs = (resampledCount+(ConvolveUpdateSamples-1)) / ConvolveUpdateSamples;
-    mNumConvolveSegs = maxz(mNumConvolveSegs, 2) - 1;
+    const size_t tailupdate{(mStages.size() > 1) ? mStages[1].mSegmentSamples : 0};
+    mStageInput.resize(NextPowerOf2(static_cast<uint>(mStages.back().mSegmentSamples)), 0.0f);
+    if(mStages.size() > 1)
+    {
+        const ConvolveStage &last = mStages.back();
+        mTailOutputSize = NextPowerOf2(static_cast<uint>(last.mStartOffset +
+            last.mSegmentSamples + tailupdate*2));
+        mTailOutput.resize(mTailOutputSize * numChannels, 0.0f);
+        mTailBackOutput.resize(mTailOutputSize * numChannels, 0.0f);
+
+        size_t tailinput{0};
+        for(size_t i{1};i < mStages.size();++i)
+            tailinput += mStages[i].mSegmentSamples;
+        mTailInput.resize(tailinput, 0.0f);
+        mDeferredInput.resize(tailinput, 0.0f);
+    }
 
-    const size_t complex_length{mNumConvolveSegs * m * (numChannels+1)};
-    mComplexData = std::make_unique<complex_d[]>(complex_length);
-    std::fill_n(mComplexData.get(), complex_length, complex_d{});
+    /* The output lasts until the end of the last stage's segments, delayed by
+     * the input FIFO and the helper thread's update.
+     */
+    const ConvolveStage &last = mStages.back();
+    mTailSamples = static_cast<uint>(last.mStartOffset + last.mNumSegs*last.mSegmentSamples +
+        ConvolveUpdateSamples + tailupdate);
 
     mChannels = buffer.storage->mChannels;
     mAmbiLayout = buffer.storage->mAmbiLayout;
     mAmbiScaling = buffer.storage->mAmbiScaling;
     mAmbiOrder = minu(buffer.storage->mAmbiOrder, MaxConvolveAmbiOrder);
 
-    auto srcsamples = std::make_unique<double[]>(maxz(buffer.storage->mSampleLen, resampledCount));
-    complex_d *filteriter = mComplexData.get() + mNumConvolveSegs*m;
-    for(size_t c{0};c < numChannels;++c)
-    {
-        /* Load the samples from the buffer, and resample to match the device. */
-        LoadSamples(srcsamples.get(), buffer.samples.data() + bytesPerSample*c, realChannels,
-            buffer.storage->mType, buffer.storage->mSampleLen);
-        if(device->Frequency != buffer.storage->mSampleRate)
-            resampler.process(buffer.storage->mSampleLen, srcsamples.get(), resampledCount,
-                srcsamples.get());
-
-        /* Store the first segment's samples in reverse in the time-domain, to
-         * apply as a FIR filter.
-         */
-        const size_t first_size{minz(resampledCount, ConvolveUpdateSamples)};
-        std::transform(srcsamples.get(), srcsamples.get()+first_size, mFilter[c].rbegin(),
-            [](const double d) noexcept -> float { return static_cast<float>(d); });
-
-        size_t done{first_size};
-        for(size_t s{0};s < mNumConvolveSegs;++s)
-        {
-            const size_t todo{minz(resampledCount-done, ConvolveUpdateSamples)};
-
-            auto iter = std::copy_n(&srcsamples[done], todo, mFftBuffer.begin());
-            done += todo;
-            std::fill(iter, mFftBuffer.end(), complex_d{});
-
-            forward_fft(mFftBuffer);
-            filteriter = std::copy_n(mFftBuffer.cbegin(), m, filteriter);
-        }
-    }
+    if(mStages.size() > 1)
+        mTailWorker = GetTailWorker().add(this);
 }
 
 
@@ -388,7 +805,7 @@ void ConvolutionState::update(const ContextBase *context, const EffectSlot *slot
         { SideRight,   Deg2Rad(  90.0f), Deg2Rad(0.0f) }
     };
 
-    if(mNumConvolveSegs < 1)
+    if(mStages.empty())
         return;
 
     mMix = &ConvolutionState::NormalMix;
@@ -492,14 +909,271 @@ void ConvolutionState::update(const ContextBase *context, const EffectSlot *slot
     }
 }
 
+void ConvolutionState::processStage(ConvolveStage &stage, const float *input, float *output,
+    const size_t outsize, const size_t outpos)
+{
+    const size_t segsamples{stage.mSegmentSamples};
+    const size_t segsize{stage.mNumBins * 2};
+    float *RESTRICT fftbuffer{stage.mFftBuffer.data()};
+
+    /* Get the stage's newest segment of input, and add its frequency-domain
+     * response to the stage's history.
+     */
+    std::copy_n(input, segsamples, fftbuffer);
+    std::fill_n(fftbuffer+segsamples, segsamples, 0.0f);
+
+    const size_t curseg{stage.mCurrentSegment};
+    float *history{&stage.mHistory[curseg*segsize]};
+    stage.mFft.forward(fftbuffer, history, history+stage.mNumBins);
+
+    float *RESTRICT accre{stage.mFftBins.data()};
+    float *RESTRICT accim{accre + stage.mNumBins};
+    const float *RESTRICT filter{stage.mFilter};
+    for(size_t c{0};c < mChans->size();++c)
+    {
+        std::fill(stage.mFftBins.begin(), stage.mFftBins.end(), 0.0f);
+
+        /* Convolve each input segment with its IR filter counterpart
+         * (aligned in time).
+         */
+        const float *RESTRICT segment{history};
+        for(size_t s{curseg};s < stage.mNumSegs;++s)
+        {
+            apply_segment(accre, accim, segment, filter, stage.mNumBins);
+            segment += segsize;
+            filter += segsize;
+        }
+        segment = stage.mHistory.data();
+        for(size_t s{0};s < curseg;++s)
+        {
+            apply_segment(accre, accim, segment, filter, stage.mNumBins);
+            segment += segsize;
+            filter += segsize;
+        }
+
+        /* Apply iFFT to get the time-domain response, twice the segment size
+         * (really, one less). The response is delayed by however much the
+         * stage starts past the end of the input segment, and added to the
+         * other stages' responses.
+         */
+        stage.mFft.inverse(accre, accim, fftbuffer);
+
+        /* The iFFT'd response is scaled up by the number of bins, so apply
+         * the inverse to normalize the output.
+         */
+        const float scale{1.0f / static_cast<float>(segsamples*2)};
+        float *RESTRICT chanout{output + c*outsize};
+        size_t writepos{(outpos + stage.mStartOffset - segsamples) & (outsize-1)};
+        for(size_t i{0};i < segsamples*2;)
+        {
+            const size_t todo{minz(segsamples*2 - i, outsize-writepos)};
+            for(size_t j{0};j < todo;++j)
+                chanout[writepos+j] += fftbuffer[i+j] * scale;
+            writepos = (writepos+todo) & (outsize-1);
+            i += todo;
+        }
+    }
+
+    /* Shift the input history. */
+    stage.mCurrentSegment = curseg ? (curseg-1) : (stage.mNumSegs-1);
+}
+
+void ConvolutionState::processTail(const TailUpdate &update, const float *input)
+{
+    for(size_t i{1};i < mStages.size();++i)
+    {
+        ConvolveStage &stage = mStages[i];
+        const size_t updates{stage.mSegmentSamples / ConvolveUpdateSamples};
+        if((update.mCount & (updates-1)) == 0)
+            processStage(stage, input, mTailBackOutput.data(), mTailOutputSize,
+                update.mOutputPos);
+        input += stage.mSegmentSamples;
+    }
+}
+
+/* Adds a finished hand-off's responses to the tail output, clearing them from
+ * the back output. Any part that should already have been mixed is dropped.
+ */
+void ConvolutionState::mergeTail(const TailUpdate &update)
+{
+    const size_t outmask{mTailOutputSize - 1};
+    for(size_t i{1};i < mStages.size();++i)
+    {
+        const ConvolveStage &stage = mStages[i];
+        const size_t updates{stage.mSegmentSamples / ConvolveUpdateSamples};
+        if((update.mCount & (updates-1)) != 0)
+            continue;
+
+        const uint64_t start{update.mOutputCount + stage.mStartOffset - stage.mSegmentSamples};
+        const size_t skip{static_cast<size_t>(minu64(mOutputCount - minu64(mOutputCount, start),
+            stage.mSegmentSamples*2))};
+        for(size_t c{0};c < mChans->size();++c)
+        {
+            float *RESTRICT backout{mTailBackOutput.data() + c*mTailOutputSize};
+            float *RESTRICT chanout{mTailOutput.data() + c*mTailOutputSize};
+            size_t pos{(update.mOutputPos + stage.mStartOffset - stage.mSegmentSamples) & outmask};
+            for(size_t j{0};j < stage.mSegmentSamples*2;++j)
+            {
+                if(j >= skip)
+                    chanout[pos] += backout[pos];
+                backout[pos] = 0.0f;
+                pos = (pos+1) & outmask;
+            }
+        }
+    }
+}
+
+/* Called by the mixer after each update, to add the tail stages' responses
+ * when they're ready and to hand them off when they have new input.
+ */
+void ConvolutionState::updateTail()
+{
+    if(mTailState.load(std::memory_order_acquire) == TailDone)
+    {
+        mergeTail(mTailUpdate);
+        mTailState.store(TailIdle, std::memory_order_relaxed);
+    }
+
+    const size_t updates{mStages[1].mSegmentSamples / ConvolveUpdateSamples};
+    if((mUpdateCount & (updates-1)) == 0)
+    {
+        /* The last hand-off's response is needed from the next output onward.
+         * If the helper hasn't started on it, take it back and apply it here.
+         * If the helper is in the middle of it, it gets added late when done.
+         */
+        uint expected{TailQueued};
+        if(mTailState.compare_exchange_strong(expected, TailRunning, std::memory_order_acquire,
+            std::memory_order_relaxed))
+        {
+            processTail(mTailUpdate, mTailInput.data());
+            mergeTail(mTailUpdate);
+            mTailState.store(TailIdle, std::memory_order_relaxed);
+        }
+
+        /* Copy the tail stages' newest input segments. An earlier hand-off
+         * still deferred by a busy helper is replaced, rather than waiting on
+         * it.
+         */
+        const size_t inmask{mStageInput.size() - 1};
+        float *dst{mDeferredInput.data()};
+        for(size_t i{1};i < mStages.size();++i)
+        {
+            const size_t segsamples{mStages[i].mSegmentSamples};
+            size_t readpos{(mStageInputPos - segsamples) & inmask};
+            for(size_t j{0};j < segsamples;)
+            {
+                const size_t todo{minz(segsamples-j, mStageInput.size()-readpos)};
+                std::copy_n(mStageInput.cbegin()+readpos, todo, dst+j);
+                readpos = (readpos+todo) & inmask;
+                j += todo;
+            }
+            dst += segsamples;
+        }
+        mDeferredUpdate = TailUpdate{mUpdateCount, mOutputPos, mOutputCount};
+        mTailDeferred = true;
+    }
+
+    if(mTailDeferred && mTailState.load(std::memory_order_relaxed) == TailIdle)
+    {
+        mTailDeferred = false;
+        mTailUpdate = mDeferredUpdate;
+        mTailInput.swap(mDeferredInput);
+        if(!mTailWorker)
+        {
+            processTail(mTailUpdate, mTailInput.data());
+            mergeTail(mTailUpdate);
+        }
+        else
+        {
+            mTailState.store(TailQueued, std::memory_order_release);
+            GetTailWorker().notify();
+        }
+    }
+}
+
+/* Called by the helper thread to apply a pending hand-off. */
+void ConvolutionState::runTail()
+{
+    uint expected{TailQueued};
+    if(!mTailState.compare_exchange_strong(expected, TailRunning, std::memory_order_acquire,
+        std::memory_order_relaxed))
+        return;
+
+    processTail(mTailUpdate, mTailInput.data());
+    mTailState.store(TailDone, std::memory_order_release);
+}
+
+void ConvolutionState::stopTail()
+{
+    if(!mTailWorker)
+        return;
+
+    GetTailWorker().remove(this);
+    mTailWorker = false;
+}
+
+
+bool ConvolveTailWorker::add(ConvolutionState *state)
+{
+    std::lock_guard<std::mutex> _{mThreadLock};
+    if(!mThread.joinable())
+    {
+        try {
+            mQuit.store(false, std::memory_order_relaxed);
+            mThread = std::thread{std::mem_fn(&ConvolveTailWorker::run), this};
+        }
+        catch(std::exception& e) {
+            ERR("Failed to start convolution tail thread: %s\n", e.what());
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> __{mStateLock};
+    mStates.emplace_back(state);
+    return true;
+}
+
+void ConvolveTailWorker::remove(ConvolutionState *state)
+{
+    std::lock_guard<std::mutex> _{mThreadLock};
+    {
+        std::lock_guard<std::mutex> __{mStateLock};
+        auto iter = std::find(mStates.begin(), mStates.end(), state);
+        if(iter != mStates.end())
+            mStates.erase(iter);
+        if(!mStates.empty())
+            return;
+    }
+
+    mQuit.store(true, std::memory_order_release);
+    mSem.post();
+    mThread.join();
+}
+
+FORCE_ALIGN void ConvolveTailWorker::run()
+{
+    SetRTPriority();
+    althrd_setname(CONVOLVE_TAIL_THREAD_NAME);
+
+    FPUCtl mixer_mode{};
+    while(true)
+    {
+        mSem.wait();
+        if(mQuit.load(std::memory_order_acquire))
+            break;
+
+        std::lock_guard<std::mutex> _{mStateLock};
+        for(ConvolutionState *state : mStates)
+            state->runTail();
+    }
+}
+
 void ConvolutionState::process(const size_t samplesToDo,
     const al::span<const FloatBufferLine> samplesIn, const al::span<FloatBufferLine> samplesOut)
 {
-    if(mNumConvolveSegs < 1)
+    if(mStages.empty())
         return;
 
-    constexpr size_t m{ConvolveUpdateSize/2 + 1};
-    size_t curseg{mCurrentSegment};
     auto &chans = *mChans;
 
     for(size_t base{0u};base < samplesToDo;)
@@ -516,10 +1190,17 @@ void ConvolutionState::process(const size_t samplesToDo,
         {
             auto buf_iter = chans[c].mBuffer.begin() + base;
             apply_fir({std::addressof(*buf_iter), todo}, mInput.data()+1 + mFifoPos,
-                mFilter[c].data());
+                mFilter->mFir[c].data());
 
-            auto fifo_iter = mOutput[c].begin() + mFifoPos;
+            const size_t outpos{mOutputPos + mFifoPos};
+            auto fifo_iter = mOutput.cbegin() + c*ConvolveUpdateSamples*2 +
+                (outpos & (ConvolveUpdateSamples*2 - 1));
             std::transform(fifo_iter, fifo_iter+todo, buf_iter, buf_iter, std::plus<>{});
+            if(!mTailOutput.empty())
+            {
+                auto tail_iter = mTailOutput.cbegin() + c*mTailOutputSize + outpos;
+                std::transform(tail_iter, tail_iter+todo, buf_iter, buf_iter, std::plus<>{});
+            }
         }
 
         mFifoPos += todo;
@@ -529,69 +1210,42 @@ void ConvolutionState::process(const size_t samplesToDo,
         if(mFifoPos < ConvolveUpdateSamples) break;
         mFifoPos = 0;
 
-        /* Move the newest input to the front for the next iteration's history. */
+        /* Move the newest input to the front for the next iteration's history,
+         * and add it to the stages' input.
+         */
         std::copy(mInput.cbegin()+ConvolveUpdateSamples, mInput.cend(), mInput.begin());
+        std::copy_n(mInput.cbegin(), ConvolveUpdateSamples, mStageInput.begin()+mStageInputPos);
+        mStageInputPos = (mStageInputPos+ConvolveUpdateSamples) & (mStageInput.size()-1);
 
-        /* Calculate the frequency domain response and add the relevant
-         * frequency bins to the FFT history.
+        /* Clear the output that was just mixed, so it can accumulate the
+         * stages' responses again.
          */
-        auto fftiter = std::copy_n(mInput.cbegin(), ConvolveUpdateSamples, mFftBuffer.begin());
-        std::fill(fftiter, mFftBuffer.end(), complex_d{});
-        forward_fft(mFftBuffer);
-
-        std::copy_n(mFftBuffer.cbegin(), m, &mComplexData[curseg*m]);
-
-        const complex_d *RESTRICT filter{mComplexData.get() + mNumConvolveSegs*m};
         for(size_t c{0};c < chans.size();++c)
         {
-            std::fill_n(mFftBuffer.begin(), m, complex_d{});
-
-            /* Convolve each input segment with its IR filter counterpart
-             * (aligned in time).
-             */
-            const complex_d *RESTRICT input{&mComplexData[curseg*m]};
-            for(size_t s{curseg};s < mNumConvolveSegs;++s)
-            {
-                for(size_t i{0};i < m;++i,++input,++filter)
-                    mFftBuffer[i] += *input * *filter;
-            }
-            input = mComplexData.get();
-            for(size_t s{0};s < curseg;++s)
-            {
-                for(size_t i{0};i < m;++i,++input,++filter)
-                    mFftBuffer[i] += *input * *filter;
-            }
-
-            /* Reconstruct the mirrored/negative frequencies to do a proper
-             * inverse FFT.
-             */
-            for(size_t i{m};i < ConvolveUpdateSize;++i)
-                mFftBuffer[i] = std::conj(mFftBuffer[ConvolveUpdateSize-i]);
-
-            /* Apply iFFT to get the 256 (really 255) samples for output. The
-             * 128 output samples are combined with the last output's 127
-             * second-half samples (and this output's second half is
-             * subsequently saved for next time).
-             */
-            inverse_fft(mFftBuffer);
-
-            /* The iFFT'd response is scaled up by the number of bins, so apply
-             * the inverse to normalize the output.
-             */
-            for(size_t i{0};i < ConvolveUpdateSamples;++i)
-                mOutput[c][i] =
-                    static_cast<float>(mFftBuffer[i].real() * (1.0/double{ConvolveUpdateSize})) +
-                    mOutput[c][ConvolveUpdateSamples+i];
-            for(size_t i{0};i < ConvolveUpdateSamples;++i)
-                mOutput[c][ConvolveUpdateSamples+i] =
-                    static_cast<float>(mFftBuffer[ConvolveUpdateSamples+i].real() *
-                        (1.0/double{ConvolveUpdateSize}));
+            const size_t headpos{mOutputPos & (ConvolveUpdateSamples*2 - 1)};
+            std::fill_n(mOutput.begin() + c*ConvolveUpdateSamples*2 + headpos,
+                ConvolveUpdateSamples, 0.0f);
+            if(!mTailOutput.empty())
+                std::fill_n(mTailOutput.begin() + c*mTailOutputSize + mOutputPos,
+                    ConvolveUpdateSamples, 0.0f);
         }
+        const size_t outsize{mTailOutput.empty() ? ConvolveUpdateSamples*2 : mTailOutputSize};
+        mOutputPos = (mOutputPos+ConvolveUpdateSamples) & (outsize-1);
+        mOutputCount += ConvolveUpdateSamples;
+
+        /* Apply the first stage, which gets the new input's response from the
+         * next output onward.
+         */
+        processStage(mStages[0], mInput.data(), mOutput.data(), ConvolveUpdateSamples*2,
+            mOutputPos & (ConvolveUpdateSamples*2 - 1));
 
-        /* Shift the input history. */
-        curseg = curseg ? (curseg-1) : (mNumConvolveSegs-1);
+        /* Add the tail stages' responses, and hand them off to the helper
+         * thread when the second stage has a full segment of new input.
+         */
+        ++mUpdateCount;
+        if(mStages.size() > 1)
+            updateTail();
     }
-    mCurrentSegment = curseg;
 
     /* Finally, mix to the output. */
     (this->*mMix)(samplesOut, samplesToDo);
@@ -52,6 +52,7 @@ struct DedicatedState final : public EffectState {
         const EffectTarget target) override;
     void process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn,
         const al::span<FloatBufferLine> samplesOut) override;
+    uint tailLength() const noexcept override { return 0; }
 
     DEF_NEWDEL(DedicatedState)
 };
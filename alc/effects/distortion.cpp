@@ -52,6 +52,7 @@ struct DistortionState final : public EffectState {
     BiquadFilter mBandpass;
     float mAttenuation{};
     float mEdgeCoeff{};
+    uint mTailSamples{};
 
     float mBuffer[2][BufferLineSize]{};
 
@@ -61,6 +62,7 @@ struct DistortionState final : public EffectState {
         const EffectTarget target) override;
     void process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn,
         const al::span<FloatBufferLine> samplesOut) override;
+    uint tailLength() const noexcept override { return mTailSamples; }
 
     DEF_NEWDEL(DistortionState)
 };
@@ -95,6 +97,11 @@ void DistortionState::update(const ContextBase *context, const EffectSlot *slot,
     bandwidth = props->Distortion.EQBandwidth / (cutoff * 0.67f);
     mBandpass.setParamsFromBandwidth(BiquadType::BandPass, cutoff/frequency/4.0f, 1.0f, bandwidth);
 
+    /* The filters run at the oversampled rate, one after the other. */
+    const uint lpdecay{minu(mLowpass.decaySamples(EffectTailGain), InfiniteEffectTail/8)};
+    const uint bpdecay{minu(mBandpass.decaySamples(EffectTailGain), InfiniteEffectTail/8)};
+    mTailSamples = (lpdecay+bpdecay+3) / 4;
+
     const auto coeffs = CalcDirectionCoeffs({0.0f, 0.0f, -1.0f}, 0.0f);
 
     mOutTarget = target.Main->Buffer;
@@ -66,6 +66,7 @@ struct EchoState final : public EffectState {
 
     BiquadFilter mFilter;
     float mFeedGain{0.0f};
+    uint mTailSamples{0u};
 
     alignas(16) float mTempBuffer[2][BufferLineSize];
 
@@ -74,6 +75,7 @@ struct EchoState final : public EffectState {
         const EffectTarget target) override;
     void process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn,
         const al::span<FloatBufferLine> samplesOut) override;
+    uint tailLength() const noexcept override { return mTailSamples; }
 
     DEF_NEWDEL(EchoState)
 };
@@ -111,6 +113,21 @@ void EchoState::update(const ContextBase *context, const EffectSlot *slot,
 
     mFeedGain = props->Echo.Feedback;
 
+    /* Each echo comes back through the second tap, attenuated by the feedback
+     * gain (the damping filter only reduces it further). The output lasts
+     * until the echoes are attenuated below the tail gain.
+     */
+    if(!(mFeedGain < 1.0f))
+        mTailSamples = InfiniteEffectTail;
+    else
+    {
+        const float echoes{(mFeedGain > EffectTailGain) ?
+            std::ceil(std::log(EffectTailGain) / std::log(mFeedGain)) + 1.0f : 1.0f};
+        const float length{echoes * static_cast<float>(mTap[1].delay)};
+        mTailSamples = (length < static_cast<float>(InfiniteEffectTail)) ? float2uint(length)
+            : InfiniteEffectTail;
+    }
+
     /* Convert echo spread (where 0 = center, +/-1 = sides) to angle. */
     const float angle{std::asin(props->Echo.Spread)};
 
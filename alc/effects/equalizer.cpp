@@ -29,6 +29,7 @@
 
 #include "alc/effects/base.h"
 #include "almalloc.h"
+#include "alnumeric.h"
 #include "alspan.h"
 #include "core/ambidefs.h"
 #include "core/bufferline.h"
@@ -86,16 +87,25 @@ namespace {
 
 
 struct EqualizerState final : public EffectState {
-    struct {
-        /* Effect parameters */
-        BiquadFilter filter[4];
+    using FilterBank = BiquadBank<4>;
+    static constexpr size_t LanesPerBank{FilterBank::MaxLanes};
+
+    /* Effect parameters */
+    BiquadFilter mFilter[4];
 
+    /* The filters for the input channels, a bank for each group of channels
+     * that are processed together.
+     */
+    std::array<FilterBank,(MaxAmbiChannels+LanesPerBank-1)/LanesPerBank> mBanks;
+
+    struct {
         /* Effect gains for each channel */
         float CurrentGains[MAX_OUTPUT_CHANNELS]{};
         float TargetGains[MAX_OUTPUT_CHANNELS]{};
     } mChans[MaxAmbiChannels];
 
-    FloatBufferLine mSampleBuffer{};
+    std::array<FloatBufferLine,LanesPerBank> mSampleBuffer{};
+    uint mTailSamples{0u};
 
 
     void deviceUpdate(const DeviceBase *device, const Buffer &buffer) override;
@@ -103,17 +113,16 @@ struct EqualizerState final : public EffectState {
         const EffectTarget target) override;
     void process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn,
         const al::span<FloatBufferLine> samplesOut) override;
+    uint tailLength() const noexcept override { return mTailSamples; }
 
     DEF_NEWDEL(EqualizerState)
 };
 
 void EqualizerState::deviceUpdate(const DeviceBase*, const Buffer&)
 {
+    std::for_each(mBanks.begin(), mBanks.end(), std::mem_fn(&FilterBank::clear));
     for(auto &e : mChans)
-    {
-        std::for_each(std::begin(e.filter), std::end(e.filter), std::mem_fn(&BiquadFilter::clear));
         std::fill(std::begin(e.CurrentGains), std::end(e.CurrentGains), 0.0f);
-    }
 }
 
 void EqualizerState::update(const ContextBase *context, const EffectSlot *slot,
@@ -131,29 +140,35 @@ void EqualizerState::update(const ContextBase *context, const EffectSlot *slot,
      */
     gain = std::sqrt(props->Equalizer.LowGain);
     f0norm = props->Equalizer.LowCutoff / frequency;
-    mChans[0].filter[0].setParamsFromSlope(BiquadType::LowShelf, f0norm, gain, 0.75f);
+    mFilter[0].setParamsFromSlope(BiquadType::LowShelf, f0norm, gain, 0.75f);
 
     gain = std::sqrt(props->Equalizer.Mid1Gain);
     f0norm = props->Equalizer.Mid1Center / frequency;
-    mChans[0].filter[1].setParamsFromBandwidth(BiquadType::Peaking, f0norm, gain,
+    mFilter[1].setParamsFromBandwidth(BiquadType::Peaking, f0norm, gain,
         props->Equalizer.Mid1Width);
 
     gain = std::sqrt(props->Equalizer.Mid2Gain);
     f0norm = props->Equalizer.Mid2Center / frequency;
-    mChans[0].filter[2].setParamsFromBandwidth(BiquadType::Peaking, f0norm, gain,
+    mFilter[2].setParamsFromBandwidth(BiquadType::Peaking, f0norm, gain,
         props->Equalizer.Mid2Width);
 
     gain = std::sqrt(props->Equalizer.HighGain);
     f0norm = props->Equalizer.HighCutoff / frequency;
-    mChans[0].filter[3].setParamsFromSlope(BiquadType::HighShelf, f0norm, gain, 0.75f);
+    mFilter[3].setParamsFromSlope(BiquadType::HighShelf, f0norm, gain, 0.75f);
 
-    /* Copy the filter coefficients for the other input channels. */
-    for(size_t i{1u};i < slot->Wet.Buffer.size();++i)
+    /* The filters are applied in series, so the tail is bounded by the sum of
+     * their decay times.
+     */
+    mTailSamples = 0;
+    for(const BiquadFilter &filter : mFilter)
+        mTailSamples += minu(filter.decaySamples(EffectTailGain), InfiniteEffectTail/8);
+
+    /* Copy the filter coefficients for each input channel. */
+    for(size_t i{0u};i < slot->Wet.Buffer.size();++i)
     {
-        mChans[i].filter[0].copyParamsFrom(mChans[0].filter[0]);
-        mChans[i].filter[1].copyParamsFrom(mChans[0].filter[1]);
-        mChans[i].filter[2].copyParamsFrom(mChans[0].filter[2]);
-        mChans[i].filter[3].copyParamsFrom(mChans[0].filter[3]);
+        FilterBank &bank = mBanks[i / LanesPerBank];
+        for(size_t stage{0u};stage < 4;++stage)
+            bank.setParams(i%LanesPerBank, stage, mFilter[stage]);
     }
 
     mOutTarget = target.Main->Buffer;
@@ -164,16 +179,28 @@ void EqualizerState::update(const ContextBase *context, const EffectSlot *slot,
 
 void EqualizerState::process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn, const al::span<FloatBufferLine> samplesOut)
 {
-    const al::span<float> buffer{mSampleBuffer.data(), samplesToDo};
+    /* Filter a group of input channels at once, then mix each one. */
     auto chan = std::addressof(mChans[0]);
-    for(const auto &input : samplesIn)
+    auto bank = mBanks.begin();
+    for(size_t base{0};base < samplesIn.size();base += LanesPerBank)
     {
-        const al::span<const float> inbuf{input.data(), samplesToDo};
-        DualBiquad{chan->filter[0], chan->filter[1]}.process(inbuf, buffer.begin());
-        DualBiquad{chan->filter[2], chan->filter[3]}.process(buffer, buffer.begin());
-
-        MixSamples(buffer, samplesOut, chan->CurrentGains, chan->TargetGains, samplesToDo, 0u);
-        ++chan;
+        const size_t numLanes{minz(samplesIn.size()-base, LanesPerBank)};
+        std::array<const float*,LanesPerBank> src;
+        std::array<float*,LanesPerBank> dst;
+        for(size_t i{0};i < numLanes;++i)
+        {
+            src[i] = samplesIn[base+i].data();
+            dst[i] = mSampleBuffer[i].data();
+        }
+        (bank++)->process({src.data(), numLanes}, dst.data(), samplesToDo);
+
+        for(size_t i{0};i < numLanes;++i)
+        {
+            const al::span<const float> buffer{mSampleBuffer[i].data(), samplesToDo};
+            MixSamples(buffer, samplesOut, chan->CurrentGains, chan->TargetGains, samplesToDo,
+                0u);
+            ++chan;
+        }
     }
 }
 
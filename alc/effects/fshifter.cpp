@@ -99,6 +99,8 @@ struct FshifterState final : public EffectState {
         const EffectTarget target) override;
     void process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn,
         const al::span<FloatBufferLine> samplesOut) override;
+    /* Input takes a full Hilbert frame to pass through, after the FIFO latency. */
+    uint tailLength() const noexcept override { return HIL_SIZE + FIFO_LATENCY; }
 
     DEF_NEWDEL(FshifterState)
 };
@@ -23,10 +23,15 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
-#include <complex>
 #include <cstdlib>
 #include <iterator>
 
+#ifdef HAVE_SSE_INTRINSICS
+#include <xmmintrin.h>
+#elif defined(HAVE_NEON)
+#include <arm_neon.h>
+#endif
+
 #include "alc/effects/base.h"
 #include "alcomplex.h"
 #include "almalloc.h"
@@ -40,6 +45,7 @@
 #include "core/mixer.h"
 #include "core/mixer/defs.h"
 #include "intrusive_ptr.h"
+#include "opthelpers.h"
 
 struct ContextBase;
 
@@ -47,7 +53,6 @@ struct ContextBase;
 namespace {
 
 using uint = unsigned int;
-using complex_d = std::complex<double>;
 
 #define STFT_SIZE      1024
 #define STFT_HALF_SIZE (STFT_SIZE>>1)
@@ -56,25 +61,301 @@ using complex_d = std::complex<double>;
 #define STFT_STEP    (STFT_SIZE / OVERSAMP)
 #define FIFO_LATENCY (STFT_STEP * (OVERSAMP-1))
 
+/* The number of frequency bins, padded to a multiple of 4 so they can be
+ * processed in groups of 4. The padding bins stay silent.
+ */
+#define STFT_BINS ((STFT_HALF_SIZE+1 + 3) & ~3)
+
 /* Define a Hann window, used to filter the STFT input and output. */
-std::array<double,STFT_SIZE> InitHannWindow()
+std::array<float,STFT_SIZE> InitHannWindow()
 {
-    std::array<double,STFT_SIZE> ret;
+    std::array<float,STFT_SIZE> ret;
     /* Create lookup table of the Hann window for the desired size, i.e. STFT_SIZE */
     for(size_t i{0};i < STFT_SIZE>>1;i++)
     {
         constexpr double scale{al::numbers::pi / double{STFT_SIZE}};
         const double val{std::sin(static_cast<double>(i+1) * scale)};
-        ret[i] = ret[STFT_SIZE-1-i] = val * val;
+        ret[i] = ret[STFT_SIZE-1-i] = static_cast<float>(val * val);
     }
     return ret;
 }
-alignas(16) const std::array<double,STFT_SIZE> HannWindow = InitHannWindow();
+alignas(16) const std::array<float,STFT_SIZE> HannWindow = InitHannWindow();
+
+
+constexpr float Pi{al::numbers::pi_v<float>};
+/* 2*pi split into a part with only a few significant bits, which can be
+ * multiplied by a whole number of cycles exactly, and the remainder.
+ */
+constexpr float TauHi{6.28125f};
+constexpr float TauLo{static_cast<float>(al::numbers::pi*2.0 - 6.28125)};
+
+/* Cycle offset per update expected of each frequency bin (bin 0 is none,
+ * bin 1 is x1, bin 2 is x2, etc).
+ */
+constexpr float ExpectedCycles{Pi*2.0f / OVERSAMP};
+/* AnalyzeBins relies on the expected phase difference wrapping around every
+ * 4 bins.
+ */
+static_assert(OVERSAMP == 4, "Bin phase expectations assume 4x oversampling");
+
+
+#if defined(HAVE_SSE_INTRINSICS) || defined(HAVE_NEON)
+
+#ifdef HAVE_SSE_INTRINSICS
+
+using float4 = __m128;
+using mask4 = __m128;
+
+inline float4 load4(const float *src) noexcept { return _mm_load_ps(src); }
+inline void store4(float *dst, const float4 val) noexcept { _mm_store_ps(dst, val); }
+inline float4 splat4(const float val) noexcept { return _mm_set1_ps(val); }
+inline float4 add4(const float4 a, const float4 b) noexcept { return _mm_add_ps(a, b); }
+inline float4 sub4(const float4 a, const float4 b) noexcept { return _mm_sub_ps(a, b); }
+inline float4 mul4(const float4 a, const float4 b) noexcept { return _mm_mul_ps(a, b); }
+/* Returns a + b*c */
+inline float4 madd4(const float4 a, const float4 b, const float4 c) noexcept
+{ return _mm_add_ps(a, _mm_mul_ps(b, c)); }
+inline float4 div4(const float4 a, const float4 b) noexcept { return _mm_div_ps(a, b); }
+inline float4 sqrt4(const float4 a) noexcept { return _mm_sqrt_ps(a); }
+inline float4 min4(const float4 a, const float4 b) noexcept { return _mm_min_ps(a, b); }
+inline float4 max4(const float4 a, const float4 b) noexcept { return _mm_max_ps(a, b); }
+inline float4 abs4(const float4 a) noexcept { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+inline mask4 greater4(const float4 a, const float4 b) noexcept { return _mm_cmpgt_ps(a, b); }
+inline mask4 less4(const float4 a, const float4 b) noexcept { return _mm_cmplt_ps(a, b); }
+inline float4 select4(const mask4 mask, const float4 a, const float4 b) noexcept
+{ return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+/* Negates a where mask is set. */
+inline float4 negate4(const mask4 mask, const float4 a) noexcept
+{ return _mm_xor_ps(a, _mm_and_ps(mask, _mm_set1_ps(-0.0f))); }
+/* Applies the sign of b to the non-negative a. */
+inline float4 copysign4(const float4 a, const float4 b) noexcept
+{ return _mm_or_ps(a, _mm_and_ps(b, _mm_set1_ps(-0.0f))); }
+
+#else
+
+using float4 = float32x4_t;
+using mask4 = uint32x4_t;
+
+inline float4 load4(const float *src) noexcept { return vld1q_f32(src); }
+inline void store4(float *dst, const float4 val) noexcept { vst1q_f32(dst, val); }
+inline float4 splat4(const float val) noexcept { return vdupq_n_f32(val); }
+inline float4 add4(const float4 a, const float4 b) noexcept { return vaddq_f32(a, b); }
+inline float4 sub4(const float4 a, const float4 b) noexcept { return vsubq_f32(a, b); }
+inline float4 mul4(const float4 a, const float4 b) noexcept { return vmulq_f32(a, b); }
+inline float4 madd4(const float4 a, const float4 b, const float4 c) noexcept
+{ return vmlaq_f32(a, b, c); }
+#ifdef __aarch64__
+inline float4 div4(const float4 a, const float4 b) noexcept { return vdivq_f32(a, b); }
+inline float4 sqrt4(const float4 a) noexcept { return vsqrtq_f32(a); }
+#else
+/* Without division and square root instructions, refine the reciprocal
+ * estimates with two Newton-Raphson steps each.
+ */
+inline float4 div4(const float4 a, const float4 b) noexcept
+{
+    float4 r{vrecpeq_f32(b)};
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    return vmulq_f32(a, r);
+}
+inline float4 sqrt4(const float4 a) noexcept
+{
+    float4 r{vrsqrteq_f32(a)};
+    r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(a, r), r), r);
+    r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(a, r), r), r);
+    /* The estimate is infinite for 0, so keep 0 as-is. */
+    return vbslq_f32(vcgtq_f32(a, vdupq_n_f32(0.0f)), vmulq_f32(a, r), vdupq_n_f32(0.0f));
+}
+#endif
+inline float4 min4(const float4 a, const float4 b) noexcept { return vminq_f32(a, b); }
+inline float4 max4(const float4 a, const float4 b) noexcept { return vmaxq_f32(a, b); }
+inline float4 abs4(const float4 a) noexcept { return vabsq_f32(a); }
+inline mask4 greater4(const float4 a, const float4 b) noexcept { return vcgtq_f32(a, b); }
+inline mask4 less4(const float4 a, const float4 b) noexcept { return vcltq_f32(a, b); }
+inline float4 select4(const mask4 mask, const float4 a, const float4 b) noexcept
+{ return vbslq_f32(mask, a, b); }
+inline float4 negate4(const mask4 mask, const float4 a) noexcept
+{ return vbslq_f32(mask, vnegq_f32(a), a); }
+inline float4 copysign4(const float4 a, const float4 b) noexcept
+{
+    return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a),
+        vandq_u32(vreinterpretq_u32_f32(b), vdupq_n_u32(0x80000000u))));
+}
+#endif
+
+/* Rounds to the nearest whole number, for values well within +/-2^22. */
+inline float4 round4(const float4 a) noexcept
+{
+    const float4 magic{splat4(12582912.0f)};
+    return sub4(add4(a, magic), magic);
+}
 
+/* Wraps the phase to -pi...+pi. */
+inline float4 wrap_phase4(const float4 phase) noexcept
+{
+    const float4 cycles{round4(mul4(phase, splat4(1.0f/(Pi*2.0f))))};
+    return sub4(sub4(phase, mul4(cycles, splat4(TauHi))), mul4(cycles, splat4(TauLo)));
+}
+
+/* Approximates atan2(y, x). The smaller of |x| and |y| is divided by the
+ * larger to approximate atan on 0...1 with a polynomial, which is then
+ * mirrored into the correct octant. Accurate to within 1e-7 or so.
+ */
+inline float4 atan2_4(const float4 y, const float4 x) noexcept
+{
+    const float4 ax{abs4(x)}, ay{abs4(y)};
+    const float4 a{div4(min4(ax, ay), max4(max4(ax, ay), splat4(1.17549435e-38f)))};
+    const float4 a2{mul4(a, a)};
+
+    float4 r{splat4(-4.054767111e-03f)};
+    r = madd4(splat4( 2.186374744e-02f), r, a2);
+    r = madd4(splat4(-5.591358342e-02f), r, a2);
+    r = madd4(splat4( 9.642300119e-02f), r, a2);
+    r = madd4(splat4(-1.390867510e-01f), r, a2);
+    r = madd4(splat4( 1.994657617e-01f), r, a2);
+    r = madd4(splat4(-3.332986188e-01f), r, a2);
+    r = madd4(splat4( 9.999993359e-01f), r, a2);
+    r = mul4(r, a);
+
+    r = select4(greater4(ay, ax), sub4(splat4(Pi*0.5f), r), r);
+    r = select4(less4(x, splat4(0.0f)), sub4(splat4(Pi), r), r);
+    return copysign4(r, y);
+}
+
+/* Approximates sin(x) and cos(x) for -pi <= x <= +pi. The input is folded to
+ * -pi/2...+pi/2 for sin, and 0...pi/2 for cos, where Taylor polynomials are
+ * accurate to within float precision.
+ */
+inline void sincos4(const float4 x, float4 &sinx, float4 &cosx) noexcept
+{
+    const float4 pi4{splat4(Pi)};
+
+    /* sin(x) = sin(pi - x) = sin(-pi - x) */
+    float4 t{min4(x, sub4(pi4, x))};
+    t = max4(t, sub4(splat4(-Pi), t));
+    const float4 t2{mul4(t, t)};
+    float4 s{splat4(-1.0f/39916800.0f)};
+    s = madd4(splat4(1.0f/362880.0f), s, t2);
+    s = madd4(splat4(-1.0f/5040.0f), s, t2);
+    s = madd4(splat4(1.0f/120.0f), s, t2);
+    s = madd4(splat4(-1.0f/6.0f), s, t2);
+    s = madd4(splat4(1.0f), s, t2);
+    sinx = mul4(s, t);
+
+    /* cos(x) = cos(-x) = -cos(pi - x) */
+    const float4 ax{abs4(x)};
+    const mask4 flip{greater4(ax, splat4(Pi*0.5f))};
+    const float4 u{select4(flip, sub4(pi4, ax), ax)};
+    const float4 u2{mul4(u, u)};
+    float4 c{splat4(1.0f/479001600.0f)};
+    c = madd4(splat4(-1.0f/3628800.0f), c, u2);
+    c = madd4(splat4(1.0f/40320.0f), c, u2);
+    c = madd4(splat4(-1.0f/720.0f), c, u2);
+    c = madd4(splat4(1.0f/24.0f), c, u2);
+    c = madd4(splat4(-0.5f), c, u2);
+    c = madd4(splat4(1.0f), c, u2);
+    cosx = negate4(flip, c);
+}
 
-struct FrequencyBin {
-    double Amplitude;
-    double FreqBin;
+#endif
+
+inline float wrap_phase(const float phase) noexcept
+{
+    const float cycles{std::round(phase * (1.0f/(Pi*2.0f)))};
+    return phase - cycles*TauHi - cycles*TauLo;
+}
+
+
+/* Analyzes the frequency bins, getting the amplitude of each and its true
+ * frequency (in bins) from the phase difference since the last frame.
+ */
+void AnalyzeBins(const float *RESTRICT re, const float *RESTRICT im, float *RESTRICT lastphase,
+    float *RESTRICT amplitude, float *RESTRICT freqbin)
+{
+#if defined(HAVE_SSE_INTRINSICS) || defined(HAVE_NEON)
+    /* The expected phase difference of bin k is k*ExpectedCycles, which is
+     * (k%4) quarter-cycles when wrapped. Starting each group at a multiple of
+     * 4 makes it the same for every group.
+     */
+    alignas(16) constexpr float expected[4]{0.0f, ExpectedCycles, ExpectedCycles*2.0f,
+        ExpectedCycles*3.0f};
+    alignas(16) constexpr float bins[4]{0.0f, 1.0f, 2.0f, 3.0f};
+    const float4 expected4{load4(expected)};
+    const float4 scale4{splat4(1.0f/ExpectedCycles)};
+    float4 bin4{load4(bins)};
+
+    for(size_t k{0u};k < STFT_BINS;k+=4)
+    {
+        const float4 re4{load4(re+k)}, im4{load4(im+k)};
+        store4(amplitude+k, sqrt4(madd4(mul4(re4, re4), im4, im4)));
+        const float4 phase{atan2_4(im4, re4)};
+
+        /* Compute the phase difference, subtract the expected phase
+         * difference, and map it into the +/- Pi interval.
+         */
+        const float4 delta{wrap_phase4(sub4(sub4(phase, load4(lastphase+k)), expected4))};
+
+        /* Get the deviation from the bin frequency and store the k-th
+         * partial's true frequency bin.
+         */
+        store4(freqbin+k, madd4(bin4, delta, scale4));
+        bin4 = add4(bin4, splat4(4.0f));
+
+        /* Store the actual phase[k] for the next frame. */
+        store4(lastphase+k, phase);
+    }
+#else
+    for(size_t k{0u};k < STFT_BINS;++k)
+    {
+        amplitude[k] = std::sqrt(re[k]*re[k] + im[k]*im[k]);
+        const float phase{std::atan2(im[k], re[k])};
+
+        const float expected{static_cast<float>(k&3) * ExpectedCycles};
+        const float delta{wrap_phase(phase - lastphase[k] - expected)};
+
+        freqbin[k] = static_cast<float>(k) + delta*(1.0f/ExpectedCycles);
+        lastphase[k] = phase;
+    }
+#endif
+}
+
+/* Reconstructs the frequency bins from the amplitudes and frequencies,
+ * accumulating the phase of each bin.
+ */
+void SynthesizeBins(const float *RESTRICT amplitude, const float *RESTRICT freqbin,
+    float *RESTRICT sumphase, float *RESTRICT re, float *RESTRICT im)
+{
+#if defined(HAVE_SSE_INTRINSICS) || defined(HAVE_NEON)
+    const float4 expected4{splat4(ExpectedCycles)};
+    for(size_t k{0u};k < STFT_BINS;k+=4)
+    {
+        /* Calculate actual delta phase and accumulate it to get bin phase.
+         * Keep it wrapped so it doesn't lose precision.
+         */
+        const float4 phase{wrap_phase4(madd4(load4(sumphase+k), load4(freqbin+k),
+            expected4))};
+        store4(sumphase+k, phase);
+
+        float4 sinx, cosx;
+        sincos4(phase, sinx, cosx);
+        const float4 amp4{load4(amplitude+k)};
+        store4(re+k, mul4(amp4, cosx));
+        store4(im+k, mul4(amp4, sinx));
+    }
+#else
+    for(size_t k{0u};k < STFT_BINS;++k)
+    {
+        sumphase[k] = wrap_phase(sumphase[k] + freqbin[k]*ExpectedCycles);
+        re[k] = amplitude[k] * std::cos(sumphase[k]);
+        im[k] = amplitude[k] * std::sin(sumphase[k]);
+    }
+#endif
+}
+
+
+struct FrequencyBins {
+    alignas(16) std::array<float,STFT_BINS> Amplitude;
+    alignas(16) std::array<float,STFT_BINS> FreqBin;
 };
 
 
@@ -83,18 +364,21 @@ struct PshifterState final : public EffectState {
     size_t mCount;
     size_t mPos;
     uint mPitchShiftI;
-    double mPitchShift;
+    float mPitchShift;
 
     /* Effects buffers */
-    std::array<double,STFT_SIZE> mFIFO;
-    std::array<double,STFT_HALF_SIZE+1> mLastPhase;
-    std::array<double,STFT_HALF_SIZE+1> mSumPhase;
-    std::array<double,STFT_SIZE> mOutputAccum;
+    alignas(16) std::array<float,STFT_SIZE> mFIFO;
+    alignas(16) std::array<float,STFT_BINS> mLastPhase;
+    alignas(16) std::array<float,STFT_BINS> mSumPhase;
+    alignas(16) std::array<float,STFT_SIZE> mOutputAccum;
 
-    std::array<complex_d,STFT_SIZE> mFftBuffer;
+    RealFftPlan mFft{STFT_SIZE};
+    alignas(16) std::array<float,STFT_SIZE> mFftBuffer;
+    alignas(16) std::array<float,STFT_BINS> mFftRe;
+    alignas(16) std::array<float,STFT_BINS> mFftIm;
 
-    std::array<FrequencyBin,STFT_HALF_SIZE+1> mAnalysisBuffer;
-    std::array<FrequencyBin,STFT_HALF_SIZE+1> mSynthesisBuffer;
+    FrequencyBins mAnalysisBins;
+    FrequencyBins mSynthesisBins;
 
     alignas(16) FloatBufferLine mBufferOut;
 
@@ -108,6 +392,8 @@ struct PshifterState final : public EffectState {
         const EffectTarget target) override;
     void process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn,
         const al::span<FloatBufferLine> samplesOut) override;
+    /* Input takes a full STFT frame to pass through, after the FIFO latency. */
+    uint tailLength() const noexcept override { return STFT_SIZE + FIFO_LATENCY; }
 
     DEF_NEWDEL(PshifterState)
 };
@@ -118,15 +404,20 @@ void PshifterState::deviceUpdate(const DeviceBase*, const Buffer&)
     mCount       = 0;
     mPos         = FIFO_LATENCY;
     mPitchShiftI = MixerFracOne;
-    mPitchShift  = 1.0;
-
-    std::fill(mFIFO.begin(),            mFIFO.end(),            0.0);
-    std::fill(mLastPhase.begin(),       mLastPhase.end(),       0.0);
-    std::fill(mSumPhase.begin(),        mSumPhase.end(),        0.0);
-    std::fill(mOutputAccum.begin(),     mOutputAccum.end(),     0.0);
-    std::fill(mFftBuffer.begin(),       mFftBuffer.end(),       complex_d{});
-    std::fill(mAnalysisBuffer.begin(),  mAnalysisBuffer.end(),  FrequencyBin{});
-    std::fill(mSynthesisBuffer.begin(), mSynthesisBuffer.end(), FrequencyBin{});
+    mPitchShift  = 1.0f;
+
+    std::fill(mFIFO.begin(),            mFIFO.end(),            0.0f);
+    std::fill(mLastPhase.begin(),       mLastPhase.end(),       0.0f);
+    std::fill(mSumPhase.begin(),        mSumPhase.end(),        0.0f);
+    std::fill(mOutputAccum.begin(),     mOutputAccum.end(),     0.0f);
+    std::fill(mFftBuffer.begin(),       mFftBuffer.end(),       0.0f);
+    std::fill(mFftRe.begin(),           mFftRe.end(),           0.0f);
+    std::fill(mFftIm.begin(),           mFftIm.end(),           0.0f);
+    for(FrequencyBins *bins : {&mAnalysisBins, &mSynthesisBins})
+    {
+        std::fill(bins->Amplitude.begin(), bins->Amplitude.end(), 0.0f);
+        std::fill(bins->FreqBin.begin(),   bins->FreqBin.end(),   0.0f);
+    }
 
     std::fill(std::begin(mCurrentGains), std::end(mCurrentGains), 0.0f);
     std::fill(std::begin(mTargetGains),  std::end(mTargetGains),  0.0f);
@@ -138,7 +429,7 @@ void PshifterState::update(const ContextBase*, const EffectSlot *slot,
     const int tune{props->Pshifter.CoarseTune*100 + props->Pshifter.FineTune};
     const float pitch{std::pow(2.0f, static_cast<float>(tune) / 1200.0f)};
     mPitchShiftI = fastf2u(pitch*MixerFracOne);
-    mPitchShift  = mPitchShiftI * double{1.0/MixerFracOne};
+    mPitchShift  = static_cast<float>(mPitchShiftI) * (1.0f/MixerFracOne);
 
     const auto coeffs = CalcDirectionCoeffs({0.0f, 0.0f, -1.0f}, 0.0f);
 
@@ -152,11 +443,6 @@ void PshifterState::process(const size_t samplesToDo, const al::span<const Float
      * http://blogs.zynaptiq.com/bernsee/pitch-shifting-using-the-ft/
      */
 
-    /* Cycle offset per update expected of each frequency bin (bin 0 is none,
-     * bin 1 is x1, bin 2 is x2, etc).
-     */
-    constexpr double expected_cycles{al::numbers::pi*2.0 / OVERSAMP};
-
     for(size_t base{0u};base < samplesToDo;)
     {
         const size_t todo{minz(STFT_STEP-mCount, samplesToDo-base)};
@@ -165,8 +451,7 @@ void PshifterState::process(const size_t samplesToDo, const al::span<const Float
          * samples.
          */
         auto fifo_iter = mFIFO.begin()+mPos + mCount;
-        std::transform(fifo_iter, fifo_iter+todo, mBufferOut.begin()+base,
-            [](double d) noexcept -> float { return static_cast<float>(d); });
+        std::copy_n(fifo_iter, todo, mBufferOut.begin()+base);
 
         std::copy_n(samplesIn[0].begin()+base, todo, fifo_iter);
         mCount += todo;
@@ -184,74 +469,47 @@ void PshifterState::process(const size_t samplesToDo, const al::span<const Float
             mFftBuffer[k] = mFIFO[src] * HannWindow[k];
         for(size_t src{0u}, k{STFT_SIZE-mPos};src < mPos;++src,++k)
             mFftBuffer[k] = mFIFO[src] * HannWindow[k];
-        forward_fft(mFftBuffer);
+        mFft.forward(mFftBuffer.data(), mFftRe.data(), mFftIm.data());
 
         /* Analyze the obtained data. Since the real FFT is symmetric, only
          * STFT_HALF_SIZE+1 samples are needed.
          */
-        for(size_t k{0u};k < STFT_HALF_SIZE+1;k++)
-        {
-            const double amplitude{std::abs(mFftBuffer[k])};
-            const double phase{std::arg(mFftBuffer[k])};
-
-            /* Compute phase difference and subtract expected phase difference */
-            double tmp{(phase - mLastPhase[k]) - static_cast<double>(k)*expected_cycles};
-
-            /* Map delta phase into +/- Pi interval */
-            int qpd{double2int(tmp / al::numbers::pi)};
-            tmp -= al::numbers::pi * (qpd + (qpd%2));
-
-            /* Get deviation from bin frequency from the +/- Pi interval */
-            tmp /= expected_cycles;
-
-            /* Compute the k-th partials' true frequency and store the
-             * amplitude and frequency bin in the analysis buffer.
-             */
-            mAnalysisBuffer[k].Amplitude = amplitude;
-            mAnalysisBuffer[k].FreqBin = static_cast<double>(k) + tmp;
-
-            /* Store the actual phase[k] for the next frame. */
-            mLastPhase[k] = phase;
-        }
+        AnalyzeBins(mFftRe.data(), mFftIm.data(), mLastPhase.data(),
+            mAnalysisBins.Amplitude.data(), mAnalysisBins.FreqBin.data());
 
         /* Shift the frequency bins according to the pitch adjustment,
          * accumulating the amplitudes of overlapping frequency bins.
          */
-        std::fill(mSynthesisBuffer.begin(), mSynthesisBuffer.end(), FrequencyBin{});
+        std::fill(mSynthesisBins.Amplitude.begin(), mSynthesisBins.Amplitude.end(), 0.0f);
+        std::fill(mSynthesisBins.FreqBin.begin(), mSynthesisBins.FreqBin.end(), 0.0f);
         const size_t bin_count{minz(STFT_HALF_SIZE+1,
             (((STFT_HALF_SIZE+1)<<MixerFracBits) - (MixerFracOne>>1) - 1)/mPitchShiftI + 1)};
         for(size_t k{0u};k < bin_count;k++)
         {
             const size_t j{(k*mPitchShiftI + (MixerFracOne>>1)) >> MixerFracBits};
-            mSynthesisBuffer[j].Amplitude += mAnalysisBuffer[k].Amplitude;
-            mSynthesisBuffer[j].FreqBin    = mAnalysisBuffer[k].FreqBin * mPitchShift;
+            mSynthesisBins.Amplitude[j] += mAnalysisBins.Amplitude[k];
+            mSynthesisBins.FreqBin[j]    = mAnalysisBins.FreqBin[k] * mPitchShift;
         }
 
         /* Reconstruct the frequency-domain signal from the adjusted frequency
          * bins.
          */
-        for(size_t k{0u};k < STFT_HALF_SIZE+1;k++)
-        {
-            /* Calculate actual delta phase and accumulate it to get bin phase */
-            mSumPhase[k] += mSynthesisBuffer[k].FreqBin * expected_cycles;
-
-            mFftBuffer[k] = std::polar(mSynthesisBuffer[k].Amplitude, mSumPhase[k]);
-        }
-        for(size_t k{STFT_HALF_SIZE+1};k < STFT_SIZE;++k)
-            mFftBuffer[k] = std::conj(mFftBuffer[STFT_SIZE-k]);
+        SynthesizeBins(mSynthesisBins.Amplitude.data(), mSynthesisBins.FreqBin.data(),
+            mSumPhase.data(), mFftRe.data(), mFftIm.data());
 
         /* Apply an inverse FFT to get the time-domain siganl, and accumulate
          * for the output with windowing.
          */
-        inverse_fft(mFftBuffer);
+        mFft.inverse(mFftRe.data(), mFftIm.data(), mFftBuffer.data());
+        constexpr float scale{4.0f / OVERSAMP / STFT_SIZE};
         for(size_t dst{mPos}, k{0u};dst < STFT_SIZE;++dst,++k)
-            mOutputAccum[dst] += HannWindow[k]*mFftBuffer[k].real() * (4.0/OVERSAMP/STFT_SIZE);
+            mOutputAccum[dst] += HannWindow[k]*mFftBuffer[k] * scale;
         for(size_t dst{0u}, k{STFT_SIZE-mPos};dst < mPos;++dst,++k)
-            mOutputAccum[dst] += HannWindow[k]*mFftBuffer[k].real() * (4.0/OVERSAMP/STFT_SIZE);
+            mOutputAccum[dst] += HannWindow[k]*mFftBuffer[k] * scale;
 
         /* Copy out the accumulated result, then clear for the next iteration. */
         std::copy_n(mOutputAccum.begin() + mPos, STFT_STEP, mFIFO.begin() + mPos);
-        std::fill_n(mOutputAccum.begin() + mPos, STFT_STEP, 0.0);
+        std::fill_n(mOutputAccum.begin() + mPos, STFT_STEP, 0.0f);
     }
 
     /* Now, mix the processed sound data to the output. */
@@ -25,8 +25,10 @@
 #include <cstdio>
 #include <functional>
 #include <iterator>
+#include <limits>
 #include <numeric>
 #include <stdint.h>
+#include <type_traits>
 
 #include "alc/effects/base.h"
 #include "almalloc.h"
@@ -52,6 +54,7 @@
  * effect.
  */
 float ReverbBoost = 1.0f;
+bool ReverbReducedLateRate{false};
 
 namespace {
 
@@ -79,6 +82,14 @@ constexpr size_t MAX_UPDATE_SAMPLES{256};
  */
 constexpr size_t NUM_LINES{4u};
 
+/* The maximum decimation of the late reverb, as a power of 2 (i.e. 1/4th the
+ * device rate).
+ */
+constexpr uint MaxLateRateShift{2u};
+
+/* The late reverb won't be decimated below this rate. */
+constexpr uint MinLateFrequency{44100u};
+
 
 /* This coefficient is used to define the maximum frequency range controlled by
  * the modulation depth. The current value of 0.05 will allow it to swing from
@@ -311,6 +322,69 @@ struct VecAllpass {
         const float xCoeff, const float yCoeff, const size_t todo);
 };
 
+using LineFrame = std::array<float,NUM_LINES>;
+
+/* Coefficients for polyphase IIR half-band filters, made from two parallel
+ * paths of first-order all-pass sections (in z^-2) that alternately process
+ * the samples. The first has a transition band of 0.05 (relative to the
+ * higher rate) around the half-band, for about 80dB of stop-band attenuation.
+ * The second has a transition band of 0.15 for about 44dB of attenuation, for
+ * the first of two decimation stages where it only needs to stop what would
+ * alias into the final pass-band.
+ */
+constexpr std::array<float,6> HalfBandCoeffs{{
+    0.060297391f, 0.215971445f, 0.412590720f, 0.604358626f, 0.772715654f, 0.923886139f
+}};
+constexpr std::array<float,2> WideHalfBandCoeffs{{
+    0.187430565f, 0.656160299f
+}};
+
+/* Decimates or interpolates the lines by a factor of 2 for the late reverb.
+ * The lines are filtered together so each all-pass section can be processed
+ * as a vector.
+ */
+template<size_t N, const std::array<float,N> &Coeffs>
+struct HalfBandFilter {
+    /* Previous input and output of each all-pass section. */
+    std::array<LineFrame,N> mX{}, mY{};
+
+    /* An input sample frame left over from the last decimation. */
+    LineFrame mPending{};
+    bool mHasPending{false};
+
+    /* Applies every other all-pass section, starting with section I, to a
+     * frame of lines.
+     */
+    template<size_t I>
+    static std::enable_if_t<(I < N)> applyPath(LineFrame &s, std::array<LineFrame,N> &x,
+        std::array<LineFrame,N> &y) noexcept
+    {
+        for(size_t j{0u};j < NUM_LINES;++j)
+        {
+            const float out{(s[j] - y[I][j])*Coeffs[I] + x[I][j]};
+            x[I][j] = s[j];
+            y[I][j] = out;
+            s[j] = out;
+        }
+        applyPath<I+2>(s, x, y);
+    }
+    template<size_t I>
+    static std::enable_if_t<(I >= N)> applyPath(LineFrame&, std::array<LineFrame,N>&,
+        std::array<LineFrame,N>&) noexcept
+    { }
+
+    /* Decimates the given samples in-place, returning the number of output
+     * samples.
+     */
+    size_t decimate(const std::array<float*,NUM_LINES> lines, const size_t todo) noexcept;
+
+    /* Interpolates the given samples, writing out twice as many. */
+    void interpolate(const std::array<const float*,NUM_LINES> src,
+        const std::array<float*,NUM_LINES> dst, const size_t count) noexcept;
+};
+using LateHalfBand = HalfBandFilter<HalfBandCoeffs.size(),HalfBandCoeffs>;
+using LateWideHalfBand = HalfBandFilter<WideHalfBandCoeffs.size(),WideHalfBandCoeffs>;
+
 struct T60Filter {
     /* Two filters are used to adjust the signal. One to control the low
      * frequencies, and one to control the high frequencies.
@@ -438,6 +512,9 @@ struct ReverbState final : public EffectState {
 
     LateReverb mLate;
 
+    /* Number of samples the output lasts after the input goes silent. */
+    uint mTailSamples{0u};
+
     bool mDoFading{};
 
     /* Maximum number of samples to process at once. */
@@ -446,6 +523,28 @@ struct ReverbState final : public EffectState {
     /* The current write offset for all delay lines. */
     size_t mOffset{};
 
+    /* The late reverb can run at a reduced rate, with its input decimated
+     * from and its output interpolated back to the device rate. The rate
+     * shift is the number of half-band stages used each way.
+     */
+    uint mLateRateShift{0u};
+    size_t mLatePhase{0u};
+    size_t mLateOffset{0u};
+    LateHalfBand mLateDown, mLateUp;
+    LateWideHalfBand mLateWideDown, mLateWideUp;
+    /* Interpolated late reverb samples, including those held over for the
+     * next update.
+     */
+    size_t mLateUpCount{0u};
+    alignas(16) std::array<std::array<float,MAX_UPDATE_SAMPLES+4>,NUM_LINES> mLateUpSamples{};
+    /* Changing the rate clears the late lines, so a change waits until the
+     * input has been silent for the length of the tail. The device rate is
+     * kept for updating the late lines then.
+     */
+    uint mNextLateRateShift{0u};
+    uint mSilentSamples{0u};
+    float mFrequency{0.0f};
+
     /* Temporary storage used when processing. */
     union {
         alignas(16) FloatBufferLine mTempLine{};
@@ -543,6 +642,10 @@ struct ReverbState final : public EffectState {
     }
 
     void allocLines(const float frequency);
+    void resetLateRate(const uint rateShift);
+    void updateLateLines();
+    void checkLateRate(const al::span<const FloatBufferLine> samplesIn,
+        const size_t samplesToDo);
 
     void updateDelayLine(const float earlyDelay, const float lateDelay, const float density_mult,
         const float decayTime, const float frequency);
@@ -553,6 +656,12 @@ struct ReverbState final : public EffectState {
     void earlyFaded(const size_t offset, const size_t todo, const float fade,
         const float fadeStep);
 
+    void lateFeedUnfaded(const size_t offset, const size_t todo);
+    void lateFeedFaded(const size_t offset, const size_t todo, const float fade,
+        const float fadeStep);
+    size_t decimateLate(const size_t todo);
+    void interpolateLate(const size_t count, const size_t todo);
+
     void lateUnfaded(const size_t offset, const size_t todo);
     void lateFaded(const size_t offset, const size_t todo, const float fade,
         const float fadeStep);
@@ -562,6 +671,7 @@ struct ReverbState final : public EffectState {
         const EffectTarget target) override;
     void process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn,
         const al::span<FloatBufferLine> samplesOut) override;
+    uint tailLength() const noexcept override { return mTailSamples; }
 
     DEF_NEWDEL(ReverbState)
 };
@@ -638,9 +748,92 @@ void ReverbState::allocLines(const float frequency)
     mLate.Delay.realizeLineOffset(mSampleBuffer.data());
 }
 
+/* Sets the late reverb's rate reduction, clearing the late lines, filters,
+ * and the resampler history.
+ */
+void ReverbState::resetLateRate(const uint rateShift)
+{
+    mLateRateShift = rateShift;
+
+    std::fill_n(mLate.Delay.Line, mLate.Delay.Mask+1, std::array<float,NUM_LINES>{});
+    std::fill_n(mLate.VecAp.Delay.Line, mLate.VecAp.Delay.Mask+1, std::array<float,NUM_LINES>{});
+    for(auto &t60 : mLate.T60)
+    {
+        t60.HFFilter.clear();
+        t60.LFFilter.clear();
+    }
+
+    mLateDown = LateHalfBand{};
+    mLateUp = LateHalfBand{};
+    mLateWideDown = LateWideHalfBand{};
+    mLateWideUp = LateWideHalfBand{};
+
+    /* Prime the interpolated output so there's always enough for an update.
+     * Each decimated sample needs (1<<rateShift) input samples, which may
+     * leave up to (1<<rateShift)-1 samples waiting for the next update.
+     */
+    for(auto &line : mLateUpSamples)
+        line.fill(0.0f);
+    mLateUpCount = (1u<<rateShift) - 1u;
+    mLatePhase = 0;
+    mLateOffset = 0;
+}
+
+/* Updates the late lines and modulator for the late reverb's current rate. */
+void ReverbState::updateLateLines()
+{
+    const float lateFrequency{mFrequency / static_cast<float>(1u<<mLateRateShift)};
+    const float late_hf0norm{minf(mParams.HFReference/lateFrequency, 0.49f)};
+    const float late_lf0norm{minf(mParams.LFReference/lateFrequency, 0.49f)};
+
+    /* Update the modulator rate and depth. */
+    mLate.Mod.updateModulator(mParams.ModulationTime, mParams.ModulationDepth, lateFrequency);
+
+    /* Update the late lines. */
+    mLate.updateLines(CalcDelayLengthMult(mParams.Density), mParams.Diffusion,
+        mParams.LFDecayTime, mParams.DecayTime, mParams.HFDecayTime, late_lf0norm, late_hf0norm,
+        lateFrequency);
+
+    /* Calculate the max update size from the smallest relevant delay. A
+     * reduced-rate late reverb may process one more sample than the update
+     * size divided by its decimation.
+     */
+    const size_t lateMaxUpdate{((mLate.Offset[0][1]-1) << mLateRateShift) + 1};
+    mMaxUpdate[1] = minz(MAX_UPDATE_SAMPLES, minz(mEarly.Offset[0][1], lateMaxUpdate));
+}
+
+/* Counts how long the input has been silent, and makes a pending late rate
+ * change once that covers the length of the tail. This reaches the tail no
+ * later than the slot does before it sleeps.
+ */
+void ReverbState::checkLateRate(const al::span<const FloatBufferLine> samplesIn,
+    const size_t samplesToDo)
+{
+    auto is_silent = [samplesToDo](const FloatBufferLine &input) noexcept -> bool
+    {
+        return std::all_of(input.cbegin(), input.cbegin()+samplesToDo,
+            [](const float sample) noexcept -> bool { return sample == 0.0f; });
+    };
+    if(!std::all_of(samplesIn.begin(), samplesIn.end(), is_silent))
+    {
+        mSilentSamples = 0;
+        return;
+    }
+
+    if(mSilentSamples < mTailSamples)
+        mSilentSamples += static_cast<uint>(minz(samplesToDo, mTailSamples-mSilentSamples));
+    if(mNextLateRateShift == mLateRateShift || mSilentSamples < mTailSamples)
+        return;
+
+    resetLateRate(mNextLateRateShift);
+    updateLateLines();
+    mDoFading = true;
+}
+
 void ReverbState::deviceUpdate(const DeviceBase *device, const Buffer&)
 {
     const auto frequency = static_cast<float>(device->Frequency);
+    mFrequency = frequency;
 
     /* Allocate the delay lines. */
     allocLines(frequency);
@@ -679,6 +872,11 @@ void ReverbState::deviceUpdate(const DeviceBase *device, const Buffer&)
     mLate.Mod.Step = 1;
     std::fill(std::begin(mLate.Mod.Depth), std::end(mLate.Mod.Depth), 0.0f);
 
+    /* The late lines are clear, so the first update can set any rate. */
+    resetLateRate(0);
+    mNextLateRateShift = 0;
+    mSilentSamples = std::numeric_limits<uint>::max();
+
     for(auto &gains : mEarly.CurrentGain)
         std::fill(std::begin(gains), std::end(gains), 0.0f);
     for(auto &gains : mEarly.PanGain)
@@ -1055,22 +1253,19 @@ void ReverbState::update(const ContextBase *Context, const EffectSlot *Slot,
         MinDecayTime, MaxDecayTime)};
     const float hfDecayTime{clampf(props->Reverb.DecayTime*hfRatio, MinDecayTime, MaxDecayTime)};
 
-    /* Update the modulator rate and depth. */
-    mLate.Mod.updateModulator(props->Reverb.ModulationTime, props->Reverb.ModulationDepth,
-        frequency);
-
-    /* Update the late lines. */
-    mLate.updateLines(density_mult, props->Reverb.Diffusion, lfDecayTime,
-        props->Reverb.DecayTime, hfDecayTime, lf0norm, hf0norm, frequency);
+    /* The longest decay time is how long it takes to decay by the decay gain,
+     * which is scaled to reach the tail gain. Allow for the input to pass
+     * through all the delay lines before then.
+     */
+    const float maxDecayTime{maxf(props->Reverb.DecayTime, maxf(lfDecayTime, hfDecayTime))};
+    mTailSamples = float2uint(maxDecayTime*frequency * std::log(EffectTailGain) /
+        std::log(ReverbDecayGain)) + static_cast<uint>(mSampleBuffer.size());
 
     /* Update early and late 3D panning. */
     const float gain{props->Reverb.Gain * Slot->Gain * ReverbBoost};
     update3DPanning(props->Reverb.ReflectionsPan, props->Reverb.LateReverbPan,
         props->Reverb.ReflectionsGain*gain, props->Reverb.LateReverbGain*gain, target);
 
-    /* Calculate the max update size from the smallest relevant delay. */
-    mMaxUpdate[1] = minz(MAX_UPDATE_SAMPLES, minz(mEarly.Offset[0][1], mLate.Offset[0][1]));
-
     /* Determine if delay-line cross-fading is required. Density is essentially
      * a master control for the feedback delays, so changes the offsets of many
      * delay lines.
@@ -1103,6 +1298,27 @@ void ReverbState::update(const ContextBase *Context, const EffectSlot *Slot,
         mParams.HFReference = props->Reverb.HFReference;
         mParams.LFReference = props->Reverb.LFReference;
     }
+
+    /* With a reduced late rate, the late reverb's rate is halved as many
+     * times as it can be while staying at or above the minimum rate. Changing
+     * the rate clears the late lines, so it's only done here if they're
+     * already silent. Otherwise processing will do it once the tail has
+     * passed.
+     */
+    uint lateRateShift{0u};
+    if(props->Reverb.ReducedLateRate || ReverbReducedLateRate)
+    {
+        while(lateRateShift < MaxLateRateShift
+            && (Device->Frequency>>(lateRateShift+1)) >= MinLateFrequency)
+            ++lateRateShift;
+    }
+    mNextLateRateShift = lateRateShift;
+    if(lateRateShift != mLateRateShift && (Slot->mSleeping || mSilentSamples >= mTailSamples))
+    {
+        resetLateRate(lateRateShift);
+        mDoFading = true;
+    }
+    updateLateLines();
 }
 
 
@@ -1465,6 +1681,192 @@ void Modulation::calcFadedDelays(size_t todo, float fadeCount, float fadeStep)
 }
 
 
+/* Each path of the half-band filter runs every other section, with the first
+ * path on the later (even) input and the second path on the earlier (odd)
+ * input. Their average gives the decimated output, while interpolating takes
+ * the output of each path in turn.
+ */
+template<size_t N, const std::array<float,N> &Coeffs>
+size_t HalfBandFilter<N,Coeffs>::decimate(const std::array<float*,NUM_LINES> lines,
+    const size_t todo) noexcept
+{
+    if(todo == 0) return 0;
+
+    auto x = mX;
+    auto y = mY;
+    auto load_frame = [lines](const size_t i) noexcept -> LineFrame
+    { return LineFrame{{lines[0][i], lines[1][i], lines[2][i], lines[3][i]}}; };
+    auto process_pair = [&x,&y](LineFrame s1, LineFrame s0) noexcept -> LineFrame
+    {
+        applyPath<0>(s0, x, y);
+        applyPath<1>(s1, x, y);
+        LineFrame ret;
+        for(size_t j{0u};j < NUM_LINES;++j)
+            ret[j] = (s0[j]+s1[j]) * 0.5f;
+        return ret;
+    };
+    auto store_frame = [lines](const size_t i, const LineFrame &frame) noexcept
+    {
+        lines[0][i] = frame[0];
+        lines[1][i] = frame[1];
+        lines[2][i] = frame[2];
+        lines[3][i] = frame[3];
+    };
+
+    /* The second path takes the earlier sample of each pair, starting with
+     * the one left over from the last call.
+     */
+    const size_t total{todo + (mHasPending ? 1u : 0u)};
+    const size_t count{total / 2};
+    size_t i{0u}, in{0u};
+    if(mHasPending)
+    {
+        store_frame(0, process_pair(mPending, load_frame(0)));
+        i = 1;
+        in = 1;
+    }
+    for(;i < count;++i,in+=2)
+        store_frame(i, process_pair(load_frame(in), load_frame(in+1)));
+
+    /* An odd sample out is held until the next call. The output written so
+     * far won't have reached it.
+     */
+    mHasPending = (total&1) != 0;
+    if(mHasPending) mPending = load_frame(todo-1);
+
+    mX = x;
+    mY = y;
+    return count;
+}
+
+template<size_t N, const std::array<float,N> &Coeffs>
+void HalfBandFilter<N,Coeffs>::interpolate(const std::array<const float*,NUM_LINES> src,
+    const std::array<float*,NUM_LINES> dst, const size_t count) noexcept
+{
+    auto x = mX;
+    auto y = mY;
+    for(size_t i{0u};i < count;++i)
+    {
+        LineFrame s0{{src[0][i], src[1][i], src[2][i], src[3][i]}};
+        LineFrame s1{s0};
+        applyPath<0>(s0, x, y);
+        applyPath<1>(s1, x, y);
+        dst[0][i*2] = s0[0]; dst[0][i*2 + 1] = s1[0];
+        dst[1][i*2] = s0[1]; dst[1][i*2 + 1] = s1[1];
+        dst[2][i*2] = s0[2]; dst[2][i*2 + 1] = s1[2];
+        dst[3][i*2] = s0[3]; dst[3][i*2 + 1] = s1[3];
+    }
+    mX = x;
+    mY = y;
+}
+
+
+/* Loads the late reverb input from the main delay line, attenuated to
+ * compensate for the modal density and decay rate of the late lines.
+ */
+void ReverbState::lateFeedUnfaded(const size_t offset, const size_t todo)
+{
+    const DelayLineI main_delay{mDelay};
+
+    ASSUME(todo > 0);
+
+    for(size_t j{0u};j < NUM_LINES;j++)
+    {
+        size_t late_delay_tap{offset - mLateDelayTap[j][0]};
+        const float densityGain{mLate.DensityGain[0] * mLate.T60[j].MidGain[0]};
+
+        for(size_t i{0u};i < todo;)
+        {
+            late_delay_tap &= main_delay.Mask;
+            size_t td{minz(todo - i, main_delay.Mask+1 - late_delay_tap)};
+            do {
+                mLateSamples[j][i++] = main_delay.Line[late_delay_tap++][j] * densityGain;
+            } while(--td);
+        }
+    }
+}
+void ReverbState::lateFeedFaded(const size_t offset, const size_t todo, const float fade,
+    const float fadeStep)
+{
+    const DelayLineI main_delay{mDelay};
+
+    ASSUME(todo > 0);
+
+    for(size_t j{0u};j < NUM_LINES;j++)
+    {
+        const float oldDensityGain{mLate.DensityGain[0] * mLate.T60[j].MidGain[0]};
+        const float densityGain{mLate.DensityGain[1] * mLate.T60[j].MidGain[1]};
+        const float oldDensityStep{-oldDensityGain * fadeStep};
+        const float densityStep{densityGain * fadeStep};
+        size_t late_delay_tap0{offset - mLateDelayTap[j][0]};
+        size_t late_delay_tap1{offset - mLateDelayTap[j][1]};
+        float fadeCount{fade};
+
+        for(size_t i{0u};i < todo;)
+        {
+            late_delay_tap0 &= main_delay.Mask;
+            late_delay_tap1 &= main_delay.Mask;
+            size_t td{minz(todo - i, main_delay.Mask+1 - maxz(late_delay_tap0, late_delay_tap1))};
+            do {
+                fadeCount += 1.0f;
+                const float fade0{oldDensityGain + oldDensityStep*fadeCount};
+                const float fade1{densityStep*fadeCount};
+                mLateSamples[j][i++] = main_delay.Line[late_delay_tap0++][j]*fade0 +
+                    main_delay.Line[late_delay_tap1++][j]*fade1;
+            } while(--td);
+        }
+    }
+}
+
+/* Decimates the late reverb input in-place for a reduced-rate late reverb,
+ * returning the number of samples to process at the reduced rate.
+ */
+size_t ReverbState::decimateLate(const size_t todo)
+{
+    const std::array<float*,NUM_LINES> lines{{mLateSamples[0].data(), mLateSamples[1].data(),
+        mLateSamples[2].data(), mLateSamples[3].data()}};
+
+    size_t count{todo};
+    if(mLateRateShift > 1)
+        count = mLateWideDown.decimate(lines, count);
+    count = mLateDown.decimate(lines, count);
+    mLatePhase = (mLatePhase+todo) & ((size_t{1}<<mLateRateShift) - 1);
+    return count;
+}
+
+/* Interpolates the reduced-rate late reverb output back to the device rate,
+ * writing out the next update's worth of samples for mixing.
+ */
+void ReverbState::interpolateLate(const size_t count, const size_t todo)
+{
+    const size_t total{mLateUpCount + (count<<mLateRateShift)};
+    if(count > 0)
+    {
+        const std::array<float*,NUM_LINES> upsamples{{mLateUpSamples[0].data()+mLateUpCount,
+            mLateUpSamples[1].data()+mLateUpCount, mLateUpSamples[2].data()+mLateUpCount,
+            mLateUpSamples[3].data()+mLateUpCount}};
+        const std::array<const float*,NUM_LINES> late{{mLateSamples[0].data(),
+            mLateSamples[1].data(), mLateSamples[2].data(), mLateSamples[3].data()}};
+        if(mLateRateShift > 1)
+        {
+            const std::array<float*,NUM_LINES> temp{{mTempSamples[0].data(),
+                mTempSamples[1].data(), mTempSamples[2].data(), mTempSamples[3].data()}};
+            mLateUp.interpolate(late, temp, count);
+            mLateWideUp.interpolate({{temp[0], temp[1], temp[2], temp[3]}}, upsamples, count*2);
+        }
+        else
+            mLateUp.interpolate(late, upsamples, count);
+    }
+    for(size_t j{0u};j < NUM_LINES;j++)
+    {
+        auto upsamples = mLateUpSamples[j].begin();
+        std::copy_n(upsamples, todo, mLateSamples[j].begin());
+        std::copy(upsamples+todo, upsamples+total, upsamples);
+    }
+    mLateUpCount = total - todo;
+}
+
+
 /* This generates the reverb tail using a modified feed-back delay network
  * (FDN).
  *
@@ -1482,7 +1884,6 @@ void Modulation::calcFadedDelays(size_t todo, float fadeCount, float fadeStep)
 void ReverbState::lateUnfaded(const size_t offset, const size_t todo)
 {
     const DelayLineI late_delay{mLate.Delay};
-    const DelayLineI main_delay{mDelay};
     const float mixX{mMixX};
     const float mixY{mMixY};
 
@@ -1491,43 +1892,35 @@ void ReverbState::lateUnfaded(const size_t offset, const size_t todo)
     /* First, calculate the modulated delays for the late feedback. */
     mLate.Mod.calcDelays(todo);
 
-    /* Next, load decorrelated samples from the main and feedback delay lines.
-     * Filter the signal to apply its frequency-dependent decay.
+    /* Next, load decorrelated samples from the feedback delay lines and mix
+     * them with the late input. Filter the signal to apply its frequency-
+     * dependent decay.
      */
     for(size_t j{0u};j < NUM_LINES;j++)
     {
-        size_t late_delay_tap{offset - mLateDelayTap[j][0]};
         size_t late_feedb_tap{offset - mLate.Offset[j][0]};
         const float midGain{mLate.T60[j].MidGain[0]};
-        const float densityGain{mLate.DensityGain[0] * midGain};
 
-        for(size_t i{0u};i < todo;)
+        for(size_t i{0u};i < todo;++i)
         {
-            late_delay_tap &= main_delay.Mask;
-            size_t td{minz(todo - i, main_delay.Mask+1 - late_delay_tap)};
-            do {
-                /* Calculate the read offset and fraction between it and the
-                 * next sample.
-                 */
-                const float fdelay{mLate.Mod.ModDelays[i]};
-                const size_t delay{float2uint(fdelay)};
-                const float frac{fdelay - static_cast<float>(delay)};
-
-                /* Feed the delay line with the late feedback sample, and get
-                 * the two samples crossed by the delayed offset.
-                 */
-                const float out0{late_delay.Line[(late_feedb_tap-delay) & late_delay.Mask][j]};
-                const float out1{late_delay.Line[(late_feedb_tap-delay-1) & late_delay.Mask][j]};
-                ++late_feedb_tap;
-
-                /* The output is obtained by linearly interpolating the two
-                 * samples that were acquired above, and combined with the main
-                 * delay tap.
-                 */
-                mTempSamples[j][i] = lerpf(out0, out1, frac)*midGain +
-                    main_delay.Line[late_delay_tap++][j]*densityGain;
-                ++i;
-            } while(--td);
+            /* Calculate the read offset and fraction between it and the next
+             * sample.
+             */
+            const float fdelay{mLate.Mod.ModDelays[i]};
+            const size_t delay{float2uint(fdelay)};
+            const float frac{fdelay - static_cast<float>(delay)};
+
+            /* Feed the delay line with the late feedback sample, and get the
+             * two samples crossed by the delayed offset.
+             */
+            const float out0{late_delay.Line[(late_feedb_tap-delay) & late_delay.Mask][j]};
+            const float out1{late_delay.Line[(late_feedb_tap-delay-1) & late_delay.Mask][j]};
+            ++late_feedb_tap;
+
+            /* The output is obtained by linearly interpolating the two samples
+             * that were acquired above, and combined with the late input.
+             */
+            mTempSamples[j][i] = lerpf(out0, out1, frac)*midGain + mLateSamples[j][i];
         }
         mLate.T60[j].process({mTempSamples[j].data(), todo});
     }
@@ -1546,7 +1939,6 @@ void ReverbState::lateFaded(const size_t offset, const size_t todo, const float
     const float fadeStep)
 {
     const DelayLineI late_delay{mLate.Delay};
-    const DelayLineI main_delay{mDelay};
     const float mixX{mMixX};
     const float mixY{mMixY};
 
@@ -1560,45 +1952,29 @@ void ReverbState::lateFaded(const size_t offset, const size_t todo, const float
         const float midGain{mLate.T60[j].MidGain[1]};
         const float oldMidStep{-oldMidGain * fadeStep};
         const float midStep{midGain * fadeStep};
-        const float oldDensityGain{mLate.DensityGain[0] * oldMidGain};
-        const float densityGain{mLate.DensityGain[1] * midGain};
-        const float oldDensityStep{-oldDensityGain * fadeStep};
-        const float densityStep{densityGain * fadeStep};
-        size_t late_delay_tap0{offset - mLateDelayTap[j][0]};
-        size_t late_delay_tap1{offset - mLateDelayTap[j][1]};
         size_t late_feedb_tap0{offset - mLate.Offset[j][0]};
         size_t late_feedb_tap1{offset - mLate.Offset[j][1]};
         float fadeCount{fade};
 
-        for(size_t i{0u};i < todo;)
+        for(size_t i{0u};i < todo;++i)
         {
-            late_delay_tap0 &= main_delay.Mask;
-            late_delay_tap1 &= main_delay.Mask;
-            size_t td{minz(todo - i, main_delay.Mask+1 - maxz(late_delay_tap0, late_delay_tap1))};
-            do {
-                fadeCount += 1.0f;
-
-                const float fdelay{mLate.Mod.ModDelays[i]};
-                const size_t delay{float2uint(fdelay)};
-                const float frac{fdelay - static_cast<float>(delay)};
-
-                const float out00{late_delay.Line[(late_feedb_tap0-delay) & late_delay.Mask][j]};
-                const float out01{late_delay.Line[(late_feedb_tap0-delay-1) & late_delay.Mask][j]};
-                ++late_feedb_tap0;
-                const float out10{late_delay.Line[(late_feedb_tap1-delay) & late_delay.Mask][j]};
-                const float out11{late_delay.Line[(late_feedb_tap1-delay-1) & late_delay.Mask][j]};
-                ++late_feedb_tap1;
+            fadeCount += 1.0f;
 
-                const float fade0{oldDensityGain + oldDensityStep*fadeCount};
-                const float fade1{densityStep*fadeCount};
-                const float gfade0{oldMidGain + oldMidStep*fadeCount};
-                const float gfade1{midStep*fadeCount};
-                mTempSamples[j][i] = lerpf(out00, out01, frac)*gfade0 +
-                    lerpf(out10, out11, frac)*gfade1 +
-                    main_delay.Line[late_delay_tap0++][j]*fade0 +
-                    main_delay.Line[late_delay_tap1++][j]*fade1;
-                ++i;
-            } while(--td);
+            const float fdelay{mLate.Mod.ModDelays[i]};
+            const size_t delay{float2uint(fdelay)};
+            const float frac{fdelay - static_cast<float>(delay)};
+
+            const float out00{late_delay.Line[(late_feedb_tap0-delay) & late_delay.Mask][j]};
+            const float out01{late_delay.Line[(late_feedb_tap0-delay-1) & late_delay.Mask][j]};
+            ++late_feedb_tap0;
+            const float out10{late_delay.Line[(late_feedb_tap1-delay) & late_delay.Mask][j]};
+            const float out11{late_delay.Line[(late_feedb_tap1-delay-1) & late_delay.Mask][j]};
+            ++late_feedb_tap1;
+
+            const float gfade0{oldMidGain + oldMidStep*fadeCount};
+            const float gfade1{midStep*fadeCount};
+            mTempSamples[j][i] = lerpf(out00, out01, frac)*gfade0 +
+                lerpf(out10, out11, frac)*gfade1 + mLateSamples[j][i];
         }
         mLate.T60[j].process({mTempSamples[j].data(), todo});
     }
@@ -1616,6 +1992,8 @@ void ReverbState::process(const size_t samplesToDo, const al::span<const FloatBu
 
     ASSUME(samplesToDo > 0);
 
+    checkLateRate(samplesIn, samplesToDo);
+
     /* Convert B-Format to A-Format for processing. */
     const size_t numInput{minz(samplesIn.size(), NUM_LINES)};
     const al::span<float> tmpspan{al::assume_aligned<16>(mTempLine.data()), samplesToDo};
@@ -1654,7 +2032,19 @@ void ReverbState::process(const size_t samplesToDo, const al::span<const FloatBu
 
             /* Generate non-faded early reflections and late reverb. */
             earlyUnfaded(offset, todo);
-            lateUnfaded(offset, todo);
+            lateFeedUnfaded(offset, todo);
+            if(!mLateRateShift)
+                lateUnfaded(offset, todo);
+            else
+            {
+                const size_t count{decimateLate(todo)};
+                if(count > 0)
+                {
+                    lateUnfaded(mLateOffset, count);
+                    mLateOffset += count;
+                }
+                interpolateLate(count, todo);
+            }
 
             /* Finally, mix early reflections and late reverb. */
             mixOut(samplesOut, samplesToDo-base, base, todo);
@@ -1666,6 +2056,12 @@ void ReverbState::process(const size_t samplesToDo, const al::span<const FloatBu
     else
     {
         const float fadeStep{1.0f / static_cast<float>(samplesToDo)};
+        /* A reduced-rate late reverb fades over the number of samples it
+         * will process for this update.
+         */
+        const size_t lateTodo{(mLatePhase+samplesToDo) >> mLateRateShift};
+        const float lateFadeStep{1.0f / static_cast<float>(maxz(lateTodo, 1))};
+        float lateFadeCount{0.0f};
         for(size_t base{0};base < samplesToDo;)
         {
             size_t todo{minz(samplesToDo - base, minz(mMaxUpdate[0], mMaxUpdate[1]))};
@@ -1675,7 +2071,20 @@ void ReverbState::process(const size_t samplesToDo, const al::span<const FloatBu
             /* Generate cross-faded early reflections and late reverb. */
             auto fadeCount = static_cast<float>(base);
             earlyFaded(offset, todo, fadeCount, fadeStep);
-            lateFaded(offset, todo, fadeCount, fadeStep);
+            lateFeedFaded(offset, todo, fadeCount, fadeStep);
+            if(!mLateRateShift)
+                lateFaded(offset, todo, fadeCount, fadeStep);
+            else
+            {
+                const size_t count{decimateLate(todo)};
+                if(count > 0)
+                {
+                    lateFaded(mLateOffset, count, lateFadeCount, lateFadeStep);
+                    lateFadeCount += static_cast<float>(count);
+                    mLateOffset += count;
+                }
+                interpolateLate(count, todo);
+            }
 
             mixOut(samplesOut, samplesToDo-base, base, todo);
 
@@ -155,6 +155,7 @@ struct VmorpherState final : public EffectState {
 
     uint mIndex{0};
     uint mStep{1};
+    uint mTailSamples{0};
 
     /* Effects buffers */
     alignas(16) float mSampleBufferA[MAX_UPDATE_SAMPLES]{};
@@ -166,6 +167,7 @@ struct VmorpherState final : public EffectState {
         const EffectTarget target) override;
     void process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn,
         const al::span<FloatBufferLine> samplesOut) override;
+    uint tailLength() const noexcept override { return mTailSamples; }
 
     static std::array<FormantFilter,4> getFiltersByPhoneme(VMorpherPhenome phoneme,
         float frequency, float pitch);
@@ -262,6 +264,15 @@ void VmorpherState::update(const ContextBase *context, const EffectSlot *slot,
     auto vowelA = getFiltersByPhoneme(props->Vmorpher.PhonemeA, frequency, pitchA);
     auto vowelB = getFiltersByPhoneme(props->Vmorpher.PhonemeB, frequency, pitchB);
 
+    /* The lowest formant rings the longest. */
+    float mincoeff{1.0f};
+    for(const FormantFilter &formant : vowelA)
+        mincoeff = minf(mincoeff, formant.mCoeff);
+    for(const FormantFilter &formant : vowelB)
+        mincoeff = minf(mincoeff, formant.mCoeff);
+    mTailSamples = (mincoeff > 0.0f) ?
+        float2uint(Q_FACTOR * -std::log(EffectTailGain) / std::atan(mincoeff) + 0.5f) : 0u;
+
     /* Copy the filter coefficients to the input channels. */
     for(size_t i{0u};i < slot->Wet.Buffer.size();++i)
     {
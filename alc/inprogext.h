@@ -54,6 +54,38 @@ AL_API void AL_APIENTRY alAuxiliaryEffectSlotStopvSOFT(ALsizei n, const ALuint *
 #define AL_STOP_SOURCES_ON_DISCONNECT_SOFT       0x19AB
 #endif
 
+#ifndef AL_SOFT_batch_source_params
+#define AL_SOFT_batch_source_params
+typedef void (AL_APIENTRY*LPALSOURCESPARAMSSOFT)(ALsizei n, const ALuint *sources, const ALfloat *positions, const ALfloat *velocities, const ALfloat *gains);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API void AL_APIENTRY alSourcesParamsSOFT(ALsizei n, const ALuint *sources, const ALfloat *positions, const ALfloat *velocities, const ALfloat *gains);
+#endif
+#endif
+
+#ifndef ALC_SOFT_mixer_threads
+#define ALC_SOFT_mixer_threads
+#define ALC_MIXER_THREADS_SOFT                   0x19C0
+#endif
+
+#ifndef ALC_SOFT_mixer_budget
+#define ALC_SOFT_mixer_budget
+#define ALC_MIXER_DETAIL_LEVEL_SOFT              0x19C1
+#define ALC_FULL_DETAIL_VOICES_SOFT              0x19C2
+#define ALC_REDUCED_RESAMPLER_VOICES_SOFT        0x19C3
+#define ALC_REDUCED_SPATIAL_VOICES_SOFT          0x19C4
+#endif
+
+#ifndef ALC_SOFT_hrtf_coeff_cache
+#define ALC_SOFT_hrtf_coeff_cache
+#define ALC_HRTF_COEFF_CACHE_HITS_SOFT           0x19C5
+#define ALC_HRTF_COEFF_CACHE_MISSES_SOFT         0x19C6
+#endif
+
+#ifndef AL_SOFT_reverb_late_rate
+#define AL_SOFT_reverb_late_rate
+#define AL_REVERB_REDUCED_LATE_RATE_SOFT         0x19C7
+#endif
+
 
 /* Non-standard export. Not part of any extension. */
 AL_API const ALchar* AL_APIENTRY alsoft_get_version(void);
@@ -29,9 +29,12 @@
 #include <functional>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <new>
 #include <numeric>
 #include <string>
+#include <thread>
+#include <utility>
 
 #include "AL/al.h"
 #include "AL/alc.h"
@@ -54,6 +57,7 @@
 #include "core/bs2b.h"
 #include "core/devformat.h"
 #include "core/front_stablizer.h"
+#include "core/helpers.h"
 #include "core/hrtf.h"
 #include "core/logging.h"
 #include "core/uhjfilter.h"
@@ -705,7 +709,8 @@ void InitPanning(ALCdevice *device, const bool hqdec=false, const bool stablize=
         device->mXOverFreq/static_cast<float>(device->Frequency), std::move(stablizer));
 }
 
-void InitHrtfPanning(ALCdevice *device)
+std::unique_ptr<DirectHrtfState> CreateHrtfState(const HrtfStore *hrtf, const uint irsize,
+    const uint ambi_order, const float xoverfreq)
 {
     constexpr float Deg180{al::numbers::pi_v<float>};
     constexpr float Deg_90{Deg180 / 2.0f /* 90 degrees*/};
@@ -823,6 +828,32 @@ void InitHrtfPanning(ALCdevice *device)
     static_assert(al::size(AmbiPoints2O) == al::size(AmbiMatrix2O), "Second-Order Ambisonic HRTF mismatch");
     static_assert(al::size(AmbiPoints3O) == al::size(AmbiMatrix3O), "Third-Order Ambisonic HRTF mismatch");
 
+    al::span<const AngularPoint> AmbiPoints{AmbiPoints1O};
+    const float (*AmbiMatrix)[MaxAmbiChannels]{AmbiMatrix1O};
+    al::span<const float,MaxAmbiOrder+1> AmbiOrderHFGain{AmbiOrderHFGain1O};
+    if(ambi_order >= 3)
+    {
+        AmbiPoints = AmbiPoints3O;
+        AmbiMatrix = AmbiMatrix3O;
+        AmbiOrderHFGain = AmbiOrderHFGain3O;
+    }
+    else if(ambi_order == 2)
+    {
+        AmbiPoints = AmbiPoints2O;
+        AmbiMatrix = AmbiMatrix2O;
+        AmbiOrderHFGain = AmbiOrderHFGain2O;
+    }
+
+    auto hrtfstate = DirectHrtfState::Create(AmbiChannelsFromOrder(ambi_order));
+    hrtfstate->build(hrtf, irsize, AmbiPoints, AmbiMatrix, xoverfreq, AmbiOrderHFGain);
+    return hrtfstate;
+}
+
+/* Sets up the ambisonic mix for HRTF rendering, with the order from the
+ * hrtf-mode option. Returns the render mode to use with the HRTF.
+ */
+RenderMode InitHrtfMix(ALCdevice *device)
+{
     /* A 700hz crossover frequency provides tighter sound imaging at the sweet
      * spot with ambisonic decoding, as the distance between the ears is closer
      * to half this frequency wavelength, which is the optimal point where the
@@ -839,20 +870,26 @@ void InitHrtfPanning(ALCdevice *device)
     /* Don't bother with HOA when using full HRTF rendering. Nothing needs it,
      * and it eases the CPU/memory load.
      */
-    device->mRenderMode = RenderMode::Hrtf;
+    RenderMode rendermode{RenderMode::Hrtf};
     uint ambi_order{1};
+    bool hybrid{false};
     if(auto modeopt = device->configValue<std::string>(nullptr, "hrtf-mode"))
     {
         struct HrtfModeEntry {
             char name[8];
             RenderMode mode;
             uint order;
+            bool hybrid;
         };
+        /* Hybrid rendering pans most sources to the ambisonic mix, so it uses
+         * a higher order than full rendering.
+         */
         static const HrtfModeEntry hrtf_modes[]{
-            { "full", RenderMode::Hrtf, 1 },
-            { "ambi1", RenderMode::Normal, 1 },
-            { "ambi2", RenderMode::Normal, 2 },
-            { "ambi3", RenderMode::Normal, 3 },
+            { "full", RenderMode::Hrtf, 1, false },
+            { "hybrid", RenderMode::Hrtf, 2, true },
+            { "ambi1", RenderMode::Normal, 1, false },
+            { "ambi2", RenderMode::Normal, 2, false },
+            { "ambi3", RenderMode::Normal, 3, false },
         };
 
         const char *mode{modeopt->c_str()};
@@ -869,32 +906,16 @@ void InitHrtfPanning(ALCdevice *device)
             ERR("Unexpected hrtf-mode: %s\n", mode);
         else
         {
-            device->mRenderMode = iter->mode;
+            rendermode = iter->mode;
             ambi_order = iter->order;
+            hybrid = iter->hybrid;
         }
     }
-    TRACE("%u%s order %sHRTF rendering enabled, using \"%s\"\n", ambi_order,
-        (((ambi_order%100)/10) == 1) ? "th" :
-        ((ambi_order%10) == 1) ? "st" :
-        ((ambi_order%10) == 2) ? "nd" :
-        ((ambi_order%10) == 3) ? "rd" : "th",
-        (device->mRenderMode == RenderMode::Hrtf) ? "+ Full " : "",
-        device->mHrtfName.c_str());
-
-    al::span<const AngularPoint> AmbiPoints{AmbiPoints1O};
-    const float (*AmbiMatrix)[MaxAmbiChannels]{AmbiMatrix1O};
-    al::span<const float,MaxAmbiOrder+1> AmbiOrderHFGain{AmbiOrderHFGain1O};
-    if(ambi_order >= 3)
-    {
-        AmbiPoints = AmbiPoints3O;
-        AmbiMatrix = AmbiMatrix3O;
-        AmbiOrderHFGain = AmbiOrderHFGain3O;
-    }
-    else if(ambi_order == 2)
+    if(hybrid)
     {
-        AmbiPoints = AmbiPoints2O;
-        AmbiMatrix = AmbiMatrix2O;
-        AmbiOrderHFGain = AmbiOrderHFGain2O;
+        uint numdirect{device->configValue<uint>(nullptr, "hrtf-direct-sources").value_or(8u)};
+        device->mHrtfDirectVoices = clampu(numdirect, 1u, MaxHrtfDirectVoices);
+        TRACE("Using direct HRTF for up to %u sources\n", device->mHrtfDirectVoices);
     }
     device->mAmbiOrder = ambi_order;
 
@@ -905,15 +926,74 @@ void InitHrtfPanning(ALCdevice *device)
     );
     AllocChannels(device, count, device->channelsFromFmt());
 
+    return rendermode;
+}
+
+void InitHrtfPanning(ALCdevice *device)
+{
+    device->mRenderMode = InitHrtfMix(device);
+
+    const uint ambi_order{device->mAmbiOrder};
+    TRACE("%u%s order %sHRTF rendering enabled, using \"%s\"\n", ambi_order,
+        (((ambi_order%100)/10) == 1) ? "th" :
+        ((ambi_order%10) == 1) ? "st" :
+        ((ambi_order%10) == 2) ? "nd" :
+        ((ambi_order%10) == 3) ? "rd" : "th",
+        (device->mRenderMode != RenderMode::Hrtf) ? "" :
+        (device->mHrtfDirectVoices > 0) ? "+ Hybrid " : "+ Full ",
+        device->mHrtfName.c_str());
+
     HrtfStore *Hrtf{device->mHrtf.get()};
-    auto hrtfstate = DirectHrtfState::Create(count);
-    hrtfstate->build(Hrtf, device->mIrSize, AmbiPoints, AmbiMatrix, device->mXOverFreq,
-        AmbiOrderHFGain);
-    device->mHrtfState = std::move(hrtfstate);
+    device->mHrtfState = CreateHrtfState(Hrtf, device->mIrSize, ambi_order, device->mXOverFreq);
 
     InitNearFieldCtrl(device, Hrtf->field[0].distance, ambi_order, true);
 }
 
+/* Sets up the HRTF's ambisonic mix with a plain stereo decode, to render with
+ * while the HRTF loads in the background. Returns the render mode to switch
+ * to once it's loaded.
+ */
+RenderMode InitHrtfFallbackPanning(ALCdevice *device)
+{
+    const RenderMode rendermode{InitHrtfMix(device)};
+
+    /* Only the first-order horizontal channels are used for stereo. */
+    al::vector<ChannelDec> chancoeffs;
+    for(size_t i{0u};i < StereoConfig.mChannels.size();++i)
+    {
+        const uint idx{GetChannelIdxByName(device->RealOut, StereoConfig.mChannels[i])};
+        if(idx == INVALID_CHANNEL_INDEX)
+            continue;
+
+        chancoeffs.resize(maxz(chancoeffs.size(), idx+1u), ChannelDec{});
+        for(size_t ambichan{0};ambichan < Ambi2DChannelsFromOrder(1);++ambichan)
+        {
+            const uint8_t acn{AmbiIndex::FromACN2D()[ambichan]};
+            chancoeffs[idx][acn] = StereoConfig.mCoeffs[i][ambichan];
+        }
+    }
+
+    TRACE("Stereo rendering until the HRTF is loaded\n");
+    device->AmbiDecoder = BFormatDec::Create(AmbiChannelsFromOrder(device->mAmbiOrder),
+        chancoeffs, {}, device->mXOverFreq/static_cast<float>(device->Frequency), nullptr);
+
+    return rendermode;
+}
+
+/* Gets the impulse response length to use with the HRTF, which the hrtf-size
+ * option may shorten.
+ */
+uint GetHrtfIrSize(ALCdevice *device, const HrtfStore *hrtf)
+{
+    uint irsize{hrtf->irSize};
+    if(auto hrtfsizeopt = device->configValue<uint>(nullptr, "hrtf-size"))
+    {
+        if(*hrtfsizeopt > 0 && *hrtfsizeopt < irsize)
+            irsize = maxu(*hrtfsizeopt, MinIrLength);
+    }
+    return irsize;
+}
+
 void InitUhjPanning(ALCdevice *device)
 {
     /* UHJ is always 2D first-order. */
@@ -928,6 +1008,86 @@ void InitUhjPanning(ALCdevice *device)
     AllocChannels(device, count, device->channelsFromFmt());
 }
 
+void LoadHrtfAsync(ALCdevice *device, const al::vector<std::string> names, const uint devrate,
+    const al::optional<std::string> mappath, const al::optional<std::string> cachepath,
+    const uint64_t cachelimit, const RenderMode rendermode)
+{
+    HrtfStorePtr hrtf;
+    auto name_iter = names.cbegin();
+    for(;name_iter != names.cend();++name_iter)
+    {
+        if(device->mHrtfLoaderQuit.load(std::memory_order_acquire))
+            return;
+        if((hrtf = GetLoadedHrtf(*name_iter, devrate, mappath, cachepath, cachelimit)))
+            break;
+    }
+    if(!hrtf)
+    {
+        WARN("Failed to load an HRTF in the background\n");
+        return;
+    }
+
+    if(auto cachesizeopt = device->configValue<uint>(nullptr, "hrtf-coeff-cache"))
+        EnableHrtfCoeffCache(hrtf.get(), *cachesizeopt);
+
+    /* Build the renderer here too, so the mixer only has to switch to it.
+     * The device's mix was already set up for it with the reset.
+     */
+    auto renderer = std::make_unique<HrtfRenderer>();
+    renderer->mIrSize = GetHrtfIrSize(device, hrtf.get());
+    renderer->mState = CreateHrtfState(hrtf.get(), renderer->mIrSize, device->mAmbiOrder,
+        device->mXOverFreq);
+    renderer->mRenderMode = rendermode;
+
+    /* Near-field control is set up like InitNearFieldCtrl does, but the
+     * device's values are only updated when handing it over.
+     */
+    float nfc_w1{0.0f};
+    const float ctrl_dist{hrtf->field[0].distance};
+    if(device->getConfigValueBool("decoder", "nfc", 0) && ctrl_dist > 0.0f)
+    {
+        static const uint chans_per_order3d[MaxAmbiOrder+1]{ 1, 3, 5, 7 };
+
+        renderer->mAvgSpeakerDist = clampf(ctrl_dist, 0.1f, 10.0f);
+        nfc_w1 = SpeedOfSoundMetersPerSec /
+            (renderer->mAvgSpeakerDist * static_cast<float>(device->Frequency));
+        std::copy_n(chans_per_order3d, device->mAmbiOrder+1u,
+            renderer->mNumChannelsPerOrder.begin());
+    }
+
+    /* Hand it over with the device state locked, for the HRTF queries. Use a
+     * try-lock so the loader can be stopped and joined by a thread holding
+     * the lock.
+     */
+    std::unique_lock<std::mutex> statelock{device->StateLock, std::defer_lock};
+    while(!statelock.try_lock())
+    {
+        if(device->mHrtfLoaderQuit.load(std::memory_order_acquire))
+            return;
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+
+    TRACE("Switching to HRTF \"%s\"\n", name_iter->c_str());
+    if(renderer->mAvgSpeakerDist > 0.0f)
+    {
+        TRACE("Using near-field reference distance: %.2f meters\n", renderer->mAvgSpeakerDist);
+
+        /* New voices copy the device's filter when they start, which happens
+         * with the context's source lock held. The mixer resets the playing
+         * voices' filters once it switches over.
+         */
+        al::vector<std::unique_lock<std::mutex>> srclocks;
+        for(ContextBase *ctxbase : *device->mContexts.load(std::memory_order_acquire))
+            srclocks.emplace_back(static_cast<ALCcontext*>(ctxbase)->mSourceLock);
+        device->mNFCtrlFilter.init(nfc_w1);
+    }
+    device->mHrtf = std::move(hrtf);
+    device->mHrtfName = *name_iter;
+    device->mHrtfStatus = ALC_HRTF_ENABLED_SOFT;
+    device->mHrtfRenderer = std::move(renderer);
+    device->mPendingHrtf.store(device->mHrtfRenderer.get(), std::memory_order_release);
+}
+
 } // namespace
 
 void aluInitRenderer(ALCdevice *device, int hrtf_id, al::optional<StereoEncoding> stereomode)
@@ -938,6 +1098,7 @@ void aluInitRenderer(ALCdevice *device, int hrtf_id, al::optional<StereoEncoding
     device->mHrtfState = nullptr;
     device->mHrtf = nullptr;
     device->mIrSize = 0;
+    device->mHrtfDirectVoices = 0;
     device->mHrtfName.clear();
     device->mXOverFreq = 400.0f;
     device->mRenderMode = RenderMode::Normal;
@@ -1040,10 +1201,46 @@ void aluInitRenderer(ALCdevice *device, int hrtf_id, al::optional<StereoEncoding
         if(device->mHrtfList.empty())
             device->enumerateHrtfs();
 
+        const auto mappath = device->configValue<std::string>(nullptr, "hrtf-map-path");
+        al::optional<std::string> cachepath;
+        /* The cache size limit is in megabytes. */
+        const uint64_t cachelimit{uint64_t{device->configValue<uint>(nullptr, "hrtf-cache-size")
+            .value_or(64)} << 20};
+        if(device->configValue<bool>(nullptr, "hrtf-cache").value_or(true) && cachelimit > 0)
+        {
+            cachepath = device->configValue<std::string>(nullptr, "hrtf-cache-path");
+            if(!cachepath)
+                cachepath = al::make_optional(GetCachePath("openal/hrtf"));
+        }
+
+        /* With the hrtf-async option, load the HRTF on a worker thread and
+         * render the same mix with plain stereo panning until it's ready.
+         * Loopback devices are rendered whenever the app asks, so they always
+         * load it here.
+         */
+        if(device->Type != DeviceType::Loopback
+            && device->getConfigValueBool(nullptr, "hrtf-async", false))
+        {
+            al::vector<std::string> names;
+            names.reserve(device->mHrtfList.size() + 1);
+            if(hrtf_id >= 0 && static_cast<uint>(hrtf_id) < device->mHrtfList.size())
+                names.emplace_back(device->mHrtfList[static_cast<uint>(hrtf_id)]);
+            names.insert(names.end(), device->mHrtfList.cbegin(), device->mHrtfList.cend());
+
+            const RenderMode rendermode{InitHrtfFallbackPanning(device)};
+            device->PostProcess = &ALCdevice::ProcessAmbiDec;
+
+            TRACE("Loading HRTF in the background\n");
+            device->mHrtfLoader = std::thread{LoadHrtfAsync, device, std::move(names),
+                device->Frequency, mappath, cachepath, cachelimit, rendermode};
+            return;
+        }
+
         if(hrtf_id >= 0 && static_cast<uint>(hrtf_id) < device->mHrtfList.size())
         {
             const std::string &hrtfname = device->mHrtfList[static_cast<uint>(hrtf_id)];
-            if(HrtfStorePtr hrtf{GetLoadedHrtf(hrtfname, device->Frequency)})
+            if(HrtfStorePtr hrtf{GetLoadedHrtf(hrtfname, device->Frequency, mappath, cachepath,
+                cachelimit)})
             {
                 device->mHrtf = std::move(hrtf);
                 device->mHrtfName = hrtfname;
@@ -1054,7 +1251,8 @@ void aluInitRenderer(ALCdevice *device, int hrtf_id, al::optional<StereoEncoding
         {
             for(const auto &hrtfname : device->mHrtfList)
             {
-                if(HrtfStorePtr hrtf{GetLoadedHrtf(hrtfname, device->Frequency)})
+                if(HrtfStorePtr hrtf{GetLoadedHrtf(hrtfname, device->Frequency, mappath, cachepath,
+                    cachelimit)})
                 {
                     device->mHrtf = std::move(hrtf);
                     device->mHrtfName = hrtfname;
@@ -1068,13 +1266,10 @@ void aluInitRenderer(ALCdevice *device, int hrtf_id, al::optional<StereoEncoding
             old_hrtf = nullptr;
 
             HrtfStore *hrtf{device->mHrtf.get()};
-            device->mIrSize = hrtf->irSize;
-            if(auto hrtfsizeopt = device->configValue<uint>(nullptr, "hrtf-size"))
-            {
-                if(*hrtfsizeopt > 0 && *hrtfsizeopt < device->mIrSize)
-                    device->mIrSize = maxu(*hrtfsizeopt, MinIrLength);
-            }
+            if(auto cachesizeopt = device->configValue<uint>(nullptr, "hrtf-coeff-cache"))
+                EnableHrtfCoeffCache(hrtf, *cachesizeopt);
 
+            device->mIrSize = GetHrtfIrSize(device, hrtf);
             InitHrtfPanning(device);
             device->PostProcess = &ALCdevice::ProcessHrtf;
             device->mHrtfStatus = ALC_HRTF_ENABLED_SOFT;
@@ -1166,4 +1361,7 @@ void aluInitEffectPanning(EffectSlot *slot, ALCcontext *context)
         { return BFChannelConfig{1.0f, acn}; });
     std::fill(iter, slot->Wet.AmbiMap.end(), BFChannelConfig{});
     slot->Wet.Buffer = wetbuffer->mBuffer;
+
+    /* The wet buffer may have old samples, so make sure it gets cleared. */
+    slot->mSleeping = false;
 }
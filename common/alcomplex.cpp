@@ -9,6 +9,12 @@
 #include <cstddef>
 #include <utility>
 
+#ifdef HAVE_SSE_INTRINSICS
+#include <xmmintrin.h>
+#elif defined(HAVE_NEON)
+#include <arm_neon.h>
+#endif
+
 #include "albit.h"
 #include "alnumbers.h"
 #include "alnumeric.h"
@@ -91,6 +97,292 @@ constexpr al::span<const ushort2> gBitReverses[11]{
     BitReverser10.mData
 };
 
+
+#if defined(HAVE_SSE_INTRINSICS) || defined(HAVE_NEON)
+/* A vector of four floats for the FFT kernels. The arithmetic operators let
+ * the butterflies be shared with the scalar path.
+ */
+struct float4 {
+#ifdef HAVE_SSE_INTRINSICS
+    __m128 v;
+#else
+    float32x4_t v;
+#endif
+};
+
+#ifdef HAVE_SSE_INTRINSICS
+inline float4 load4(const float *src) noexcept { return float4{_mm_loadu_ps(src)}; }
+inline void store4(float *dst, const float4 val) noexcept { _mm_storeu_ps(dst, val.v); }
+inline float4 splat4(const float val) noexcept { return float4{_mm_set1_ps(val)}; }
+inline float4 operator+(const float4 a, const float4 b) noexcept
+{ return float4{_mm_add_ps(a.v, b.v)}; }
+inline float4 operator-(const float4 a, const float4 b) noexcept
+{ return float4{_mm_sub_ps(a.v, b.v)}; }
+inline float4 operator*(const float4 a, const float4 b) noexcept
+{ return float4{_mm_mul_ps(a.v, b.v)}; }
+
+inline void transpose4(float4 &a, float4 &b, float4 &c, float4 &d) noexcept
+{ _MM_TRANSPOSE4_PS(a.v, b.v, c.v, d.v); }
+
+/* Loads 8 interleaved values, as 4 even and 4 odd values. */
+inline void load_deinterleave4(const float *src, float4 &even, float4 &odd) noexcept
+{
+    const __m128 lo{_mm_loadu_ps(src)}, hi{_mm_loadu_ps(src+4)};
+    even.v = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2,0,2,0));
+    odd.v = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3,1,3,1));
+}
+inline void store_interleave4(float *dst, const float4 even, const float4 odd) noexcept
+{
+    _mm_storeu_ps(dst, _mm_unpacklo_ps(even.v, odd.v));
+    _mm_storeu_ps(dst+4, _mm_unpackhi_ps(even.v, odd.v));
+}
+
+#else
+
+inline float4 load4(const float *src) noexcept { return float4{vld1q_f32(src)}; }
+inline void store4(float *dst, const float4 val) noexcept { vst1q_f32(dst, val.v); }
+inline float4 splat4(const float val) noexcept { return float4{vdupq_n_f32(val)}; }
+inline float4 operator+(const float4 a, const float4 b) noexcept
+{ return float4{vaddq_f32(a.v, b.v)}; }
+inline float4 operator-(const float4 a, const float4 b) noexcept
+{ return float4{vsubq_f32(a.v, b.v)}; }
+inline float4 operator*(const float4 a, const float4 b) noexcept
+{ return float4{vmulq_f32(a.v, b.v)}; }
+
+inline void transpose4(float4 &a, float4 &b, float4 &c, float4 &d) noexcept
+{
+    const float32x4x2_t ab{vtrnq_f32(a.v, b.v)};
+    const float32x4x2_t cd{vtrnq_f32(c.v, d.v)};
+    a.v = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+    b.v = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+    c.v = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+    d.v = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+}
+
+inline void load_deinterleave4(const float *src, float4 &even, float4 &odd) noexcept
+{
+    const float32x4x2_t vals{vld2q_f32(src)};
+    even.v = vals.val[0];
+    odd.v = vals.val[1];
+}
+inline void store_interleave4(float *dst, const float4 even, const float4 odd) noexcept
+{
+    float32x4x2_t vals;
+    vals.val[0] = even.v;
+    vals.val[1] = odd.v;
+    vst2q_f32(dst, vals);
+}
+#endif
+#endif
+
+/* Multiplies a by b, or by the conjugate of b for inverse transforms. */
+template<bool Inverse, typename T>
+inline void complex_mul(T &outr, T &outi, const T ar, const T ai, const T br, const T bi) noexcept
+{
+    if(Inverse)
+    {
+        outr = ar*br + ai*bi;
+        outi = ai*br - ar*bi;
+    }
+    else
+    {
+        outr = ar*br - ai*bi;
+        outi = ai*br + ar*bi;
+    }
+}
+
+/* A radix-4 butterfly, with the twiddle factors for the last three outputs. */
+template<bool Inverse, typename T>
+inline void radix4(const T (&xr)[4], const T (&xi)[4], const T (&wr)[3], const T (&wi)[3],
+    T (&yr)[4], T (&yi)[4]) noexcept
+{
+    const T apcr{xr[0] + xr[2]}, apci{xi[0] + xi[2]};
+    const T amcr{xr[0] - xr[2]}, amci{xi[0] - xi[2]};
+    const T bpdr{xr[1] + xr[3]}, bpdi{xi[1] + xi[3]};
+    const T bmdr{xr[1] - xr[3]}, bmdi{xi[1] - xi[3]};
+
+    /* The odd outputs rotate b-d by -i and +i for forward transforms, or by +i
+     * and -i for inverse transforms.
+     */
+    const T t1r{Inverse ? amcr - bmdi : amcr + bmdi};
+    const T t1i{Inverse ? amci + bmdr : amci - bmdr};
+    const T t3r{Inverse ? amcr + bmdi : amcr - bmdi};
+    const T t3i{Inverse ? amci - bmdr : amci + bmdr};
+
+    yr[0] = apcr + bpdr;
+    yi[0] = apci + bpdi;
+    complex_mul<Inverse>(yr[1], yi[1], t1r, t1i, wr[0], wi[0]);
+    complex_mul<Inverse>(yr[2], yi[2], apcr - bpdr, apci - bpdi, wr[1], wi[1]);
+    complex_mul<Inverse>(yr[3], yi[3], t3r, t3i, wr[2], wi[2]);
+}
+
+/* Applies a radix-4 stage of Stockham's auto-sort FFT, for sub-sequences of
+ * length n with stride s. The twiddle factors are stored as three pairs of
+ * real and imaginary arrays, each with n/4 values.
+ */
+template<bool Inverse>
+void radix4_stage(const size_t n, const size_t s, const float *RESTRICT tw,
+    const float *RESTRICT xr, const float *RESTRICT xi, float *RESTRICT yr, float *RESTRICT yi)
+{
+    const size_t m{n / 4};
+    const size_t sm{s * m};
+
+#if defined(HAVE_SSE_INTRINSICS) || defined(HAVE_NEON)
+    if(s == 1 && m >= 4)
+    {
+        /* The first stage processes four butterflies at once, transposing
+         * the results to store each butterfly's outputs together.
+         */
+        for(size_t p{0};p < m;p += 4)
+        {
+            const float4 ar[4]{load4(xr+p), load4(xr+m+p), load4(xr+2*m+p), load4(xr+3*m+p)};
+            const float4 ai[4]{load4(xi+p), load4(xi+m+p), load4(xi+2*m+p), load4(xi+3*m+p)};
+            const float4 wr[3]{load4(tw+p), load4(tw+2*m+p), load4(tw+4*m+p)};
+            const float4 wi[3]{load4(tw+m+p), load4(tw+3*m+p), load4(tw+5*m+p)};
+            float4 br[4], bi[4];
+            radix4<Inverse>(ar, ai, wr, wi, br, bi);
+            transpose4(br[0], br[1], br[2], br[3]);
+            transpose4(bi[0], bi[1], bi[2], bi[3]);
+            for(size_t r{0};r < 4;++r)
+            {
+                store4(yr + 4*(p+r), br[r]);
+                store4(yi + 4*(p+r), bi[r]);
+            }
+        }
+        return;
+    }
+    if(s >= 4)
+    {
+        for(size_t p{0};p < m;++p)
+        {
+            const float4 wr[3]{splat4(tw[p]), splat4(tw[2*m+p]), splat4(tw[4*m+p])};
+            const float4 wi[3]{splat4(tw[m+p]), splat4(tw[3*m+p]), splat4(tw[5*m+p])};
+            const float *RESTRICT inr{xr + s*p};
+            const float *RESTRICT ini{xi + s*p};
+            float *RESTRICT outr{yr + s*4*p};
+            float *RESTRICT outi{yi + s*4*p};
+            for(size_t q{0};q < s;q += 4)
+            {
+                const float4 ar[4]{load4(inr+q), load4(inr+sm+q), load4(inr+2*sm+q),
+                    load4(inr+3*sm+q)};
+                const float4 ai[4]{load4(ini+q), load4(ini+sm+q), load4(ini+2*sm+q),
+                    load4(ini+3*sm+q)};
+                float4 br[4], bi[4];
+                radix4<Inverse>(ar, ai, wr, wi, br, bi);
+                for(size_t r{0};r < 4;++r)
+                {
+                    store4(outr + s*r + q, br[r]);
+                    store4(outi + s*r + q, bi[r]);
+                }
+            }
+        }
+        return;
+    }
+#endif
+
+    for(size_t p{0};p < m;++p)
+    {
+        const float wr[3]{tw[p], tw[2*m+p], tw[4*m+p]};
+        const float wi[3]{tw[m+p], tw[3*m+p], tw[5*m+p]};
+        const float *RESTRICT inr{xr + s*p};
+        const float *RESTRICT ini{xi + s*p};
+        float *RESTRICT outr{yr + s*4*p};
+        float *RESTRICT outi{yi + s*4*p};
+        for(size_t q{0};q < s;++q)
+        {
+            const float ar[4]{inr[q], inr[sm+q], inr[2*sm+q], inr[3*sm+q]};
+            const float ai[4]{ini[q], ini[sm+q], ini[2*sm+q], ini[3*sm+q]};
+            float br[4], bi[4];
+            radix4<Inverse>(ar, ai, wr, wi, br, bi);
+            for(size_t r{0};r < 4;++r)
+            {
+                outr[s*r + q] = br[r];
+                outi[s*r + q] = bi[r];
+            }
+        }
+    }
+}
+
+/* Applies the final radix-2 stage of Stockham's auto-sort FFT, for odd powers
+ * of 2. The twiddle factor for this stage is always 1.
+ */
+void radix2_stage(const size_t s, const float *RESTRICT xr, const float *RESTRICT xi,
+    float *RESTRICT yr, float *RESTRICT yi)
+{
+    size_t q{0};
+#if defined(HAVE_SSE_INTRINSICS) || defined(HAVE_NEON)
+    for(;s-q >= 4;q += 4)
+    {
+        const float4 ar{load4(xr+q)}, ai{load4(xi+q)};
+        const float4 br{load4(xr+s+q)}, bi{load4(xi+s+q)};
+        store4(yr+q, ar + br);
+        store4(yi+q, ai + bi);
+        store4(yr+s+q, ar - br);
+        store4(yi+s+q, ai - bi);
+    }
+#endif
+    for(;q < s;++q)
+    {
+        const float ar{xr[q]}, ai{xi[q]};
+        const float br{xr[s+q]}, bi{xi[s+q]};
+        yr[q] = ar + br;
+        yi[q] = ai + bi;
+        yr[s+q] = ar - br;
+        yi[s+q] = ai - bi;
+    }
+}
+
+/* Applies a complex FFT of the given size. Each stage moves the values between
+ * the given arrays and the work arrays, so this returns whether the result
+ * ended up in the work arrays.
+ */
+template<bool Inverse>
+bool apply_fft(const size_t fftsize, const float *tw, float *re, float *im, float *workre,
+    float *workim)
+{
+    float *xr{re}, *xi{im}, *yr{workre}, *yi{workim};
+    size_t n{fftsize}, s{1};
+    for(;n >= 4;n /= 4, s *= 4)
+    {
+        radix4_stage<Inverse>(n, s, tw, xr, xi, yr, yi);
+        tw += n/4 * 6;
+        std::swap(xr, yr);
+        std::swap(xi, yi);
+    }
+    if(n == 2)
+    {
+        radix2_stage(s, xr, xi, yr, yi);
+        std::swap(xr, yr);
+        std::swap(xi, yi);
+    }
+    return xr != re;
+}
+
+/* Appends the twiddle factors for each radix-4 stage of an FFT of the given
+ * size.
+ */
+void append_stage_twiddles(al::vector<float,16> &twiddles, const size_t fftsize)
+{
+    for(size_t n{fftsize};n >= 4;n /= 4)
+    {
+        const size_t m{n / 4};
+        const size_t base{twiddles.size()};
+        twiddles.resize(base + m*6);
+        for(size_t r{1};r < 4;++r)
+        {
+            float *wr{&twiddles[base + (r-1)*2*m]};
+            float *wi{wr + m};
+            for(size_t p{0};p < m;++p)
+            {
+                const double phase{-2.0 * al::numbers::pi * static_cast<double>(r*p) /
+                    static_cast<double>(n)};
+                wr[p] = static_cast<float>(std::cos(phase));
+                wi[p] = static_cast<float>(std::sin(phase));
+            }
+        }
+    }
+}
+
 } // namespace
 
 void complex_fft(const al::span<std::complex<double>> buffer, const double sign)
@@ -164,3 +456,145 @@ void complex_hilbert(const al::span<std::complex<double>> buffer)
 
     forward_fft(buffer);
 }
+
+
+ComplexFftPlan::ComplexFftPlan(const size_t fftsize) : mSize{fftsize}
+{
+    assert(al::popcount(fftsize) == 1);
+    append_stage_twiddles(mTwiddles, fftsize);
+    mWork.resize(fftsize * 2);
+}
+
+void ComplexFftPlan::forward(float *re, float *im)
+{
+    float *workre{mWork.data()}, *workim{workre + mSize};
+    if(apply_fft<false>(mSize, mTwiddles.data(), re, im, workre, workim))
+    {
+        std::copy_n(workre, mSize, re);
+        std::copy_n(workim, mSize, im);
+    }
+}
+
+void ComplexFftPlan::inverse(float *re, float *im)
+{
+    float *workre{mWork.data()}, *workim{workre + mSize};
+    if(apply_fft<true>(mSize, mTwiddles.data(), re, im, workre, workim))
+    {
+        std::copy_n(workre, mSize, re);
+        std::copy_n(workim, mSize, im);
+    }
+}
+
+
+/* A real FFT of size N is calculated with a complex FFT of size N/2, using the
+ * even samples as the real components and the odd samples as the imaginary
+ * components. The even and odd samples' bins are then separated from the
+ * result, and combined with the twiddle factors exp(-2*pi*i*k/N) for the
+ * full signal's bins. The inverse transform reverses these steps.
+ */
+RealFftPlan::RealFftPlan(const size_t fftsize) : mSize{fftsize}
+{
+    assert(fftsize >= 2 && al::popcount(fftsize) == 1);
+
+    const size_t half{fftsize / 2};
+    const size_t count{half/2 + 1};
+    mTwiddles.resize(count * 2);
+    for(size_t k{0};k < count;++k)
+    {
+        const double phase{-2.0 * al::numbers::pi * static_cast<double>(k) /
+            static_cast<double>(fftsize)};
+        mTwiddles[k] = static_cast<float>(std::cos(phase));
+        mTwiddles[count+k] = static_cast<float>(std::sin(phase));
+    }
+    append_stage_twiddles(mTwiddles, half);
+    mWork.resize(half * 4);
+}
+
+void RealFftPlan::forward(const float *input, float *outre, float *outim)
+{
+    const size_t half{mSize / 2};
+    const size_t count{half/2 + 1};
+    float *zr{mWork.data()}, *zi{zr + half};
+    float *workre{zi + half}, *workim{workre + half};
+
+    size_t i{0};
+#if defined(HAVE_SSE_INTRINSICS) || defined(HAVE_NEON)
+    for(;half-i >= 4;i += 4)
+    {
+        float4 even, odd;
+        load_deinterleave4(input + i*2, even, odd);
+        store4(zr+i, even);
+        store4(zi+i, odd);
+    }
+#endif
+    for(;i < half;++i)
+    {
+        zr[i] = input[i*2];
+        zi[i] = input[i*2 + 1];
+    }
+
+    if(apply_fft<false>(half, mTwiddles.data() + count*2, zr, zi, workre, workim))
+    {
+        zr = workre;
+        zi = workim;
+    }
+
+    const float *RESTRICT twr{mTwiddles.data()};
+    const float *RESTRICT twi{twr + count};
+    outre[0] = zr[0] + zi[0];
+    outim[0] = 0.0f;
+    outre[half] = zr[0] - zi[0];
+    outim[half] = 0.0f;
+    for(size_t k{1};k < count;++k)
+    {
+        const size_t j{half - k};
+        const float er{(zr[k] + zr[j]) * 0.5f}, ei{(zi[k] - zi[j]) * 0.5f};
+        const float or_{(zi[k] + zi[j]) * 0.5f}, oi{(zr[j] - zr[k]) * 0.5f};
+        const float tr{twr[k]*or_ - twi[k]*oi}, ti{twr[k]*oi + twi[k]*or_};
+        outre[k] = er + tr;
+        outim[k] = ei + ti;
+        outre[j] = er - tr;
+        outim[j] = ti - ei;
+    }
+}
+
+void RealFftPlan::inverse(const float *inre, const float *inim, float *output)
+{
+    const size_t half{mSize / 2};
+    const size_t count{half/2 + 1};
+    float *zr{mWork.data()}, *zi{zr + half};
+    float *workre{zi + half}, *workim{workre + half};
+
+    const float *RESTRICT twr{mTwiddles.data()};
+    const float *RESTRICT twi{twr + count};
+    zr[0] = inre[0] + inre[half];
+    zi[0] = inre[0] - inre[half];
+    for(size_t k{1};k < count;++k)
+    {
+        const size_t j{half - k};
+        const float er{inre[k] + inre[j]}, ei{inim[k] - inim[j]};
+        const float dr{inre[k] - inre[j]}, di{inim[k] + inim[j]};
+        const float or_{dr*twr[k] + di*twi[k]}, oi{di*twr[k] - dr*twi[k]};
+        zr[k] = er - oi;
+        zi[k] = ei + or_;
+        zr[j] = er + oi;
+        zi[j] = or_ - ei;
+    }
+
+    if(apply_fft<true>(half, mTwiddles.data() + count*2, zr, zi, workre, workim))
+    {
+        zr = workre;
+        zi = workim;
+    }
+
+    size_t i{0};
+#if defined(HAVE_SSE_INTRINSICS) || defined(HAVE_NEON)
+    for(;half-i >= 4;i += 4)
+        store_interleave4(output + i*2, load4(zr+i), load4(zi+i));
+#endif
+    for(;i < half;++i)
+    {
+        output[i*2] = zr[i];
+        output[i*2 + 1] = zi[i];
+    }
+}
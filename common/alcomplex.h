@@ -2,8 +2,10 @@
 #define ALCOMPLEX_H
 
 #include <complex>
+#include <stddef.h>
 
 #include "alspan.h"
+#include "vector.h"
 
 /**
  * Iterative implementation of 2-radix FFT (In-place algorithm). Sign = -1 is
@@ -35,4 +37,62 @@ inline void inverse_fft(const al::span<std::complex<double>> buffer)
  */
 void complex_hilbert(const al::span<std::complex<double>> buffer);
 
+
+/**
+ * A precomputed plan for single-precision complex FFTs of a given power-of-two
+ * size. Complex values are given as separate arrays of real and imaginary
+ * components. The transforms are unscaled, so an inverse transform of a
+ * forward transform's output is scaled up by the FFT size.
+ *
+ * The plan holds temporary storage used by the transforms, so one plan can't
+ * be used by multiple threads at once.
+ */
+class ComplexFftPlan {
+    size_t mSize{0};
+    al::vector<float,16> mTwiddles;
+    al::vector<float,16> mWork;
+
+public:
+    ComplexFftPlan() = default;
+    explicit ComplexFftPlan(const size_t fftsize);
+
+    size_t size() const noexcept { return mSize; }
+
+    /** Applies a forward FFT to the size() values, in-place. */
+    void forward(float *re, float *im);
+    /** Applies an inverse FFT to the size() values, in-place. */
+    void inverse(float *re, float *im);
+};
+
+/**
+ * A precomputed plan for single-precision FFTs of real signals with a given
+ * power-of-two size (at least 2). A real signal's frequency response is
+ * conjugate-symmetric, so only the first size()/2 + 1 bins are used, with the
+ * imaginary components of the first and last bins being 0. As with
+ * ComplexFftPlan, the transforms are unscaled and one plan can't be used by
+ * multiple threads at once.
+ */
+class RealFftPlan {
+    size_t mSize{0};
+    al::vector<float,16> mTwiddles;
+    al::vector<float,16> mWork;
+
+public:
+    RealFftPlan() = default;
+    explicit RealFftPlan(const size_t fftsize);
+
+    size_t size() const noexcept { return mSize; }
+
+    /**
+     * Calculates the size()/2 + 1 frequency bins of the size() real input
+     * samples.
+     */
+    void forward(const float *input, float *outre, float *outim);
+    /**
+     * Calculates the size() real output samples of the size()/2 + 1 frequency
+     * bins. The imaginary components of the first and last bins are ignored.
+     */
+    void inverse(const float *inre, const float *inim, float *output);
+};
+
 #endif /* ALCOMPLEX_H */
@@ -16,6 +16,8 @@ uint BytesFromFmt(FmtType type) noexcept
     case FmtDouble: return sizeof(double);
     case FmtMulaw: return sizeof(uint8_t);
     case FmtAlaw: return sizeof(uint8_t);
+    case FmtIMA4: break; /* not handled here */
+    case FmtMSADPCM: break; /* not handled here */
     }
     return 0;
 }
@@ -40,3 +42,27 @@ uint ChannelsFromFmt(FmtChannels chans, uint ambiorder) noexcept
     }
     return 0;
 }
+
+uint BlockSizeFromFmt(FmtChannels chans, FmtType type, uint ambiorder, uint blockalign) noexcept
+{
+    const uint numchans{ChannelsFromFmt(chans, ambiorder)};
+    switch(type)
+    {
+    /* IMA4 has a 4-byte header per channel, with the first sample, followed
+     * by 4-bit samples.
+     */
+    case FmtIMA4: return ((blockalign-1)/2 + 4) * numchans;
+    /* MSADPCM has a 7-byte header per channel, with the first two samples,
+     * followed by 4-bit samples.
+     */
+    case FmtMSADPCM: return ((blockalign-2)/2 + 7) * numchans;
+    case FmtUByte:
+    case FmtShort:
+    case FmtFloat:
+    case FmtDouble:
+    case FmtMulaw:
+    case FmtAlaw:
+        break;
+    }
+    return blockalign * numchans * BytesFromFmt(type);
+}
@@ -18,6 +18,8 @@ enum FmtType : unsigned char {
     FmtDouble,
     FmtMulaw,
     FmtAlaw,
+    FmtIMA4,
+    FmtMSADPCM,
 };
 enum FmtChannels : unsigned char {
     FmtMono,
@@ -51,6 +53,16 @@ uint ChannelsFromFmt(FmtChannels chans, uint ambiorder) noexcept;
 inline uint FrameSizeFromFmt(FmtChannels chans, FmtType type, uint ambiorder) noexcept
 { return ChannelsFromFmt(chans, ambiorder) * BytesFromFmt(type); }
 
+/**
+ * Returns the size in bytes of a block of samples for the given block
+ * alignment (in sample frames). For uncompressed formats, this is just the
+ * size of the sample frames.
+ */
+uint BlockSizeFromFmt(FmtChannels chans, FmtType type, uint ambiorder, uint blockalign) noexcept;
+
+constexpr bool IsCompressedFmt(FmtType type) noexcept
+{ return type == FmtIMA4 || type == FmtMSADPCM; }
+
 constexpr bool IsBFormat(FmtChannels chans) noexcept
 { return chans == FmtBFormat2D || chans == FmtBFormat3D; }
 
@@ -83,6 +95,8 @@ struct BufferStorage {
     FmtChannels mChannels{FmtMono};
     FmtType mType{FmtShort};
     uint mSampleLen{0u};
+    /* Number of sample frames per block for compressed formats, 1 otherwise. */
+    uint mBlockAlign{1u};
 
     AmbiLayout mAmbiLayout{AmbiLayout::FuMa};
     AmbiScaling mAmbiScaling{AmbiScaling::FuMa};
@@ -92,6 +106,8 @@ struct BufferStorage {
     inline uint channelsFromFmt() const noexcept
     { return ChannelsFromFmt(mChannels, mAmbiOrder); }
     inline uint frameSizeFromFmt() const noexcept { return channelsFromFmt() * bytesFromFmt(); }
+    inline uint blockSizeFromFmt() const noexcept
+    { return BlockSizeFromFmt(mChannels, mType, mAmbiOrder, mBlockAlign); }
 
     inline bool isBFormat() const noexcept { return IsBFormat(mChannels); }
 };
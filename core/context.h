@@ -123,6 +123,15 @@ struct ContextBase {
 
     ContextParams mParams;
 
+    /* The device's level of detail that voice parameters were last calculated
+     * with. Only used by the mixer.
+     */
+    uint mDetailLevel{0u};
+    /* The device's renderer count that voice parameters were last calculated
+     * with. Only used by the mixer.
+     */
+    uint mRendererCount{0u};
+
     using VoiceArray = al::FlexArray<Voice*>;
     std::atomic<VoiceArray*> mVoices{};
     std::atomic<size_t> mActiveVoiceCount{};
@@ -19,6 +19,7 @@
 
 #include <array>
 #include <cctype>
+#include <cstdint>
 #include <string>
 
 
@@ -35,6 +36,18 @@ inline std::array<reg_type,4> get_cpuid(unsigned int f)
     __get_cpuid(f, &ret[0], &ret[1], &ret[2], &ret[3]);
     return ret;
 }
+inline std::array<reg_type,4> get_cpuid_count(unsigned int f, unsigned int subf)
+{
+    std::array<reg_type,4> ret{};
+    __cpuid_count(f, subf, ret[0], ret[1], ret[2], ret[3]);
+    return ret;
+}
+inline uint64_t get_xcr0()
+{
+    reg_type eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (uint64_t{edx}<<32) | eax;
+}
 #define CAN_GET_CPUID
 #elif defined(HAVE_CPUID_INTRINSIC) \
     && (defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64))
@@ -45,6 +58,14 @@ inline std::array<reg_type,4> get_cpuid(unsigned int f)
     (__cpuid)(ret.data(), f);
     return ret;
 }
+inline std::array<reg_type,4> get_cpuid_count(unsigned int f, unsigned int subf)
+{
+    std::array<reg_type,4> ret{};
+    (__cpuidex)(ret.data(), static_cast<int>(f), static_cast<int>(subf));
+    return ret;
+}
+inline uint64_t get_xcr0()
+{ return _xgetbv(0); }
 #define CAN_GET_CPUID
 #endif
 
@@ -105,6 +126,20 @@ al::optional<CPUInfo> GetCPUInfo()
             ret.mCaps |= CPU_CAP_SSE3;
         if((ret.mCaps&CPU_CAP_SSE3) && (cpuregs[2]&(1<<19)))
             ret.mCaps |= CPU_CAP_SSE4_1;
+
+        /* AVX2 needs the OS to save the full YMM registers (OSXSAVE, with the
+         * XMM and YMM state bits set in XCR0), along with AVX and FMA3
+         * support, and AVX2 itself from the extended features.
+         */
+        const bool has_osxsave{(cpuregs[2]&(1<<27)) != 0};
+        const bool has_avx_fma{(cpuregs[2]&(1<<28)) && (cpuregs[2]&(1<<12))};
+        if((ret.mCaps&CPU_CAP_SSE4_1) && has_osxsave && has_avx_fma && maxfunc >= 7
+            && (get_xcr0()&0x6) == 0x6)
+        {
+            cpuregs = get_cpuid_count(7, 0);
+            if((cpuregs[1]&(1<<5)))
+                ret.mCaps |= CPU_CAP_AVX2;
+        }
     }
 
 #else
@@ -7,6 +7,7 @@
 #include "front_stablizer.h"
 #include "hrtf.h"
 #include "mastering.h"
+#include "mixer_pool.h"
 
 
 al::FlexArray<ContextBase*> DeviceBase::sEmptyContextArray{0u};
@@ -14,6 +15,7 @@ al::FlexArray<ContextBase*> DeviceBase::sEmptyContextArray{0u};
 
 DeviceBase::DeviceBase(DeviceType type) : Type{type}, mContexts{&sEmptyContextArray}
 {
+    mMixScratch.mHrtfAccumData = HrtfAccumData;
 }
 
 DeviceBase::~DeviceBase()
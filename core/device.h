@@ -3,6 +3,7 @@
 
 #include <stddef.h>
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <bitset>
@@ -18,6 +19,7 @@
 #include "bufferline.h"
 #include "devformat.h"
 #include "filters/nfc.h"
+#include "hrtf.h"
 #include "intrusive_ptr.h"
 #include "mixer/hrtfdefs.h"
 #include "opthelpers.h"
@@ -29,8 +31,6 @@ class BFormatDec;
 struct bs2b;
 struct Compressor;
 struct ContextBase;
-struct DirectHrtfState;
-struct HrtfStore;
 
 using uint = unsigned int;
 
@@ -108,6 +108,22 @@ struct MixParams {
     al::span<FloatBufferLine> Buffer;
 };
 
+/* An HRTF renderer built off the mixer thread, for the mixer to switch to. */
+struct HrtfRenderer {
+    std::unique_ptr<DirectHrtfState> mState;
+    uint mIrSize{0};
+    RenderMode mRenderMode{RenderMode::Hrtf};
+
+    /* Near-field control for the HRTF's field distance, when enabled. */
+    float mAvgSpeakerDist{0.0f};
+    std::array<uint,MaxAmbiOrder+1> mNumChannelsPerOrder{};
+
+    /* Stereo output to crossfade between the old decoder and HRTF with. */
+    alignas(16) std::array<FloatBufferLine,2> mFadeBuffer;
+
+    DEF_NEWDEL(HrtfRenderer)
+};
+
 struct RealMixParams {
     al::span<const InputRemixMap> RemixMap;
     std::array<uint,MaxChannels> ChannelIndex{};
@@ -132,9 +148,102 @@ enum {
     // ear buds, etc).
     DirectEar,
 
+    // Specifies if inaudible voices only have their playback position updated
+    // instead of being mixed.
+    VirtualVoices,
+
     DeviceFlagsCount
 };
 
+/* Levels of detail voices can be mixed with, when the mixer is over its time
+ * budget.
+ */
+enum : uint {
+    // Mixed as requested
+    DetailFull,
+    // Resampled with linear interpolation at most
+    DetailReducedResampler,
+    // Also panned to the ambisonic mix instead of using direct HRTF
+    DetailReducedSpatial,
+
+    DetailTierCount
+};
+/* The highest detail level reduces the resampler for all voices, in addition
+ * to reducing quiet voices' spatialization.
+ */
+constexpr uint MaxDetailLevel{3};
+
+/* The most voices that can be limited to direct HRTF rendering. */
+constexpr uint MaxHrtfDirectVoices{64};
+
+/* Temp storage used for mixing voices. The device has one that's used by the
+ * mixer thread, and each mixer worker thread gets its own.
+ */
+struct MixerScratch {
+    static constexpr size_t MixerLineSize{BufferLineSize + MaxResamplerPadding +
+        UhjDecoder::sFilterDelay};
+    static constexpr size_t MixerChannelsMax{16};
+    using MixerBufferLine = std::array<float,MixerLineSize>;
+    alignas(16) std::array<MixerBufferLine,MixerChannelsMax> mSampleData;
+
+    alignas(16) float ResampledData[BufferLineSize];
+    alignas(16) float FilteredData[BufferLineSize];
+    union {
+        alignas(16) float HrtfSourceData[BufferLineSize + HrtfHistoryLength];
+        alignas(16) float NfcSampleData[BufferLineSize];
+    };
+
+    /* The accumulation buffer HRTF voices mix into. */
+    float2 *mHrtfAccumData{nullptr};
+    bool mHrtfAccumUsed{false};
+
+    /* Mapping of output buffers to the partial buffers a worker thread mixes
+     * to. Empty when mixing directly to the output buffers.
+     */
+    struct BusMapping {
+        FloatBufferLine *mTarget;
+        FloatBufferLine *mPartial;
+        size_t mCount;
+        bool mInUse;
+    };
+    al::span<BusMapping> mBusMap;
+    uint mSamplesToDo{0u};
+
+    /**
+     * Gets the buffer to mix into for the given output, clearing it if this is
+     * its first use for the current update. Returns an empty span if the
+     * output can't be mixed to by this thread.
+     */
+    al::span<FloatBufferLine> getBus(const al::span<FloatBufferLine> target) noexcept
+    {
+        if(mBusMap.empty() || target.empty())
+            return target;
+        for(BusMapping &bus : mBusMap)
+        {
+            if(bus.mTarget != target.data())
+                continue;
+            if(!bus.mInUse)
+            {
+                for(size_t i{0};i < bus.mCount;++i)
+                    std::fill_n(bus.mPartial[i].begin(), mSamplesToDo, 0.0f);
+                bus.mInUse = true;
+            }
+            return {bus.mPartial, bus.mCount};
+        }
+        return {};
+    }
+
+    float2 *getHrtfAccum() noexcept
+    {
+        mHrtfAccumUsed = true;
+        return mHrtfAccumData;
+    }
+
+    DEF_NEWDEL(MixerScratch)
+};
+
+class MixerWorkerPool;
+
 struct DeviceBase {
     /* To avoid extraneous allocations, a 0-sized FlexArray<ContextBase*> is
      * defined globally as a sharable object.
@@ -183,22 +292,30 @@ struct DeviceBase {
     std::chrono::nanoseconds FixedLatency{0};
 
     /* Temp storage used for mixer processing. */
-    static constexpr size_t MixerLineSize{BufferLineSize + MaxResamplerPadding +
-        UhjDecoder::sFilterDelay};
-    static constexpr size_t MixerChannelsMax{16};
-    using MixerBufferLine = std::array<float,MixerLineSize>;
-    alignas(16) std::array<MixerBufferLine,MixerChannelsMax> mSampleData;
-
-    alignas(16) float ResampledData[BufferLineSize];
-    alignas(16) float FilteredData[BufferLineSize];
-    union {
-        alignas(16) float HrtfSourceData[BufferLineSize + HrtfHistoryLength];
-        alignas(16) float NfcSampleData[BufferLineSize];
-    };
+    MixerScratch mMixScratch;
 
     /* Persistent storage for HRTF mixing. */
     alignas(16) float2 HrtfAccumData[BufferLineSize + HrirLength];
 
+    /* Optional worker threads to spread voice mixing over. */
+    std::unique_ptr<MixerWorkerPool> mMixerWorkers;
+
+    /* Mixer time budget, as a fraction of the update period (0 disables it).
+     * While the mix goes over budget, the level of detail is raised to reduce
+     * the cost of quiet voices.
+     */
+    float mMixBudget{0.0f};
+    float mMixLoad{0.0f};
+    uint mOverBudgetCount{0u};
+    uint mUnderBudgetCount{0u};
+    std::atomic<uint> mDetailLevel{0u};
+    std::array<std::atomic<uint>,DetailTierCount> mDetailTierCounts{};
+
+    /* HRTF coefficient cache lookups made by this device's mixer, which are
+     * counted while calculating voice parameters from a const device.
+     */
+    mutable HrtfCoeffCacheStats mHrtfCacheStats;
+
     /* Mixing buffer used by the Dry mix and Real output. */
     al::vector<FloatBufferLine, 16> MixBuffer;
 
@@ -216,6 +333,22 @@ struct DeviceBase {
     al::intrusive_ptr<HrtfStore> mHrtf;
     uint mIrSize{0};
 
+    /* An HRTF renderer that finished loading in the background. It's handed
+     * to the mixer through mPendingHrtf, which switches to it at the start of
+     * its next update, and it's held until the next reset.
+     */
+    std::unique_ptr<HrtfRenderer> mHrtfRenderer;
+    std::atomic<HrtfRenderer*> mPendingHrtf{nullptr};
+    /* Counts the renderer switches made by the mixer, so contexts know to
+     * update their voices. Only used by the mixer.
+     */
+    uint mRendererCount{0u};
+
+    /* The most voices per context that get direct HRTF rendering, with the
+     * rest panned to the ambisonic mix (0 for no limit).
+     */
+    uint mHrtfDirectVoices{0};
+
     /* Ambisonic-to-UHJ encoder */
     std::unique_ptr<UhjEncoder> mUhjEncoder;
 
@@ -266,6 +399,7 @@ struct DeviceBase {
     }
 
     void ProcessHrtf(const size_t SamplesToDo);
+    void ProcessHrtfFade(const size_t SamplesToDo);
     void ProcessAmbiDec(const size_t SamplesToDo);
     void ProcessAmbiDecStablized(const size_t SamplesToDo);
     void ProcessUhj(const size_t SamplesToDo);
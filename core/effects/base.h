@@ -1,7 +1,9 @@
 #ifndef CORE_EFFECTS_BASE_H
 #define CORE_EFFECTS_BASE_H
 
+#include <limits>
 #include <stddef.h>
+#include <stdint.h>
 
 #include "albyte.h"
 #include "almalloc.h"
@@ -17,10 +19,19 @@ struct EffectSlot;
 struct MixParams;
 struct RealMixParams;
 
+using uint = unsigned int;
+
 
 /** Target gain for the reverb decay feedback reaching the decay time. */
 constexpr float ReverbDecayGain{0.001f}; /* -60 dB */
 
+/** Gain an effect's tail has to decay to, relative to its input, to be
+ * considered inaudible.
+ */
+constexpr float EffectTailGain{0.0000316228f}; /* -90 dB */
+/** Tail length for effects that may keep producing output without input. */
+constexpr uint InfiniteEffectTail{std::numeric_limits<uint>::max()};
+
 constexpr float ReverbMaxReflectionsDelay{0.3f};
 constexpr float ReverbMaxLateReverbDelay{0.1f};
 
@@ -87,6 +98,9 @@ union EffectProps {
         float ModulationDepth;
         float HFReference;
         float LFReference;
+
+        /* Run the late reverb at a reduced internal rate on high-rate devices. */
+        bool ReducedLateRate;
     } Reverb;
 
     struct {
@@ -181,6 +195,8 @@ struct EffectState : public al::intrusive_ref<EffectState> {
     struct Buffer {
         const BufferStorage *storage;
         al::span<const al::byte> samples;
+        /* Changes whenever the samples do, and is unique between buffers. */
+        uint64_t version;
     };
 
     al::span<FloatBufferLine> mOutTarget;
@@ -193,6 +209,14 @@ struct EffectState : public al::intrusive_ref<EffectState> {
         const EffectProps *props, const EffectTarget target) = 0;
     virtual void process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn,
         const al::span<FloatBufferLine> samplesOut) = 0;
+
+    /**
+     * Returns how many samples the effect keeps producing output for after
+     * its input goes silent, given its current properties. The mixer stops
+     * processing the effect once its input has been silent for longer, until
+     * something is sent to it again.
+     */
+    virtual uint tailLength() const noexcept { return InfiniteEffectTail; }
 };
 
 
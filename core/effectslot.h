@@ -78,6 +78,17 @@ struct EffectSlot {
     /* Mixing buffer used by the Wet mix. */
     WetBuffer *mWetBuffer{nullptr};
 
+    /* Set by anything that mixes into the wet buffer during an update (which
+     * may be a mixer worker thread).
+     */
+    std::atomic<bool> mInputActive{false};
+    /* Samples since the wet buffer last had input, up to the effect's tail
+     * length. Once the tail has passed, the slot sleeps, skipping the wet
+     * buffer clear and the effect processing until it gets input again.
+     */
+    uint mSilentSamples{0u};
+    bool mSleeping{false};
+
     ~EffectSlot();
 
     static EffectSlotArray *CreatePtrArray(size_t count) noexcept;
@@ -6,11 +6,89 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <type_traits>
+
+#ifdef HAVE_SSE_INTRINSICS
+#include <xmmintrin.h>
+#elif defined(HAVE_NEON)
+#include <arm_neon.h>
+#endif
 
 #include "alnumbers.h"
 #include "opthelpers.h"
 
 
+namespace {
+
+/* The number of samples per lane the bank gathers into interleaved frames at
+ * a time.
+ */
+constexpr size_t BankChunkSize{64};
+
+#if defined(HAVE_SSE_INTRINSICS) || defined(HAVE_NEON)
+/* A vector of four lanes. Each filter stage of a group of four lanes is
+ * processed as one, with the same operations (and rounding) as a single
+ * filter's processOne.
+ */
+struct float4 {
+#ifdef HAVE_SSE_INTRINSICS
+    __m128 v;
+#else
+    float32x4_t v;
+#endif
+};
+
+#ifdef HAVE_SSE_INTRINSICS
+inline float4 load4(const float *src) noexcept { return float4{_mm_load_ps(src)}; }
+inline void store4(float *dst, const float4 val) noexcept { _mm_store_ps(dst, val.v); }
+inline float4 operator+(const float4 a, const float4 b) noexcept
+{ return float4{_mm_add_ps(a.v, b.v)}; }
+inline float4 operator-(const float4 a, const float4 b) noexcept
+{ return float4{_mm_sub_ps(a.v, b.v)}; }
+inline float4 operator*(const float4 a, const float4 b) noexcept
+{ return float4{_mm_mul_ps(a.v, b.v)}; }
+#else
+inline float4 load4(const float *src) noexcept { return float4{vld1q_f32(src)}; }
+inline void store4(float *dst, const float4 val) noexcept { vst1q_f32(dst, val.v); }
+inline float4 operator+(const float4 a, const float4 b) noexcept
+{ return float4{vaddq_f32(a.v, b.v)}; }
+inline float4 operator-(const float4 a, const float4 b) noexcept
+{ return float4{vsubq_f32(a.v, b.v)}; }
+inline float4 operator*(const float4 a, const float4 b) noexcept
+{ return float4{vmulq_f32(a.v, b.v)}; }
+#endif
+
+struct LaneFilter {
+    float4 b0, b1, b2;
+    float4 a1, a2;
+    float4 z1, z2;
+};
+
+/* Applies filter I, being stage I/NumVecs of the lane group I%NumVecs, then
+ * the ones after it. Unrolling the stages and groups this way keeps the
+ * delayed components in registers, and interleaves the groups' recurrences.
+ */
+template<size_t Count, size_t NumVecs, size_t I=0>
+inline std::enable_if_t<(I < Count)> apply_filters(float4 (&x)[NumVecs],
+    LaneFilter (&filters)[Count]) noexcept
+{
+    LaneFilter &f = filters[I];
+    const float4 input{x[I%NumVecs]};
+    const float4 output{input*f.b0 + f.z1};
+    f.z1 = input*f.b1 - output*f.a1 + f.z2;
+    f.z2 = input*f.b2 - output*f.a2;
+    x[I%NumVecs] = output;
+    apply_filters<Count,NumVecs,I+1>(x, filters);
+}
+template<size_t Count, size_t NumVecs, size_t I=0>
+inline std::enable_if_t<(I == Count)> apply_filters(float4 (&)[NumVecs], LaneFilter (&)[Count])
+    noexcept
+{ }
+#endif
+
+} // namespace
+
+
 template<typename Real>
 void BiquadFilterR<Real>::setParams(BiquadType type, Real f0norm, Real gain, Real rcpQ)
 {
@@ -89,6 +167,24 @@ void BiquadFilterR<Real>::setParams(BiquadType type, Real f0norm, Real gain, Rea
     mB2 = b[2] / a[0];
 }
 
+template<typename Real>
+uint BiquadFilterR<Real>::decaySamples(Real gain) const noexcept
+{
+    /* The poles are the roots of z^2 + a1*z + a2. A complex conjugate pair
+     * has a magnitude of sqrt(a2), otherwise the larger real root dominates.
+     */
+    const Real disc{mA1*mA1 - 4.0f*mA2};
+    const Real radius{(disc < 0.0f) ? std::sqrt(mA2) : (std::abs(mA1)+std::sqrt(disc)) * 0.5f};
+    if(!(radius > 0.0f))
+        return 0;
+
+    constexpr uint maxlen{std::numeric_limits<uint>::max()};
+    if(!(radius < 1.0f))
+        return maxlen;
+    const Real len{std::ceil(std::log(gain) / std::log(radius))};
+    return (len < static_cast<Real>(maxlen)) ? static_cast<uint>(len) : maxlen;
+}
+
 template<typename Real>
 void BiquadFilterR<Real>::process(const al::span<const Real> src, Real *dst)
 {
@@ -162,3 +258,102 @@ void BiquadFilterR<Real>::dualProcess(BiquadFilterR &other, const al::span<const
 
 template class BiquadFilterR<float>;
 template class BiquadFilterR<double>;
+
+
+template<size_t Stages>
+template<size_t NumVecs>
+void BiquadBank<Stages>::processFrames(float (*frames)[MaxLanes], const size_t count) noexcept
+{
+#if defined(HAVE_SSE_INTRINSICS) || defined(HAVE_NEON)
+    constexpr size_t Count{Stages*NumVecs};
+    LaneFilter filters[Count];
+    for(size_t i{0};i < Count;++i)
+    {
+        const Stage &stage = mStages[i/NumVecs];
+        const size_t lane{i%NumVecs * 4};
+        filters[i] = LaneFilter{load4(&stage.B0[lane]), load4(&stage.B1[lane]),
+            load4(&stage.B2[lane]), load4(&stage.A1[lane]), load4(&stage.A2[lane]),
+            load4(&stage.Z1[lane]), load4(&stage.Z2[lane])};
+    }
+
+    for(size_t i{0};i < count;++i)
+    {
+        float4 x[NumVecs];
+        for(size_t v{0};v < NumVecs;++v)
+            x[v] = load4(&frames[i][v*4]);
+        apply_filters<Count,NumVecs>(x, filters);
+        for(size_t v{0};v < NumVecs;++v)
+            store4(&frames[i][v*4], x[v]);
+    }
+
+    for(size_t i{0};i < Count;++i)
+    {
+        Stage &stage = mStages[i/NumVecs];
+        const size_t lane{i%NumVecs * 4};
+        store4(&stage.Z1[lane], filters[i].z1);
+        store4(&stage.Z2[lane], filters[i].z2);
+    }
+
+#else
+
+    /* Without SIMD, each lane's stages are processed in turn. */
+    for(Stage &stage : mStages)
+    {
+        for(size_t lane{0};lane < NumVecs*4;++lane)
+        {
+            const float b0{stage.B0[lane]}, b1{stage.B1[lane]}, b2{stage.B2[lane]};
+            const float a1{stage.A1[lane]}, a2{stage.A2[lane]};
+            float z1{stage.Z1[lane]}, z2{stage.Z2[lane]};
+            for(size_t i{0};i < count;++i)
+            {
+                const float input{frames[i][lane]};
+                const float output{input*b0 + z1};
+                z1 = input*b1 - output*a1 + z2;
+                z2 = input*b2 - output*a2;
+                frames[i][lane] = output;
+            }
+            stage.Z1[lane] = z1;
+            stage.Z2[lane] = z2;
+        }
+    }
+#endif
+}
+
+template<size_t Stages>
+void BiquadBank<Stages>::process(const al::span<const float*const> src, float *const *dst,
+    const size_t count)
+{
+    const size_t numLanes{src.size()};
+    ASSUME(numLanes > 0 && numLanes <= MaxLanes);
+
+    /* Lanes are processed in groups of four, with any unused lanes of the
+     * last group filtering silence.
+     */
+    alignas(16) float frames[BankChunkSize][MaxLanes]{};
+    for(size_t base{0};base < count;base += BankChunkSize)
+    {
+        const size_t todo{std::min(count-base, BankChunkSize)};
+        for(size_t lane{0};lane < numLanes;++lane)
+        {
+            const float *input{src[lane] + base};
+            for(size_t i{0};i < todo;++i)
+                frames[i][lane] = input[i];
+        }
+
+        if(numLanes > 4)
+            processFrames<2>(frames, todo);
+        else
+            processFrames<1>(frames, todo);
+
+        for(size_t lane{0};lane < numLanes;++lane)
+        {
+            float *output{dst[lane] + base};
+            for(size_t i{0};i < todo;++i)
+                output[i] = frames[i][lane];
+        }
+    }
+}
+
+template class BiquadBank<1>;
+template class BiquadBank<2>;
+template class BiquadBank<4>;
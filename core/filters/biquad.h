@@ -2,13 +2,17 @@
 #define CORE_FILTERS_BIQUAD_H
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstddef>
+#include <limits>
 #include <utility>
 
 #include "alnumbers.h"
 #include "alspan.h"
 
+using uint = unsigned int;
+
 
 /* Filters implementation is based on the "Cookbook formulae for audio
  * EQ biquad filter coefficients" by Robert Bristow-Johnson
@@ -37,6 +41,9 @@ enum class BiquadType {
     BandPass,
 };
 
+template<size_t Stages>
+class BiquadBank;
+
 template<typename Real>
 class BiquadFilterR {
     /* Last two delayed components for direct form II. */
@@ -105,6 +112,13 @@ public:
     void setParamsFromBandwidth(BiquadType type, Real f0norm, Real gain, Real bandwidth)
     { setParams(type, f0norm, gain, rcpQFromBandwidth(f0norm, bandwidth)); }
 
+    /**
+     * Calculates how many samples it takes for the filter's response to decay
+     * by the given gain once its input goes silent, from the magnitude of its
+     * poles.
+     */
+    uint decaySamples(Real gain) const noexcept;
+
     void copyParamsFrom(const BiquadFilterR &other)
     {
         mB0 = other.mB0;
@@ -128,6 +142,9 @@ public:
         z2 = in*mB2 - out*mA2;
         return out;
     }
+
+    template<size_t Stages>
+    friend class BiquadBank;
 };
 
 template<typename Real>
@@ -141,4 +158,77 @@ struct DualBiquadR {
 using BiquadFilter = BiquadFilterR<float>;
 using DualBiquad = DualBiquadR<float>;
 
+
+/**
+ * Applies a series of Stages biquad filters to each of up to MaxLanes
+ * independent channels (lanes), processing the lanes in lockstep with each in
+ * its own SIMD lane. The coefficients and delayed components are stored as a
+ * structure of arrays, so each stage of four lanes is a single vector. A lane
+ * that needs fewer filters can have its remaining stages set to pass through.
+ */
+template<size_t Stages>
+class BiquadBank {
+public:
+    static constexpr size_t MaxLanes{8};
+
+private:
+    struct Stage {
+        alignas(16) std::array<float,MaxLanes> B0, B1, B2;
+        alignas(16) std::array<float,MaxLanes> A1, A2;
+        alignas(16) std::array<float,MaxLanes> Z1, Z2;
+    };
+    std::array<Stage,Stages> mStages{};
+
+    template<size_t NumVecs>
+    void processFrames(float (*frames)[MaxLanes], const size_t count) noexcept;
+
+public:
+    BiquadBank() noexcept
+    {
+        for(size_t lane{0};lane < MaxLanes;++lane)
+        {
+            for(size_t stage{0};stage < Stages;++stage)
+                setPassthrough(lane, stage);
+        }
+    }
+
+    void clear() noexcept
+    {
+        for(Stage &stage : mStages)
+        {
+            stage.Z1.fill(0.0f);
+            stage.Z2.fill(0.0f);
+        }
+    }
+
+    /** Copies the filter's coefficients to the given lane and stage. */
+    void setParams(const size_t lane, const size_t stage, const BiquadFilter &filter) noexcept
+    {
+        Stage &s = mStages[stage];
+        s.B0[lane] = filter.mB0; s.B1[lane] = filter.mB1; s.B2[lane] = filter.mB2;
+        s.A1[lane] = filter.mA1; s.A2[lane] = filter.mA2;
+    }
+    /** Sets the given lane and stage to pass samples through unmodified. */
+    void setPassthrough(const size_t lane, const size_t stage) noexcept
+    {
+        Stage &s = mStages[stage];
+        s.B0[lane] = 1.0f; s.B1[lane] = 0.0f; s.B2[lane] = 0.0f;
+        s.A1[lane] = 0.0f; s.A2[lane] = 0.0f;
+        s.Z1[lane] = 0.0f; s.Z2[lane] = 0.0f;
+    }
+
+    std::pair<float,float> getComponents(const size_t lane, const size_t stage) const noexcept
+    { return {mStages[stage].Z1[lane], mStages[stage].Z2[lane]}; }
+    void setComponents(const size_t lane, const size_t stage, float z1, float z2) noexcept
+    { mStages[stage].Z1[lane] = z1; mStages[stage].Z2[lane] = z2; }
+
+    /**
+     * Filters count samples for each lane, from src[lane] to dst[lane]. The
+     * number of lanes processed is the size of src, which may not be more
+     * than MaxLanes. Source pointers may alias each other (e.g. to filter the
+     * same input differently for each lane), and a lane may filter in-place.
+     */
+    void process(const al::span<const float*const> src, float *const *dst, const size_t count);
+};
+
 #endif /* CORE_FILTERS_BIQUAD_H */
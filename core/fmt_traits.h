@@ -5,6 +5,7 @@
 #include <stdint.h>
 
 #include "albyte.h"
+#include "alnumeric.h"
 #include "buffer_storage.h"
 
 
@@ -13,6 +14,13 @@ namespace al {
 extern const int16_t muLawDecompressionTable[256];
 extern const int16_t aLawDecompressionTable[256];
 
+extern const int IMAStep_size[89];
+extern const int IMA4Codeword[16];
+extern const int IMA4Index_adjust[16];
+
+extern const int MSADPCMAdaption[16];
+extern const int MSADPCMAdaptionCoeff[7][2];
+
 
 template<FmtType T>
 struct FmtTypeTraits { };
@@ -76,6 +84,173 @@ inline void LoadSampleArray(DstT *RESTRICT dst, const al::byte *src, const size_
         dst[i] = TypeTraits::template to<DstT>(ssrc[i*srcstep]);
 }
 
+
+/* The decoding state for one channel of an ADPCM stream, positioned at the
+ * sample mPos. A default state is positioned at the start of the stream.
+ */
+struct AdpcmState {
+    size_t mPos{0};
+    int mSample0{0}, mSample1{0};
+    /* The IMA4 step index, or the MSADPCM delta. */
+    int mStep{0};
+    /* The MSADPCM block predictor. */
+    uint mPredictor{0};
+};
+
+/* ADPCM samples can only be decoded in sequence from the start of a block, so
+ * these decode forward from the given state if it's in the same block as
+ * srcOffset and not past it, or else from the start of the block containing
+ * srcOffset. The samples before srcOffset are skipped, and the state is left
+ * after the last decoded sample. Only the given channel (of srcStep channels)
+ * is decoded.
+ */
+template<typename DstT>
+void LoadIMA4Array(DstT *RESTRICT dst, const al::byte *src, const size_t srcChan,
+    const size_t srcOffset, const size_t srcStep, const size_t samplesPerBlock,
+    size_t samples, AdpcmState &state) noexcept
+{
+    const size_t blockBytes{((samplesPerBlock-1)/2 + 4) * srcStep};
+    size_t pos{state.mPos};
+    if(pos > srcOffset || pos/samplesPerBlock != srcOffset/samplesPerBlock)
+        pos = srcOffset - srcOffset%samplesPerBlock;
+    int sample{state.mSample0};
+    int index{state.mStep};
+
+    auto store_sample = [&dst,&samples,&pos,srcOffset](const int smp) noexcept -> void
+    {
+        if(pos++ >= srcOffset)
+        {
+            *(dst++) = static_cast<int16_t>(smp) * DstT{1.0/32768.0};
+            --samples;
+        }
+    };
+
+    while(samples > 0)
+    {
+        const al::byte *block{src + pos/samplesPerBlock*blockBytes};
+        size_t i{pos%samplesPerBlock};
+        if(i == 0)
+        {
+            /* Each channel's header has the first sample and step index. */
+            const al::byte *header{block + srcChan*4};
+            sample = header[0] | (header[1]<<8);
+            sample = (sample^0x8000) - 32768;
+            index = header[2] | (header[3]<<8);
+            index = clampi((index^0x8000) - 32768, 0, 88);
+            store_sample(sample);
+            ++i;
+        }
+
+        /* The remaining samples are in 4-byte words of 8 nibbles, interleaved
+         * between channels.
+         */
+        const al::byte *nibbleData{block + srcStep*4};
+        for(;i < samplesPerBlock && samples > 0;i++)
+        {
+            const size_t nibbleIdx{i - 1};
+            const size_t byteIdx{((nibbleIdx>>3)*srcStep + srcChan)*4 + ((nibbleIdx&7)>>1)};
+            const uint nibble{(nibbleIdx&1) ? (nibbleData[byteIdx]>>4)
+                : (nibbleData[byteIdx]&0x0fu)};
+
+            sample += IMA4Codeword[nibble] * IMAStep_size[index] / 8;
+            sample = clampi(sample, -32768, 32767);
+
+            index += IMA4Index_adjust[nibble];
+            index = clampi(index, 0, 88);
+
+            store_sample(sample);
+        }
+    }
+
+    state.mPos = pos;
+    state.mSample0 = sample;
+    state.mStep = index;
+}
+
+template<typename DstT>
+void LoadMSADPCMArray(DstT *RESTRICT dst, const al::byte *src, const size_t srcChan,
+    const size_t srcOffset, const size_t srcStep, const size_t samplesPerBlock,
+    size_t samples, AdpcmState &state) noexcept
+{
+    const size_t blockBytes{((samplesPerBlock-2)/2 + 7) * srcStep};
+    size_t pos{state.mPos};
+    if(pos > srcOffset || pos/samplesPerBlock != srcOffset/samplesPerBlock)
+        pos = srcOffset - srcOffset%samplesPerBlock;
+    uint blockpred{state.mPredictor};
+    int delta{state.mStep};
+    int sample0{state.mSample0};
+    int sample1{state.mSample1};
+
+    auto store_sample = [&dst,&samples,&pos,srcOffset](const int smp) noexcept -> void
+    {
+        if(pos++ >= srcOffset)
+        {
+            *(dst++) = static_cast<int16_t>(smp) * DstT{1.0/32768.0};
+            --samples;
+        }
+    };
+
+    while(samples > 0)
+    {
+        const al::byte *block{src + pos/samplesPerBlock*blockBytes};
+        size_t i{pos%samplesPerBlock};
+        if(i == 0)
+        {
+            /* The header has each channel's predictor, followed by each
+             * channel's initial delta, then each channel's first and second
+             * history samples.
+             */
+            blockpred = minu(block[srcChan], 6);
+            const al::byte *header{block + srcStep + srcChan*2};
+            delta = header[0] | (header[1]<<8);
+            delta = (delta^0x8000) - 32768;
+            header += srcStep*2;
+            sample0 = static_cast<int16_t>(header[0] | (header[1]<<8));
+            header += srcStep*2;
+            sample1 = static_cast<int16_t>(header[0] | (header[1]<<8));
+
+            /* Second sample is played first. */
+            store_sample(sample1);
+            ++i;
+        }
+        if(i == 1 && samples > 0)
+        {
+            store_sample(sample0);
+            ++i;
+        }
+
+        /* The remaining samples are nibbles interleaved between channels,
+         * with the first in the upper bits.
+         */
+        const al::byte *nibbleData{block + srcStep*7};
+        for(;i < samplesPerBlock && samples > 0;i++)
+        {
+            const size_t nibbleIdx{(i-2)*srcStep + srcChan};
+            const uint nibble{(nibbleIdx&1) ? (nibbleData[nibbleIdx>>1]&0x0fu)
+                : (nibbleData[nibbleIdx>>1]>>4)};
+
+            int pred{(sample0*MSADPCMAdaptionCoeff[blockpred][0] +
+                sample1*MSADPCMAdaptionCoeff[blockpred][1]) / 256};
+            pred += ((nibble^0x08) - 0x08) * delta;
+            pred  = clampi(pred, -32768, 32767);
+
+            sample1 = sample0;
+            sample0 = pred;
+
+            delta = (MSADPCMAdaption[nibble] * delta) / 256;
+            delta = maxi(16, delta);
+
+            store_sample(pred);
+        }
+    }
+
+    state.mPos = pos;
+    state.mSample0 = sample0;
+    state.mSample1 = sample1;
+    state.mStep = delta;
+    state.mPredictor = blockpred;
+}
+
 } // namespace al
 
 #endif /* CORE_FMT_TRAITS_H */
@@ -179,10 +179,196 @@ void SetRTPriority(void)
     }
 }
 
+std::string GetCachePath(const char *subdir)
+{
+    WCHAR buffer[MAX_PATH];
+    if(SHGetSpecialFolderPathW(nullptr, buffer, CSIDL_LOCAL_APPDATA, FALSE) == FALSE)
+        return {};
+
+    std::string path{wstr_to_utf8(buffer)};
+    if(path.back() != '\\' && path.back() != '/')
+        path += '\\';
+    path += subdir;
+    std::replace(path.begin(), path.end(), '/', '\\');
+    return path;
+}
+
+bool MakeDirectories(const std::string &path)
+{
+    /* Create each directory along the path. Only the last one needs to
+     * succeed, since the drive or share root can't be created.
+     */
+    size_t pos{path.find_first_of("/\\", path.find_first_not_of("/\\"))};
+    while(true)
+    {
+        const std::wstring dir{utf8_to_wstr(path.substr(0, pos).c_str())};
+        if(!CreateDirectoryW(dir.c_str(), nullptr) && GetLastError() != ERROR_ALREADY_EXISTS
+            && pos == std::string::npos)
+        {
+            ERR("Failed to create %s: error %lu\n", path.c_str(), GetLastError());
+            return false;
+        }
+        if(pos == std::string::npos)
+            return true;
+        pos = path.find_first_of("/\\", pos+1);
+    }
+}
+
+al::optional<FileStamp> GetFileStamp(const std::string &fname)
+{
+    WIN32_FILE_ATTRIBUTE_DATA attrs{};
+    if(!GetFileAttributesExW(utf8_to_wstr(fname.c_str()).c_str(), GetFileExInfoStandard, &attrs))
+        return al::nullopt;
+
+    FileStamp stamp{};
+    stamp.mSize = (uint64_t{attrs.nFileSizeHigh}<<32) | attrs.nFileSizeLow;
+    stamp.mModTime = static_cast<int64_t>((uint64_t{attrs.ftLastWriteTime.dwHighDateTime}<<32)
+        | attrs.ftLastWriteTime.dwLowDateTime);
+    return al::make_optional(stamp);
+}
+
+FileMapping MapFileToMem(const std::string &fname)
+{
+    HANDLE file{CreateFileW(utf8_to_wstr(fname.c_str()).c_str(), GENERIC_READ, FILE_SHARE_READ,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr)};
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        const DWORD err{GetLastError()};
+        if(err != ERROR_FILE_NOT_FOUND && err != ERROR_PATH_NOT_FOUND)
+            ERR("Failed to open %s: error %lu\n", fname.c_str(), err);
+        return {};
+    }
+
+    FileMapping ret{};
+    LARGE_INTEGER fsize{};
+    if(!GetFileSizeEx(file, &fsize) || fsize.QuadPart <= 0)
+    {
+        CloseHandle(file);
+        return ret;
+    }
+
+    /* The view keeps the mapping alive, so the handles can be closed once
+     * it's made.
+     */
+    HANDLE fmap{CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr)};
+    if(fmap)
+    {
+        if(void *ptr{MapViewOfFile(fmap, FILE_MAP_READ, 0, 0, 0)})
+        {
+            ret.mData = static_cast<const al::byte*>(ptr);
+            ret.mSize = static_cast<size_t>(fsize.QuadPart);
+        }
+        else
+            ERR("Failed to map %s: error %lu\n", fname.c_str(), GetLastError());
+        CloseHandle(fmap);
+    }
+    else
+        ERR("Failed to create mapping for %s: error %lu\n", fname.c_str(), GetLastError());
+    CloseHandle(file);
+
+    return ret;
+}
+
+void UnmapFileMem(const FileMapping &mapping)
+{
+    if(mapping.mData)
+        UnmapViewOfFile(mapping.mData);
+}
+
+bool StoreFileAtomic(const std::string &fname, const al::span<const al::byte> data)
+{
+    const std::wstring wname{utf8_to_wstr(fname.c_str())};
+    const std::wstring tmpname{wname + L"." + std::to_wstring(GetCurrentProcessId()) + L".tmp"};
+
+    HANDLE file{CreateFileW(tmpname.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL, nullptr)};
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        ERR("Failed to create %s: error %lu\n", wstr_to_utf8(tmpname.c_str()).c_str(),
+            GetLastError());
+        return false;
+    }
+
+    /* Make sure the data is on disk before it replaces the old file, so a
+     * crash can't leave a renamed but incomplete file.
+     */
+    DWORD written{0};
+    bool ok{WriteFile(file, data.data(), static_cast<DWORD>(data.size()), &written, nullptr)
+        && written == data.size() && FlushFileBuffers(file)};
+    DWORD err{ok ? 0 : GetLastError()};
+    CloseHandle(file);
+
+    if(ok && !MoveFileExW(tmpname.c_str(), wname.c_str(), MOVEFILE_REPLACE_EXISTING))
+    {
+        ok = false;
+        err = GetLastError();
+    }
+    if(!ok)
+    {
+        ERR("Failed to write %s: error %lu\n", fname.c_str(), err);
+        DeleteFileW(tmpname.c_str());
+        return false;
+    }
+    return true;
+}
+
+void TouchFile(const std::string &fname)
+{
+    HANDLE file{CreateFileW(utf8_to_wstr(fname.c_str()).c_str(), FILE_WRITE_ATTRIBUTES,
+        FILE_SHARE_READ|FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr)};
+    if(file == INVALID_HANDLE_VALUE)
+        return;
+
+    FILETIME now{};
+    GetSystemTimeAsFileTime(&now);
+    SetFileTime(file, nullptr, nullptr, &now);
+    CloseHandle(file);
+}
+
+void TrimDirectory(const std::string &path, const char *ext, const uint64_t maxSize)
+{
+    struct FileInfo { std::wstring name; uint64_t size; uint64_t modtime; };
+    al::vector<FileInfo> files;
+    uint64_t total{0};
+
+    std::wstring dir{utf8_to_wstr(path.c_str())};
+    if(!dir.empty() && dir.back() != '\\' && dir.back() != '/')
+        dir += L'\\';
+    WIN32_FIND_DATAW fdata;
+    HANDLE hdl{FindFirstFileW((dir + L"*" + utf8_to_wstr(ext)).c_str(), &fdata)};
+    if(hdl == INVALID_HANDLE_VALUE) return;
+    do {
+        if((fdata.dwFileAttributes&FILE_ATTRIBUTE_DIRECTORY))
+            continue;
+        const uint64_t size{(uint64_t{fdata.nFileSizeHigh}<<32) | fdata.nFileSizeLow};
+        files.emplace_back(FileInfo{dir + fdata.cFileName, size,
+            (uint64_t{fdata.ftLastWriteTime.dwHighDateTime}<<32)
+                | fdata.ftLastWriteTime.dwLowDateTime});
+        total += size;
+    } while(FindNextFileW(hdl, &fdata));
+    FindClose(hdl);
+
+    std::sort(files.begin(), files.end(),
+        [](const FileInfo &lhs, const FileInfo &rhs) noexcept -> bool
+        { return lhs.modtime < rhs.modtime; });
+    for(auto iter = files.cbegin();total > maxSize && iter != files.cend();++iter)
+    {
+        if(DeleteFileW(iter->name.c_str()))
+        {
+            TRACE("Removed %s\n", wstr_to_utf8(iter->name.c_str()).c_str());
+            total -= iter->size;
+        }
+    }
+}
+
 #else
 
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
+#include <fcntl.h>
 #include <unistd.h>
+#include <utime.h>
 #include <dirent.h>
 #ifdef __FreeBSD__
 #include <sys/sysctl.h>
@@ -425,6 +611,203 @@ al::vector<std::string> SearchDataFiles(const char *ext, const char *subdir)
     return results;
 }
 
+std::string GetCachePath(const char *subdir)
+{
+    std::string path;
+    if(auto cachepath = al::getenv("XDG_CACHE_HOME"))
+        path = std::move(*cachepath);
+    else if(auto homepath = al::getenv("HOME"))
+    {
+        path = std::move(*homepath);
+        if(!path.empty() && path.back() == '/')
+            path.pop_back();
+        path += "/.cache";
+    }
+    if(path.empty())
+        return path;
+
+    if(path.back() != '/')
+        path += '/';
+    path += subdir;
+    return path;
+}
+
+bool MakeDirectories(const std::string &path)
+{
+    size_t pos{path.find('/', 1)};
+    while(true)
+    {
+        const std::string dir{path.substr(0, pos)};
+        if(mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST)
+        {
+            ERR("Failed to create %s: %s (%d)\n", dir.c_str(), std::strerror(errno), errno);
+            return false;
+        }
+        if(pos == std::string::npos)
+            return true;
+        pos = path.find('/', pos+1);
+    }
+}
+
+al::optional<FileStamp> GetFileStamp(const std::string &fname)
+{
+    struct stat sbuf{};
+    if(stat(fname.c_str(), &sbuf) != 0)
+        return al::nullopt;
+
+    FileStamp stamp{};
+    stamp.mSize = static_cast<uint64_t>(sbuf.st_size);
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    /* Use the full resolution, so a file replaced within the same second is
+     * still seen as changed.
+     */
+    stamp.mModTime = static_cast<int64_t>(sbuf.st_mtim.tv_sec)*1000000000
+        + sbuf.st_mtim.tv_nsec;
+#else
+    stamp.mModTime = static_cast<int64_t>(sbuf.st_mtime);
+#endif
+    return al::make_optional(stamp);
+}
+
+FileMapping MapFileToMem(const std::string &fname)
+{
+    const int fd{open(fname.c_str(), O_RDONLY, 0)};
+    if(fd == -1)
+    {
+        if(errno != ENOENT)
+            ERR("Failed to open %s: %s (%d)\n", fname.c_str(), std::strerror(errno), errno);
+        return {};
+    }
+
+    FileMapping ret{};
+    struct stat sbuf{};
+    if(fstat(fd, &sbuf) == -1 || sbuf.st_size <= 0)
+    {
+        close(fd);
+        return ret;
+    }
+
+    /* The mapping holds its own reference to the file, so the descriptor can
+     * be closed once it's made.
+     */
+    const auto fsize = static_cast<size_t>(sbuf.st_size);
+    void *ptr{mmap(nullptr, fsize, PROT_READ, MAP_SHARED, fd, 0)};
+    if(ptr == MAP_FAILED)
+        ERR("Failed to map %s: %s (%d)\n", fname.c_str(), std::strerror(errno), errno);
+    else
+    {
+        ret.mData = static_cast<const al::byte*>(ptr);
+        ret.mSize = fsize;
+    }
+    close(fd);
+
+    return ret;
+}
+
+void UnmapFileMem(const FileMapping &mapping)
+{
+    if(mapping.mData)
+        munmap(const_cast<al::byte*>(mapping.mData), mapping.mSize);
+}
+
+bool StoreFileAtomic(const std::string &fname, const al::span<const al::byte> data)
+{
+    const std::string tmpname{fname + "." + std::to_string(getpid()) + ".tmp"};
+
+    const int fd{open(tmpname.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644)};
+    if(fd == -1)
+    {
+        ERR("Failed to create %s: %s (%d)\n", tmpname.c_str(), std::strerror(errno), errno);
+        return false;
+    }
+
+    /* Keep the first error, since close() and unlink() may change errno.
+     * The data is synced before the rename, so a crash can't leave a renamed
+     * but incomplete file.
+     */
+    int err{0};
+    const al::byte *ptr{data.data()};
+    size_t todo{data.size()};
+    while(todo > 0)
+    {
+        const ssize_t res{write(fd, ptr, todo)};
+        if(res < 0)
+        {
+            if(errno == EINTR) continue;
+            err = errno;
+            break;
+        }
+        ptr += res;
+        todo -= static_cast<size_t>(res);
+    }
+    if(!err && fsync(fd) != 0)
+        err = errno;
+    if(close(fd) != 0 && !err)
+        err = errno;
+    if(!err && rename(tmpname.c_str(), fname.c_str()) != 0)
+        err = errno;
+
+    if(err)
+    {
+        ERR("Failed to write %s: %s (%d)\n", fname.c_str(), std::strerror(err), err);
+        unlink(tmpname.c_str());
+        return false;
+    }
+    return true;
+}
+
+void TouchFile(const std::string &fname)
+{ utime(fname.c_str(), nullptr); }
+
+void TrimDirectory(const std::string &path, const char *ext, const uint64_t maxSize)
+{
+    struct FileInfo { std::string name; uint64_t size; int64_t modtime; };
+    al::vector<FileInfo> files;
+    uint64_t total{0};
+
+    DIR *dir{opendir(path.c_str())};
+    if(!dir) return;
+
+    const size_t extlen{strlen(ext)};
+    while(struct dirent *dirent{readdir(dir)})
+    {
+        const size_t len{strlen(dirent->d_name)};
+        if(len <= extlen || al::strcasecmp(dirent->d_name+len-extlen, ext) != 0)
+            continue;
+
+        std::string fname{path};
+        if(fname.back() != '/')
+            fname.push_back('/');
+        fname += dirent->d_name;
+
+        struct stat sbuf{};
+        if(stat(fname.c_str(), &sbuf) != 0 || !S_ISREG(sbuf.st_mode))
+            continue;
+        const auto size = static_cast<uint64_t>(sbuf.st_size);
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+        const int64_t modtime{static_cast<int64_t>(sbuf.st_mtim.tv_sec)*1000000000
+            + sbuf.st_mtim.tv_nsec};
+#else
+        const int64_t modtime{static_cast<int64_t>(sbuf.st_mtime)};
+#endif
+        files.emplace_back(FileInfo{std::move(fname), size, modtime});
+        total += size;
+    }
+    closedir(dir);
+
+    std::sort(files.begin(), files.end(),
+        [](const FileInfo &lhs, const FileInfo &rhs) noexcept -> bool
+        { return lhs.modtime < rhs.modtime; });
+    for(auto iter = files.cbegin();total > maxSize && iter != files.cend();++iter)
+    {
+        if(unlink(iter->name.c_str()) == 0)
+        {
+            TRACE("Removed %s\n", iter->name.c_str());
+            total -= iter->size;
+        }
+    }
+}
+
 namespace {
 
 bool SetRTPriorityPthread(int prio)
@@ -1,8 +1,13 @@
 #ifndef CORE_HELPERS_H
 #define CORE_HELPERS_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include <string>
 
+#include "albyte.h"
+#include "aloptional.h"
+#include "alspan.h"
 #include "vector.h"
 
 
@@ -15,4 +20,43 @@ void SetRTPriority(void);
 
 al::vector<std::string> SearchDataFiles(const char *match, const char *subdir);
 
+/* Returns the user's cache directory with subdir appended, or an empty string
+ * if there is none. The directories aren't created.
+ */
+std::string GetCachePath(const char *subdir);
+/* Creates the directory, and any missing parent directories. */
+bool MakeDirectories(const std::string &path);
+
+/* The size and last modification time of a file, used to check if data
+ * derived from it is still current.
+ */
+struct FileStamp {
+    uint64_t mSize;
+    int64_t mModTime;
+};
+al::optional<FileStamp> GetFileStamp(const std::string &fname);
+
+/* A read-only view of a file's contents. The pages are shared with any other
+ * process mapping the same file.
+ */
+struct FileMapping {
+    const al::byte *mData{nullptr};
+    size_t mSize{0u};
+};
+FileMapping MapFileToMem(const std::string &fname);
+void UnmapFileMem(const FileMapping &mapping);
+
+/* Writes the data to a temporary file next to the destination, then renames
+ * it into place so other processes never see a partially written file.
+ */
+bool StoreFileAtomic(const std::string &fname, const al::span<const al::byte> data);
+
+/* Sets a file's modification time to now, marking it as recently used. */
+void TouchFile(const std::string &fname);
+
+/* Removes the least recently modified files with the given extension from the
+ * directory, until the rest total no more than maxSize bytes.
+ */
+void TrimDirectory(const std::string &path, const char *ext, const uint64_t maxSize);
+
 #endif /* CORE_HELPERS_H */
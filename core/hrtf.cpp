@@ -5,6 +5,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cctype>
 #include <cmath>
@@ -44,10 +45,38 @@ struct HrtfEntry {
     std::string mFilename;
 };
 
+/* Owns the mapping of a precomputed data set file, which a loaded HrtfStore
+ * references the data of.
+ */
+class HrtfMapping {
+    FileMapping mMapping;
+
+public:
+    HrtfMapping() = default;
+    explicit HrtfMapping(const FileMapping &mapping) noexcept : mMapping{mapping} { }
+    HrtfMapping(HrtfMapping&& rhs) noexcept : mMapping{rhs.mMapping} { rhs.mMapping = {}; }
+    ~HrtfMapping();
+
+    HrtfMapping& operator=(HrtfMapping&& rhs) noexcept
+    { std::swap(mMapping, rhs.mMapping); return *this; }
+
+    const FileMapping &get() const noexcept { return mMapping; }
+};
+
+HrtfMapping::~HrtfMapping()
+{ UnmapFileMem(mMapping); }
+
 struct LoadedHrtf {
     std::string mFilename;
     std::unique_ptr<HrtfStore> mEntry;
+    HrtfMapping mMapping;
+
+    LoadedHrtf(LoadedHrtf&&) = default;
+    ~LoadedHrtf();
+
+    LoadedHrtf& operator=(LoadedHrtf&&) = default;
 };
+LoadedHrtf::~LoadedHrtf() = default;
 
 /* Data set limits must be the same as or more flexible than those defined in
  * the makemhr utility.
@@ -77,6 +106,42 @@ constexpr char magicMarker01[8]{'M','i','n','P','H','R','0','1'};
 constexpr char magicMarker02[8]{'M','i','n','P','H','R','0','2'};
 constexpr char magicMarker03[8]{'M','i','n','P','H','R','0','3'};
 
+/* Precomputed data sets are stored already resampled to the device rate, in
+ * native byte order, and laid out so the HrtfStore can reference the mapped
+ * file directly.
+ */
+constexpr char magicMarkerMap[8]{'A','l','H','r','M','a','p','1'};
+constexpr uint32_t MapByteOrder{0x01020304};
+
+struct HrtfMapHeader {
+    char mMagic[8];
+    uint32_t mByteOrder;
+    uint32_t mHrirLength;
+    uint32_t mSampleRate;
+    uint32_t mIrSize;
+    uint32_t mFdCount;
+    uint32_t mEvCount;
+    uint32_t mIrCount;
+    uint32_t mFieldOffset;
+    uint32_t mElevOffset;
+    uint32_t mCoeffsOffset;
+    uint32_t mDelaysOffset;
+    uint32_t mTotalSize;
+    /* The size, modification time, and content hash of the source data set. */
+    uint64_t mSourceSize;
+    int64_t mSourceTime;
+    uint64_t mSourceHash;
+};
+
+/* Identifies the data set a precomputed copy was made from. When the hash is
+ * known, it's checked instead of the modification time so copied or touched
+ * files still match.
+ */
+struct HrtfSourceId {
+    FileStamp mStamp;
+    uint64_t mHash; /* 0 if not calculated. */
+};
+
 /* First value for pass-through coefficients (remaining are 0), used for omni-
  * directional sounds. */
 constexpr auto PassthruCoeff = static_cast<float>(1.0/al::numbers::sqrt2);
@@ -183,13 +248,10 @@ IdxBlend CalcAzIndex(uint azcount, float az)
     return IdxBlend{idx%azcount, az-static_cast<float>(idx)};
 }
 
-} // namespace
-
-
 /* Calculates static HRIR coefficients and delays for the given polar elevation
  * and azimuth in radians. The coefficients are normalized.
  */
-void GetHrtfCoeffs(const HrtfStore *Hrtf, float elevation, float azimuth, float distance,
+void CalcHrtfCoeffs(const HrtfStore *Hrtf, float elevation, float azimuth, float distance,
     float spread, HrirArray &coeffs, const al::span<uint,2> delays)
 {
     const float dirfact{1.0f - (al::numbers::inv_pi_v<float>/2.0f * spread)};
@@ -255,6 +317,139 @@ void GetHrtfCoeffs(const HrtfStore *Hrtf, float elevation, float azimuth, float
 }
 
 
+/* Quantization steps for the coefficient cache. These give about 0.18 degrees
+ * of elevation and azimuth, and 1.4 degrees of spread.
+ */
+constexpr uint CacheEvSteps{1024};
+constexpr uint CacheAzSteps{2048};
+constexpr uint CacheSpreadSteps{256};
+
+} // namespace
+
+
+/* A direct-mapped cache of blended HRIR coefficients and delays, keyed by the
+ * field and the quantized elevation, azimuth, and spread. The coefficients are
+ * calculated for the quantized values, so the result doesn't depend on which
+ * source filled an entry. Each entry is guarded by a sequence count, letting
+ * multiple mixers share the cache without locking; a lookup that races with a
+ * store is just treated as a miss. The entry data is accessed with relaxed
+ * atomics, ordered by fences around the sequence count.
+ */
+struct HrtfCoeffCache {
+    struct Entry {
+        std::array<std::atomic<float>,HrirLength*2> mCoeffs;
+        std::array<std::atomic<uint>,2> mDelays;
+        std::atomic<uint64_t> mKey{0};
+        std::atomic<uint> mSeq{0u};
+    };
+
+    al::FlexArray<Entry,16> mEntries;
+
+    HrtfCoeffCache(size_t count) : mEntries{count} { }
+
+    bool get(const HrtfStore *Hrtf, float elevation, float azimuth, float distance,
+        float spread, HrirArray &coeffs, const al::span<uint,2> delays);
+
+    DEF_FAM_NEWDEL(HrtfCoeffCache, mEntries)
+};
+
+/* Returns true if the result was found in the cache. */
+bool HrtfCoeffCache::get(const HrtfStore *Hrtf, float elevation, float azimuth, float distance,
+    float spread, HrirArray &coeffs, const al::span<uint,2> delays)
+{
+    uint fdidx{0};
+    while(fdidx < Hrtf->fdCount-1 && distance < Hrtf->field[fdidx].distance)
+        ++fdidx;
+
+    constexpr float Pi{al::numbers::pi_v<float>};
+    const uint qev{minu(float2uint((clampf(elevation, -Pi*0.5f, Pi*0.5f) + Pi*0.5f)
+        * ((CacheEvSteps-1) / Pi) + 0.5f), CacheEvSteps-1)};
+    const uint qaz{float2uint((clampf(azimuth, -Pi, Pi) + Pi) * (CacheAzSteps / (Pi*2.0f))
+        + 0.5f) % CacheAzSteps};
+    const uint qspread{minu(float2uint(clampf(spread, 0.0f, Pi*2.0f)
+        * ((CacheSpreadSteps-1) / (Pi*2.0f)) + 0.5f), CacheSpreadSteps-1)};
+
+    /* Keys are offset by 1 so 0 indicates an unused entry. */
+    const uint64_t key{((uint64_t{fdidx}<<32) | (uint64_t{qev}<<20) | (uint64_t{qaz}<<8)
+        | qspread) + 1};
+    const uint64_t hash{key * 0x9e3779b97f4a7c15_u64};
+    Entry &entry = mEntries[static_cast<size_t>(hash>>32) & (mEntries.size()-1)];
+
+    uint seq{entry.mSeq.load(std::memory_order_acquire)};
+    if(!(seq&1) && entry.mKey.load(std::memory_order_relaxed) == key)
+    {
+        for(size_t i{0};i < coeffs.size();++i)
+        {
+            coeffs[i][0] = entry.mCoeffs[i*2 + 0].load(std::memory_order_relaxed);
+            coeffs[i][1] = entry.mCoeffs[i*2 + 1].load(std::memory_order_relaxed);
+        }
+        delays[0] = entry.mDelays[0].load(std::memory_order_relaxed);
+        delays[1] = entry.mDelays[1].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if LIKELY(entry.mSeq.load(std::memory_order_relaxed) == seq)
+            return true;
+    }
+
+    /* Calculate for the center of the quantized field and direction. */
+    const float qdist{Hrtf->field[fdidx].distance};
+    CalcHrtfCoeffs(Hrtf, static_cast<float>(qev)*(Pi/(CacheEvSteps-1)) - Pi*0.5f,
+        static_cast<float>(qaz)*(Pi*2.0f/CacheAzSteps) - Pi,
+        (fdidx < Hrtf->fdCount-1) ? qdist : 0.0f,
+        static_cast<float>(qspread)*(Pi*2.0f/(CacheSpreadSteps-1)), coeffs, delays);
+
+    /* Store the result, unless another thread is already storing to it. */
+    seq = entry.mSeq.load(std::memory_order_relaxed);
+    if((seq&1) || !entry.mSeq.compare_exchange_strong(seq, seq+1, std::memory_order_acquire,
+        std::memory_order_relaxed))
+        return false;
+    std::atomic_thread_fence(std::memory_order_release);
+    entry.mKey.store(key, std::memory_order_relaxed);
+    for(size_t i{0};i < coeffs.size();++i)
+    {
+        entry.mCoeffs[i*2 + 0].store(coeffs[i][0], std::memory_order_relaxed);
+        entry.mCoeffs[i*2 + 1].store(coeffs[i][1], std::memory_order_relaxed);
+    }
+    entry.mDelays[0].store(delays[0], std::memory_order_relaxed);
+    entry.mDelays[1].store(delays[1], std::memory_order_relaxed);
+    entry.mSeq.store(seq+2, std::memory_order_release);
+    return false;
+}
+
+
+void GetHrtfCoeffs(const HrtfStore *Hrtf, float elevation, float azimuth, float distance,
+    float spread, HrirArray &coeffs, const al::span<uint,2> delays, HrtfCoeffCacheStats &stats)
+{
+    if(HrtfCoeffCache *cache{Hrtf->mCoeffCache.load(std::memory_order_acquire)})
+    {
+        /* Only the calling thread updates its counts, so they don't need to
+         * be atomically incremented.
+         */
+        std::atomic<uint> &count = cache->get(Hrtf, elevation, azimuth, distance, spread,
+            coeffs, delays) ? stats.mHits : stats.mMisses;
+        count.store(count.load(std::memory_order_relaxed)+1u, std::memory_order_relaxed);
+        return;
+    }
+    CalcHrtfCoeffs(Hrtf, elevation, azimuth, distance, spread, coeffs, delays);
+}
+
+void EnableHrtfCoeffCache(HrtfStore *Hrtf, uint numEntries)
+{
+    if(numEntries == 0 || Hrtf->mCoeffCache.load(std::memory_order_acquire))
+        return;
+
+    /* Limit it to 16K entries (about 17MB). */
+    const size_t count{NextPowerOf2(minu(numEntries, 16384u))};
+    std::unique_ptr<HrtfCoeffCache> cache{new(FamCount(count)) HrtfCoeffCache{count}};
+    HrtfCoeffCache *expected{nullptr};
+    if(Hrtf->mCoeffCache.compare_exchange_strong(expected, cache.get(),
+        std::memory_order_acq_rel))
+    {
+        TRACE("Enabled HRTF coefficient cache with %zu entries\n", count);
+        cache.release();
+    }
+}
+
+
 std::unique_ptr<DirectHrtfState> DirectHrtfState::Create(size_t num_chans)
 { return std::unique_ptr<DirectHrtfState>{new(FamCount(num_chans)) DirectHrtfState{num_chans}}; }
 
@@ -1111,6 +1306,248 @@ std::unique_ptr<HrtfStore> LoadHrtf03(std::istream &data, const char *filename)
 }
 
 
+/* 64-bit FNV-1a hash of the bytes, continuing from the given hash. */
+uint64_t HashBytes(const void *data, const size_t size,
+    uint64_t hash=0xcbf29ce484222325) noexcept
+{
+    auto bytes = static_cast<const unsigned char*>(data);
+    for(size_t i{0};i < size;++i)
+    {
+        hash ^= bytes[i];
+        hash *= 0x00000100000001b3;
+    }
+    return hash;
+}
+
+/* Identifies a data set for the cache. Files are identified by their path,
+ * size and modification time, so they don't need to be read to be found in
+ * the cache. Built-in resources are already in memory, so they're identified
+ * by their contents.
+ */
+uint64_t HashHrtfSource(const std::string &fname, const FileStamp &stamp,
+    const al::span<const char> res) noexcept
+{
+    if(!res.empty())
+        return HashBytes(res.data(), res.size());
+    uint64_t hash{HashBytes(fname.data(), fname.size())};
+    hash = HashBytes(&stamp.mSize, sizeof(stamp.mSize), hash);
+    return HashBytes(&stamp.mModTime, sizeof(stamp.mModTime), hash);
+}
+
+/* Returns the sample rate from a data set's header, or 0 if it isn't a
+ * recognized data set. Every format has the rate right after the marker.
+ */
+uint GetHrtfSourceRate(const std::string &fname, const al::span<const char> res)
+{
+    char header[sizeof(magicMarker03)+4];
+    if(!res.empty())
+    {
+        if(res.size() < sizeof(header)) return 0;
+        std::copy_n(res.begin(), sizeof(header), std::begin(header));
+    }
+    else
+    {
+        al::ifstream file{fname.c_str(), std::ios::binary};
+        if(!file.is_open() || !file.read(header, sizeof(header)))
+            return 0;
+    }
+
+    auto is_marker = [&header](const char (&marker)[8]) noexcept -> bool
+    { return memcmp(header, marker, sizeof(marker)) == 0; };
+    if(!is_marker(magicMarker00) && !is_marker(magicMarker01) && !is_marker(magicMarker02)
+        && !is_marker(magicMarker03))
+        return 0;
+
+    const auto *rate = reinterpret_cast<const unsigned char*>(header + sizeof(magicMarker03));
+    return uint{rate[0]} | (uint{rate[1]}<<8) | (uint{rate[2]}<<16) | (uint{rate[3]}<<24);
+}
+
+std::string GetHrtfMapName(const std::string &mappath, const std::string &name, const uint rate)
+{
+    std::string fname{mappath};
+    if(!fname.empty() && fname.back() != '/' && fname.back() != '\\')
+        fname += '/';
+    /* Only keep characters that are safe in a filename. */
+    std::transform(name.cbegin(), name.cend(), std::back_inserter(fname),
+        [](const char c) noexcept -> char
+        { return (std::isalnum(static_cast<unsigned char>(c)) || c == '-') ? c : '_'; });
+    fname += '-';
+    fname += std::to_string(rate);
+    fname += ".mhrmap";
+    return fname;
+}
+
+/* Cached data sets are named by their source's hash, the rate they were
+ * converted to, and the maximum IR length the layout was made for.
+ */
+std::string GetHrtfCacheName(const std::string &cachepath, const uint64_t hash, const uint rate)
+{
+    char name[64];
+    std::snprintf(name, sizeof(name), "%016llx-%u-%u.mhrmap",
+        static_cast<unsigned long long>(hash), rate, HrirLength);
+
+    std::string fname{cachepath};
+    if(!fname.empty() && fname.back() != '/' && fname.back() != '\\')
+        fname += '/';
+    fname += name;
+    return fname;
+}
+
+al::vector<al::byte> MakeHrtfMapData(const HrtfStore *hrtf, const HrtfSourceId &srcid)
+{
+    const size_t evCount{std::accumulate(hrtf->field, hrtf->field+hrtf->fdCount, size_t{0},
+        [](const size_t curval, const HrtfStore::Field &field) noexcept -> size_t
+        { return curval + field.evCount; })};
+    const size_t irCount{size_t{hrtf->elev[evCount-1].irOffset} + hrtf->elev[evCount-1].azCount};
+
+    HrtfMapHeader header{};
+    std::copy(std::begin(magicMarkerMap), std::end(magicMarkerMap), header.mMagic);
+    header.mByteOrder = MapByteOrder;
+    header.mHrirLength = HrirLength;
+    header.mSampleRate = hrtf->sampleRate;
+    header.mIrSize = hrtf->irSize;
+    header.mFdCount = hrtf->fdCount;
+    header.mEvCount = static_cast<uint32_t>(evCount);
+    header.mIrCount = static_cast<uint32_t>(irCount);
+    header.mSourceSize = srcid.mStamp.mSize;
+    header.mSourceTime = srcid.mStamp.mModTime;
+    header.mSourceHash = srcid.mHash;
+
+    size_t total{sizeof(HrtfMapHeader)};
+    total = RoundUp(total, alignof(HrtfStore::Field));
+    header.mFieldOffset = static_cast<uint32_t>(total);
+    total += sizeof(hrtf->field[0])*hrtf->fdCount;
+    total = RoundUp(total, alignof(HrtfStore::Elevation));
+    header.mElevOffset = static_cast<uint32_t>(total);
+    total += sizeof(hrtf->elev[0])*evCount;
+    total = RoundUp(total, 16); /* Align for coefficients using SIMD */
+    header.mCoeffsOffset = static_cast<uint32_t>(total);
+    total += sizeof(hrtf->coeffs[0])*irCount;
+    header.mDelaysOffset = static_cast<uint32_t>(total);
+    total += sizeof(hrtf->delays[0])*irCount;
+    header.mTotalSize = static_cast<uint32_t>(total);
+
+    auto data = al::vector<al::byte>(total);
+    std::memcpy(data.data(), &header, sizeof(header));
+    std::memcpy(data.data()+header.mFieldOffset, hrtf->field, sizeof(hrtf->field[0])*hrtf->fdCount);
+    std::memcpy(data.data()+header.mElevOffset, hrtf->elev, sizeof(hrtf->elev[0])*evCount);
+    std::memcpy(data.data()+header.mCoeffsOffset, hrtf->coeffs, sizeof(hrtf->coeffs[0])*irCount);
+    std::memcpy(data.data()+header.mDelaysOffset, hrtf->delays, sizeof(hrtf->delays[0])*irCount);
+    return data;
+}
+
+std::unique_ptr<HrtfStore> LoadHrtfMap(const FileMapping &mapping, const uint devrate,
+    const HrtfSourceId &srcid, const char *filename)
+{
+    HrtfMapHeader header;
+    if(mapping.mSize < sizeof(header))
+    {
+        ERR("%s is too short (%zu bytes)\n", filename, mapping.mSize);
+        return nullptr;
+    }
+    std::memcpy(&header, mapping.mData, sizeof(header));
+
+    if(memcmp(header.mMagic, magicMarkerMap, sizeof(magicMarkerMap)) != 0
+        || header.mByteOrder != MapByteOrder || header.mHrirLength != HrirLength)
+    {
+        WARN("%s is not a compatible precomputed data set\n", filename);
+        return nullptr;
+    }
+    if(header.mSampleRate != devrate || header.mSourceSize != srcid.mStamp.mSize
+        || (srcid.mHash ? header.mSourceHash != srcid.mHash
+            : header.mSourceTime != srcid.mStamp.mModTime))
+    {
+        TRACE("%s is out of date\n", filename);
+        return nullptr;
+    }
+
+    auto range_ok = [&header](size_t offset, size_t align, size_t size) noexcept -> bool
+    { return !(offset%align) && offset <= header.mTotalSize && size <= header.mTotalSize-offset; };
+    if(header.mTotalSize != mapping.mSize
+        || header.mFdCount < MinFdCount || header.mFdCount > MaxFdCount
+        || header.mIrSize < MinIrLength || header.mIrSize > HrirLength
+        || header.mEvCount < 1 || header.mIrCount < 1
+        || !range_ok(header.mFieldOffset, alignof(HrtfStore::Field),
+            sizeof(HrtfStore::Field)*header.mFdCount)
+        || !range_ok(header.mElevOffset, alignof(HrtfStore::Elevation),
+            sizeof(HrtfStore::Elevation)*header.mEvCount)
+        || !range_ok(header.mCoeffsOffset, 16, sizeof(HrirArray)*header.mIrCount)
+        || !range_ok(header.mDelaysOffset, alignof(ubyte2), sizeof(ubyte2)*header.mIrCount))
+    {
+        ERR("%s has an invalid layout\n", filename);
+        return nullptr;
+    }
+
+    auto fields = reinterpret_cast<const HrtfStore::Field*>(mapping.mData + header.mFieldOffset);
+    auto elevs = reinterpret_cast<const HrtfStore::Elevation*>(mapping.mData + header.mElevOffset);
+    const size_t evCount{std::accumulate(fields, fields+header.mFdCount, size_t{0},
+        [](const size_t curval, const HrtfStore::Field &field) noexcept -> size_t
+        { return curval + field.evCount; })};
+    if(evCount != header.mEvCount
+        || size_t{elevs[evCount-1].irOffset} + elevs[evCount-1].azCount != header.mIrCount)
+    {
+        ERR("%s has mismatched elevation counts\n", filename);
+        return nullptr;
+    }
+
+    /* The mapped data is indexed directly when mixing, so make sure it's laid
+     * out as a loaded data set would be. Fields are stored farthest first.
+     */
+    for(size_t f{0};f < header.mFdCount;++f)
+    {
+        const float distance{fields[f].distance};
+        if(!(distance >= MinFdDistance/1000.0f && distance <= MaxFdDistance/1000.0f)
+            || fields[f].evCount < MinEvCount || fields[f].evCount > MaxEvCount
+            || (f > 0 && !(distance < fields[f-1].distance)))
+        {
+            ERR("%s has an invalid field[%zu]: distance=%f, evCount=%d\n", filename, f,
+                distance, fields[f].evCount);
+            return nullptr;
+        }
+    }
+    for(size_t e{0};e < evCount;++e)
+    {
+        const size_t irOffset{(e > 0) ? size_t{elevs[e-1].irOffset} + elevs[e-1].azCount : 0};
+        if(elevs[e].azCount < MinAzCount || elevs[e].azCount > MaxAzCount
+            || elevs[e].irOffset != irOffset)
+        {
+            ERR("%s has an invalid elevation[%zu]: azCount=%d, irOffset=%d\n", filename, e,
+                elevs[e].azCount, elevs[e].irOffset);
+            return nullptr;
+        }
+    }
+    auto delays = reinterpret_cast<const ubyte2*>(mapping.mData + header.mDelaysOffset);
+    auto invalid_delay = [](const ubyte2 &delay) noexcept -> bool
+    {
+        return delay[0] > MaxHrirDelay<<HrirDelayFracBits
+            || delay[1] > MaxHrirDelay<<HrirDelayFracBits;
+    };
+    if(std::any_of(delays, delays+header.mIrCount, invalid_delay))
+    {
+        ERR("%s has invalid delays\n", filename);
+        return nullptr;
+    }
+
+    void *ptr{al_calloc(16, sizeof(HrtfStore))};
+    std::unique_ptr<HrtfStore> Hrtf{al::construct_at(static_cast<HrtfStore*>(ptr))};
+    if(!Hrtf)
+    {
+        ERR("Out of memory allocating storage for %s.\n", filename);
+        return nullptr;
+    }
+
+    InitRef(Hrtf->mRef, 1u);
+    Hrtf->sampleRate = header.mSampleRate;
+    Hrtf->irSize = header.mIrSize;
+    Hrtf->fdCount = header.mFdCount;
+    Hrtf->field = fields;
+    Hrtf->elev = elevs;
+    Hrtf->coeffs = reinterpret_cast<const HrirArray*>(mapping.mData + header.mCoeffsOffset);
+    Hrtf->delays = delays;
+    return Hrtf;
+}
+
+
 bool checkName(const std::string &name)
 {
     auto match_name = [&name](const HrtfEntry &entry) -> bool { return name == entry.mDispName; };
@@ -1267,7 +1704,9 @@ al::vector<std::string> EnumerateHrtf(al::optional<std::string> pathopt)
     return list;
 }
 
-HrtfStorePtr GetLoadedHrtf(const std::string &name, const uint devrate)
+HrtfStorePtr GetLoadedHrtf(const std::string &name, const uint devrate,
+    const al::optional<std::string> &mappath, const al::optional<std::string> &cachepath,
+    const uint64_t cachelimit)
 {
     std::lock_guard<std::mutex> _{EnumeratedHrtfLock};
     auto entry_iter = std::find_if(EnumeratedHrtfs.cbegin(), EnumeratedHrtfs.cend(),
@@ -1291,18 +1730,79 @@ HrtfStorePtr GetLoadedHrtf(const std::string &name, const uint devrate)
         ++handle;
     }
 
-    std::unique_ptr<std::istream> stream;
     int residx{};
     char ch{};
-    if(sscanf(fname.c_str(), "!%d%c", &residx, &ch) == 2 && ch == '_')
+    const bool isresource{sscanf(fname.c_str(), "!%d%c", &residx, &ch) == 2 && ch == '_'};
+    al::span<const char> res;
+    al::optional<FileStamp> srcstamp;
+    if(isresource)
     {
-        TRACE("Loading %s...\n", fname.c_str());
-        al::span<const char> res{GetResource(residx)};
+        res = GetResource(residx);
         if(res.empty())
         {
             ERR("Could not get resource %u, %s\n", residx, name.c_str());
             return nullptr;
         }
+        srcstamp = al::make_optional(FileStamp{res.size(), 0});
+    }
+    else
+        srcstamp = GetFileStamp(fname);
+
+    /* Only data sets that need resampling for the device are cached, which
+     * is checked from the rate in the header.
+     */
+    bool usecache{cachepath && !cachepath->empty() && srcstamp
+        && !(mappath && !mappath->empty())};
+    if(usecache)
+    {
+        const uint srcrate{GetHrtfSourceRate(fname, res)};
+        usecache = srcrate != 0 && srcrate != devrate;
+    }
+    const HrtfSourceId srcid{srcstamp.value_or(FileStamp{}),
+        usecache ? HashHrtfSource(fname, *srcstamp, res) : 0};
+
+    auto map_hrtf = [&](const std::string &mapfile) -> bool
+    {
+        HrtfMapping mapping{MapFileToMem(mapfile)};
+        if(!mapping.get().mData) return false;
+
+        auto hrtf = LoadHrtfMap(mapping.get(), devrate, srcid, mapfile.c_str());
+        if(!hrtf) return false;
+
+        TRACE("Mapped precomputed HRTF %s for sample rate %uhz, %u-sample filter\n",
+            mapfile.c_str(), hrtf->sampleRate, hrtf->irSize);
+        handle = LoadedHrtfs.emplace(handle, LoadedHrtf{fname, std::move(hrtf),
+            std::move(mapping)});
+        return true;
+    };
+
+    /* Use a precomputed copy for this rate if one is available and current,
+     * which needs no parsing or resampling and shares its pages with any
+     * other process using it.
+     */
+    std::string mapname;
+    if(mappath && !mappath->empty() && srcstamp)
+    {
+        mapname = GetHrtfMapName(*mappath, name, devrate);
+        if(map_hrtf(mapname))
+            return HrtfStorePtr{handle->mEntry.get()};
+    }
+    std::string cachename;
+    if(srcid.mHash != 0)
+    {
+        cachename = GetHrtfCacheName(*cachepath, srcid.mHash, devrate);
+        if(map_hrtf(cachename))
+        {
+            /* Mark it as recently used, so it's kept over older entries. */
+            TouchFile(cachename);
+            return HrtfStorePtr{handle->mEntry.get()};
+        }
+    }
+
+    std::unique_ptr<std::istream> stream;
+    if(!res.empty())
+    {
+        TRACE("Loading %s...\n", fname.c_str());
         stream = std::make_unique<idstream>(res.begin(), res.end());
     }
     else
@@ -1352,7 +1852,8 @@ HrtfStorePtr GetLoadedHrtf(const std::string &name, const uint devrate)
         return nullptr;
     }
 
-    if(hrtf->sampleRate != devrate)
+    const bool resampled{hrtf->sampleRate != devrate};
+    if(resampled)
     {
         TRACE("Resampling HRTF %s (%uhz -> %uhz)\n", name.c_str(), hrtf->sampleRate, devrate);
 
@@ -1424,12 +1925,43 @@ HrtfStorePtr GetLoadedHrtf(const std::string &name, const uint devrate)
 
     TRACE("Loaded HRTF %s for sample rate %uhz, %u-sample filter\n", name.c_str(),
         hrtf->sampleRate, hrtf->irSize);
-    handle = LoadedHrtfs.emplace(handle, LoadedHrtf{fname, std::move(hrtf)});
+
+    /* Store precomputed copies for later loads, with rate-converted data sets
+     * also going to the cache. A stored copy is then mapped in place of the
+     * private one, so its pages can be shared.
+     */
+    std::string storedname;
+    if(!mapname.empty() || (resampled && !cachename.empty()))
+    {
+        const auto mapdata = MakeHrtfMapData(hrtf.get(), srcid);
+        if(!mapname.empty() && StoreFileAtomic(mapname, mapdata))
+        {
+            TRACE("Stored precomputed HRTF %s\n", mapname.c_str());
+            storedname = mapname;
+        }
+        if(resampled && !cachename.empty() && MakeDirectories(*cachepath)
+            && StoreFileAtomic(cachename, mapdata))
+        {
+            TRACE("Stored cached HRTF %s\n", cachename.c_str());
+            if(storedname.empty())
+                storedname = cachename;
+            TrimDirectory(*cachepath, ".mhrmap", cachelimit);
+        }
+    }
+    if(!storedname.empty() && map_hrtf(storedname))
+        return HrtfStorePtr{handle->mEntry.get()};
+
+    handle = LoadedHrtfs.emplace(handle, LoadedHrtf{fname, std::move(hrtf), HrtfMapping{}});
 
     return HrtfStorePtr{handle->mEntry.get()};
 }
 
 
+HrtfStore::~HrtfStore()
+{
+    delete mCoeffCache.load(std::memory_order_relaxed);
+}
+
 void HrtfStore::add_ref()
 {
     auto ref = IncrementRef(mRef);
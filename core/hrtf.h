@@ -2,6 +2,7 @@
 #define CORE_HRTF_H
 
 #include <array>
+#include <atomic>
 #include <cstddef>
 #include <memory>
 #include <string>
@@ -16,6 +17,8 @@
 #include "intrusive_ptr.h"
 #include "vector.h"
 
+struct HrtfCoeffCache;
+
 
 struct HrtfStore {
     RefCount mRef;
@@ -37,10 +40,18 @@ struct HrtfStore {
         ushort azCount;
         ushort irOffset;
     };
-    Elevation *elev;
+    const Elevation *elev;
     const HrirArray *coeffs;
     const ubyte2 *delays;
 
+    /* Optional cache of blended coefficients for GetHrtfCoeffs, shared by all
+     * devices using this HRTF.
+     */
+    std::atomic<HrtfCoeffCache*> mCoeffCache{nullptr};
+
+    HrtfStore() = default;
+    ~HrtfStore();
+
     void add_ref();
     void release();
 
@@ -82,9 +93,30 @@ struct DirectHrtfState {
 
 
 al::vector<std::string> EnumerateHrtf(al::optional<std::string> pathopt);
-HrtfStorePtr GetLoadedHrtf(const std::string &name, const uint devrate);
+HrtfStorePtr GetLoadedHrtf(const std::string &name, const uint devrate,
+    const al::optional<std::string> &mappath, const al::optional<std::string> &cachepath,
+    const uint64_t cachelimit);
+
+/* Hit and miss counts for the coefficient cache, kept by each user of it. */
+struct HrtfCoeffCacheStats {
+    std::atomic<uint> mHits{0u};
+    std::atomic<uint> mMisses{0u};
+};
 
+/**
+ * Gets the HRIR coefficients and delays for the given direction, distance, and
+ * spread. When the HRTF has a coefficient cache, the lookup is counted in the
+ * given stats, which must only be updated by the calling thread.
+ */
 void GetHrtfCoeffs(const HrtfStore *Hrtf, float elevation, float azimuth, float distance,
-    float spread, HrirArray &coeffs, const al::span<uint,2> delays);
+    float spread, HrirArray &coeffs, const al::span<uint,2> delays, HrtfCoeffCacheStats &stats);
+
+/**
+ * Enables caching the results of GetHrtfCoeffs for the HRTF, with the given
+ * number of entries (rounded up to a power of 2). Cached results are looked
+ * up by quantized direction and spread, so sources with nearby directions
+ * will share them. Does nothing if the HRTF already has a cache.
+ */
+void EnableHrtfCoeffCache(HrtfStore *Hrtf, uint numEntries);
 
 #endif /* CORE_HRTF_H */
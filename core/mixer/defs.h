@@ -10,6 +10,7 @@
 
 struct HrtfChannelState;
 struct HrtfFilter;
+struct HrirSpectra;
 struct MixHrtfFilter;
 
 using uint = unsigned int;
@@ -74,11 +75,37 @@ void MixHrtf_(const float *InSamples, float2 *AccumSamples, const uint IrSize,
 template<typename InstTag>
 void MixHrtfBlend_(const float *InSamples, float2 *AccumSamples, const uint IrSize,
     const HrtfFilter *oldparams, const MixHrtfFilter *newparams, const size_t BufferSize);
+/* Frequency-domain versions of the above, which convolve blocks of samples
+ * with FFTs instead of each sample with the IR. These are cheaper for longer
+ * IRs and mixes. The given spectra are reused while the IR stays the same.
+ */
+void MixHrtfFft(const float *InSamples, float2 *AccumSamples, const uint IrSize,
+    const MixHrtfFilter *hrtfparams, HrirSpectra &spectra, const size_t BufferSize);
+void MixHrtfBlendFft(const float *InSamples, float2 *AccumSamples, const uint IrSize,
+    const HrtfFilter *oldparams, const MixHrtfFilter *newparams, HrirSpectra &spectra,
+    const size_t BufferSize);
 template<typename InstTag>
 void MixDirectHrtf_(const FloatBufferSpan LeftOut, const FloatBufferSpan RightOut,
     const al::span<const FloatBufferLine> InSamples, float2 *AccumSamples,
     float *TempBuf, HrtfChannelState *ChanState, const size_t IrSize, const size_t BufferSize);
 
+/* Modulated delay line functions, used by the chorus and flanger. The LFO
+ * functions write todo fixed-point (MixerFracBits) delays, for the LFO
+ * offsets offset+0...offset+todo-1 (which must not wrap around the LFO
+ * range). The tap function reads the cubic-interpolated delay line sample at
+ * each of the todo delays, relative to the write offsets offset+0...
+ * offset+todo-1 of the power-of-two sized delay line.
+ */
+template<typename InstTag>
+void ModDelayTriangle_(uint *delays, const uint offset, const float scale, const float depth,
+    const int delay, const size_t todo);
+template<typename InstTag>
+void ModDelaySinusoid_(uint *delays, const uint offset, const float scale, const float depth,
+    const int delay, const size_t todo);
+template<typename InstTag>
+void ModDelayTaps_(const float *delaybuf, const size_t bufmask, const uint offset,
+    const uint *delays, float *dst, const size_t todo);
+
 /* Vectorized resampler helpers */
 template<size_t N>
 inline void InitPosArrays(uint frac, uint increment, uint (&frac_arr)[N], uint (&pos_arr)[N])
@@ -43,6 +43,32 @@ struct HrtfFilter {
     float Gain;
 };
 
+/* The FFT size used for block convolution with HRIRs. Since HRIRs are at most
+ * HrirLength samples, each block can process at least HrtfFftSize+1-HrirLength
+ * input samples without the output wrapping around.
+ */
+constexpr uint HrtfFftBits{HrirBits + 1};
+constexpr uint HrtfFftSize{1u << HrtfFftBits};
+
+/* Complex values are stored with separate real and imaginary arrays, so that
+ * the butterflies can process multiple values at once.
+ */
+struct HrtfFftBuffer {
+    alignas(16) std::array<float,HrtfFftSize> mRe;
+    alignas(16) std::array<float,HrtfFftSize> mIm;
+};
+
+/* The spectra used to convolve with an HRIR, along with the IR they were
+ * calculated for so they're only recalculated when it changes.
+ */
+struct HrirSpectra {
+    HrtfFftBuffer mP;
+    HrtfFftBuffer mQ;
+
+    alignas(16) HrirArray mCoeffs;
+    uint mIrSize{0u};
+};
+
 
 struct HrtfChannelState {
     BandSplitter mSplitter;
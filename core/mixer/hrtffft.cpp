@@ -0,0 +1,361 @@
+
+#include "config.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stddef.h>
+
+#ifdef HAVE_SSE_INTRINSICS
+#include <xmmintrin.h>
+#endif
+
+#include "alnumbers.h"
+#include "alnumeric.h"
+#include "alspan.h"
+#include "defs.h"
+#include "hrtfdefs.h"
+#include "opthelpers.h"
+
+
+namespace {
+
+constexpr uint HrtfFftMask{HrtfFftSize - 1};
+
+using FftBuffer = HrtfFftBuffer;
+
+struct FftTables {
+    /* The twiddle factors for each stage. The stage with half-size h is stored
+     * at offset HrtfFftSize-2h.
+     */
+    alignas(16) std::array<float,HrtfFftSize> mTwRe{};
+    alignas(16) std::array<float,HrtfFftSize> mTwIm{};
+
+    /* The forward transform leaves its output in bit-reversed order, which
+     * the inverse transform takes as input. This maps each bit-reversed bin
+     * to the bit-reversed bin of its negated frequency.
+     */
+    std::array<ushort,HrtfFftSize> mMirror{};
+
+    FftTables()
+    {
+        for(uint half{HrtfFftSize>>1};half > 0;half >>= 1)
+        {
+            const uint base{HrtfFftSize - half*2};
+            for(uint j{0};j < half;++j)
+            {
+                const double phase{al::numbers::pi * j / half};
+                mTwRe[base+j] = static_cast<float>(std::cos(phase));
+                mTwIm[base+j] = static_cast<float>(-std::sin(phase));
+            }
+        }
+
+        auto bitrev = [](uint idx) noexcept -> uint
+        {
+            uint ret{0};
+            for(uint i{0};i < HrtfFftBits;++i)
+            {
+                ret = (ret<<1) | (idx&1);
+                idx >>= 1;
+            }
+            return ret;
+        };
+        for(uint i{0};i < HrtfFftSize;++i)
+            mMirror[i] = static_cast<ushort>(bitrev((HrtfFftSize - bitrev(i)) & HrtfFftMask));
+    }
+};
+const FftTables gFftTables{};
+
+
+/* Forward transform (decimation-in-frequency), taking naturally ordered input
+ * and leaving the output in bit-reversed order.
+ */
+void FftForward(FftBuffer &buffer)
+{
+    float *RESTRICT re{buffer.mRe.data()};
+    float *RESTRICT im{buffer.mIm.data()};
+
+    for(uint half{HrtfFftSize>>1};half >= 4;half >>= 1)
+    {
+        const float *RESTRICT twre{gFftTables.mTwRe.data() + HrtfFftSize - half*2};
+        const float *RESTRICT twim{gFftTables.mTwIm.data() + HrtfFftSize - half*2};
+        for(uint g{0};g < HrtfFftSize;g += half*2)
+        {
+#ifdef HAVE_SSE_INTRINSICS
+            for(uint j{0};j < half;j += 4)
+            {
+                const __m128 ar{_mm_load_ps(re+g+j)}, ai{_mm_load_ps(im+g+j)};
+                const __m128 br{_mm_load_ps(re+g+j+half)}, bi{_mm_load_ps(im+g+j+half)};
+                const __m128 wr{_mm_load_ps(twre+j)}, wi{_mm_load_ps(twim+j)};
+                const __m128 dr{_mm_sub_ps(ar, br)}, di{_mm_sub_ps(ai, bi)};
+                _mm_store_ps(re+g+j, _mm_add_ps(ar, br));
+                _mm_store_ps(im+g+j, _mm_add_ps(ai, bi));
+                _mm_store_ps(re+g+j+half, _mm_sub_ps(_mm_mul_ps(dr, wr), _mm_mul_ps(di, wi)));
+                _mm_store_ps(im+g+j+half, _mm_add_ps(_mm_mul_ps(dr, wi), _mm_mul_ps(di, wr)));
+            }
+#else
+            for(uint j{0};j < half;++j)
+            {
+                const float ar{re[g+j]}, ai{im[g+j]};
+                const float br{re[g+j+half]}, bi{im[g+j+half]};
+                const float dr{ar - br}, di{ai - bi};
+                re[g+j] = ar + br;
+                im[g+j] = ai + bi;
+                re[g+j+half] = dr*twre[j] - di*twim[j];
+                im[g+j+half] = dr*twim[j] + di*twre[j];
+            }
+#endif
+        }
+    }
+
+    /* The last two stages only use trivial twiddle factors (1 and -i), so
+     * combine them.
+     */
+    for(uint g{0};g < HrtfFftSize;g += 4)
+    {
+        const float ar0{re[g] + re[g+2]}, ai0{im[g] + im[g+2]};
+        const float ar1{re[g+1] + re[g+3]}, ai1{im[g+1] + im[g+3]};
+        const float br0{re[g] - re[g+2]}, bi0{im[g] - im[g+2]};
+        const float br1{im[g+1] - im[g+3]}, bi1{re[g+3] - re[g+1]};
+        re[g  ] = ar0 + ar1; im[g  ] = ai0 + ai1;
+        re[g+1] = ar0 - ar1; im[g+1] = ai0 - ai1;
+        re[g+2] = br0 + br1; im[g+2] = bi0 + bi1;
+        re[g+3] = br0 - br1; im[g+3] = bi0 - bi1;
+    }
+}
+
+/* Inverse transform (decimation-in-time), taking bit-reversed input and
+ * leaving the output in natural order. The result is not scaled.
+ */
+void FftInverse(FftBuffer &buffer)
+{
+    float *RESTRICT re{buffer.mRe.data()};
+    float *RESTRICT im{buffer.mIm.data()};
+
+    /* The first two stages only use trivial twiddle factors (1 and +i). */
+    for(uint g{0};g < HrtfFftSize;g += 4)
+    {
+        const float ar0{re[g] + re[g+1]}, ai0{im[g] + im[g+1]};
+        const float ar1{re[g] - re[g+1]}, ai1{im[g] - im[g+1]};
+        const float ar2{re[g+2] + re[g+3]}, ai2{im[g+2] + im[g+3]};
+        const float ar3{re[g+2] - re[g+3]}, ai3{im[g+2] - im[g+3]};
+        re[g  ] = ar0 + ar2; im[g  ] = ai0 + ai2;
+        re[g+2] = ar0 - ar2; im[g+2] = ai0 - ai2;
+        re[g+1] = ar1 - ai3; im[g+1] = ai1 + ar3;
+        re[g+3] = ar1 + ai3; im[g+3] = ai1 - ar3;
+    }
+
+    for(uint half{4};half < HrtfFftSize;half <<= 1)
+    {
+        const float *RESTRICT twre{gFftTables.mTwRe.data() + HrtfFftSize - half*2};
+        const float *RESTRICT twim{gFftTables.mTwIm.data() + HrtfFftSize - half*2};
+        for(uint g{0};g < HrtfFftSize;g += half*2)
+        {
+#ifdef HAVE_SSE_INTRINSICS
+            for(uint j{0};j < half;j += 4)
+            {
+                const __m128 ar{_mm_load_ps(re+g+j)}, ai{_mm_load_ps(im+g+j)};
+                const __m128 br{_mm_load_ps(re+g+j+half)}, bi{_mm_load_ps(im+g+j+half)};
+                const __m128 wr{_mm_load_ps(twre+j)}, wi{_mm_load_ps(twim+j)};
+                /* Multiply by the conjugate twiddle factor. */
+                const __m128 tr{_mm_add_ps(_mm_mul_ps(br, wr), _mm_mul_ps(bi, wi))};
+                const __m128 ti{_mm_sub_ps(_mm_mul_ps(bi, wr), _mm_mul_ps(br, wi))};
+                _mm_store_ps(re+g+j, _mm_add_ps(ar, tr));
+                _mm_store_ps(im+g+j, _mm_add_ps(ai, ti));
+                _mm_store_ps(re+g+j+half, _mm_sub_ps(ar, tr));
+                _mm_store_ps(im+g+j+half, _mm_sub_ps(ai, ti));
+            }
+#else
+            for(uint j{0};j < half;++j)
+            {
+                const float ar{re[g+j]}, ai{im[g+j]};
+                const float br{re[g+j+half]}, bi{im[g+j+half]};
+                const float tr{br*twre[j] + bi*twim[j]};
+                const float ti{bi*twre[j] - br*twim[j]};
+                re[g+j] = ar + tr;
+                im[g+j] = ai + ti;
+                re[g+j+half] = ar - tr;
+                im[g+j+half] = ai - ti;
+            }
+#endif
+        }
+    }
+}
+
+
+/* The left and right channels are convolved together, as the real and
+ * imaginary parts of one complex signal. Given the input spectrum Z, the
+ * output spectrum is Z*P + conj(Z[-k])*Q, with P and Q combining the left and
+ * right HRIR spectra Hl and Hr as (Hl+Hr)/2 and (Hl-Hr)/2 respectively.
+ */
+void CalcHrirSpectra(const ConstHrirSpan Coeffs, const uint IrSize, FftBuffer &P, FftBuffer &Q)
+{
+    FftBuffer hrir;
+    for(uint i{0};i < IrSize;++i)
+    {
+        hrir.mRe[i] = Coeffs[i][0];
+        hrir.mIm[i] = Coeffs[i][1];
+    }
+    std::fill(hrir.mRe.begin()+IrSize, hrir.mRe.end(), 0.0f);
+    std::fill(hrir.mIm.begin()+IrSize, hrir.mIm.end(), 0.0f);
+    FftForward(hrir);
+
+    /* With W being the spectrum of the packed HRIR (left + i*right),
+     * P = ((1-i)*W + (1+i)*conj(W[-k])) / 4
+     * Q = ((1+i)*W + (1-i)*conj(W[-k])) / 4
+     * The inverse transform's scaling is also applied here.
+     */
+    constexpr float scale{0.25f / HrtfFftSize};
+    for(uint i{0};i < HrtfFftSize;++i)
+    {
+        const uint m{gFftTables.mMirror[i]};
+        const float wr{hrir.mRe[i]}, wi{hrir.mIm[i]};
+        const float mr{hrir.mRe[m]}, mi{-hrir.mIm[m]};
+        P.mRe[i] = (wr + wi + mr - mi) * scale;
+        P.mIm[i] = (wi - wr + mr + mi) * scale;
+        Q.mRe[i] = (wr - wi + mr + mi) * scale;
+        Q.mIm[i] = (wr + wi + mi - mr) * scale;
+    }
+}
+
+/* Returns the spectra for the given HRIR, recalculating the cached spectra
+ * only if they were calculated for a different one.
+ */
+const HrirSpectra &GetHrirSpectra(const ConstHrirSpan Coeffs, const uint IrSize,
+    HrirSpectra &spectra)
+{
+    if(spectra.mIrSize != IrSize
+        || !std::equal(Coeffs.begin(), Coeffs.begin()+IrSize, spectra.mCoeffs.cbegin()))
+    {
+        CalcHrirSpectra(Coeffs, IrSize, spectra.mP, spectra.mQ);
+        std::copy_n(Coeffs.begin(), IrSize, spectra.mCoeffs.begin());
+        spectra.mIrSize = IrSize;
+    }
+    return spectra;
+}
+
+void ApplySpectra(const FftBuffer &input, const FftBuffer &P, const FftBuffer &Q,
+    FftBuffer &output)
+{
+    const auto &mirror = gFftTables.mMirror;
+#ifdef HAVE_SSE_INTRINSICS
+    for(uint i{0};i < HrtfFftSize;i += 4)
+    {
+        const __m128 zr{_mm_load_ps(&input.mRe[i])}, zi{_mm_load_ps(&input.mIm[i])};
+        const __m128 cr{_mm_setr_ps(input.mRe[mirror[i]], input.mRe[mirror[i+1]],
+            input.mRe[mirror[i+2]], input.mRe[mirror[i+3]])};
+        const __m128 ci{_mm_setr_ps(-input.mIm[mirror[i]], -input.mIm[mirror[i+1]],
+            -input.mIm[mirror[i+2]], -input.mIm[mirror[i+3]])};
+        const __m128 pr{_mm_load_ps(&P.mRe[i])}, pi{_mm_load_ps(&P.mIm[i])};
+        const __m128 qr{_mm_load_ps(&Q.mRe[i])}, qi{_mm_load_ps(&Q.mIm[i])};
+        const __m128 yr{_mm_sub_ps(_mm_add_ps(_mm_mul_ps(zr, pr), _mm_mul_ps(cr, qr)),
+            _mm_add_ps(_mm_mul_ps(zi, pi), _mm_mul_ps(ci, qi)))};
+        const __m128 yi{_mm_add_ps(_mm_add_ps(_mm_mul_ps(zr, pi), _mm_mul_ps(zi, pr)),
+            _mm_add_ps(_mm_mul_ps(cr, qi), _mm_mul_ps(ci, qr)))};
+        _mm_store_ps(&output.mRe[i], yr);
+        _mm_store_ps(&output.mIm[i], yi);
+    }
+#else
+    for(uint i{0};i < HrtfFftSize;++i)
+    {
+        const float zr{input.mRe[i]}, zi{input.mIm[i]};
+        const float cr{input.mRe[mirror[i]]}, ci{-input.mIm[mirror[i]]};
+        output.mRe[i] = zr*P.mRe[i] - zi*P.mIm[i] + cr*Q.mRe[i] - ci*Q.mIm[i];
+        output.mIm[i] = zr*P.mIm[i] + zi*P.mRe[i] + cr*Q.mIm[i] + ci*Q.mRe[i];
+    }
+#endif
+}
+
+/* Convolves the delayed and gain-scaled input with the given HRIR spectra,
+ * adding the result to the accumulation buffer. The input is processed in
+ * blocks small enough for the convolution output to fit in one transform, with
+ * the overlapping tails added together in the accumulation buffer.
+ */
+template<typename GainFunc>
+void ConvolveBlocks(const float *InSamples, float2 *RESTRICT AccumSamples, const uint IrSize,
+    const uint2 Delay, const FftBuffer &P, const FftBuffer &Q, const size_t BufferSize,
+    GainFunc getgain)
+{
+    const float *left{InSamples + HrtfHistoryLength - Delay[0]};
+    const float *right{InSamples + HrtfHistoryLength - Delay[1]};
+    const size_t blocksize{HrtfFftSize+1 - IrSize};
+
+    FftBuffer input, output;
+    size_t base{0};
+    while(base < BufferSize)
+    {
+        const size_t todo{minz(blocksize, BufferSize-base)};
+        for(size_t i{0};i < todo;++i)
+        {
+            const float g{getgain(base+i)};
+            input.mRe[i] = left[base+i] * g;
+            input.mIm[i] = right[base+i] * g;
+        }
+        std::fill(input.mRe.begin()+todo, input.mRe.end(), 0.0f);
+        std::fill(input.mIm.begin()+todo, input.mIm.end(), 0.0f);
+
+        FftForward(input);
+        ApplySpectra(input, P, Q, output);
+        FftInverse(output);
+
+        const size_t outlen{todo + IrSize - 1};
+        for(size_t i{0};i < outlen;++i)
+        {
+            AccumSamples[base+i][0] += output.mRe[i];
+            AccumSamples[base+i][1] += output.mIm[i];
+        }
+        base += todo;
+    }
+}
+
+} // namespace
+
+void MixHrtfFft(const float *InSamples, float2 *AccumSamples, const uint IrSize,
+    const MixHrtfFilter *hrtfparams, HrirSpectra &spectra, const size_t BufferSize)
+{
+    ASSUME(BufferSize > 0);
+
+    /* The SIMD mixers apply the coefficients in pairs, so match them with odd
+     * IR sizes.
+     */
+    const uint irSize{(IrSize+1u) & ~1u};
+
+    const HrirSpectra &hrir = GetHrirSpectra(hrtfparams->Coeffs, irSize, spectra);
+
+    const float gain{hrtfparams->Gain};
+    const float gainstep{hrtfparams->GainStep};
+    ConvolveBlocks(InSamples, AccumSamples, irSize, hrtfparams->Delay, hrir.mP, hrir.mQ,
+        BufferSize,
+        [gain,gainstep](size_t i) noexcept { return gain + gainstep*static_cast<float>(i); });
+}
+
+void MixHrtfBlendFft(const float *InSamples, float2 *AccumSamples, const uint IrSize,
+    const HrtfFilter *oldparams, const MixHrtfFilter *newparams, HrirSpectra &spectra,
+    const size_t BufferSize)
+{
+    ASSUME(BufferSize > 0);
+
+    const uint irSize{(IrSize+1u) & ~1u};
+
+    const float oldGainStep{oldparams->Gain / static_cast<float>(BufferSize)};
+    const float newGainStep{newparams->GainStep};
+
+    /* The cached spectra are normally for the old HRIR, from the last mix.
+     * Convolving with it first lets the new HRIR's spectra replace them.
+     */
+    if LIKELY(oldparams->Gain > GainSilenceThreshold)
+    {
+        const HrirSpectra &hrir = GetHrirSpectra(oldparams->Coeffs, irSize, spectra);
+        ConvolveBlocks(InSamples, AccumSamples, irSize, oldparams->Delay, hrir.mP, hrir.mQ,
+            BufferSize, [oldGainStep,BufferSize](size_t i) noexcept
+            { return oldGainStep*static_cast<float>(BufferSize-i); });
+    }
+
+    if LIKELY(newGainStep*static_cast<float>(BufferSize) > GainSilenceThreshold)
+    {
+        const HrirSpectra &hrir = GetHrirSpectra(newparams->Coeffs, irSize, spectra);
+        ConvolveBlocks(InSamples, AccumSamples, irSize, newparams->Delay, hrir.mP, hrir.mQ,
+            BufferSize, [newGainStep](size_t i) noexcept
+            { return newGainStep*static_cast<float>(i); });
+    }
+}
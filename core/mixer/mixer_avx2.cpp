@@ -0,0 +1,621 @@
+#include "config.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "almalloc.h"
+#include "alnumbers.h"
+#include "alnumeric.h"
+#include "core/bsinc_defs.h"
+#include "defs.h"
+#include "hrtfdefs.h"
+#include "opthelpers.h"
+
+struct AVX2Tag;
+struct PointTag;
+struct LerpTag;
+struct CubicTag;
+struct BSincTag;
+struct FastBSincTag;
+
+
+#if defined(__GNUC__) && !defined(__clang__) && !(defined(__AVX2__) && defined(__FMA__))
+#pragma GCC target("avx2,fma")
+#elif defined(__clang__) && !(defined(__AVX2__) && defined(__FMA__))
+#pragma clang attribute push (__attribute__((target("avx2,fma"))), apply_to=function)
+#define POP_CLANG_TARGET
+#endif
+
+/* Include the HRTF mixer templates after enabling AVX2, so the ApplyCoeffs
+ * function below can be inlined into them. Everything they depend on is
+ * included above, to keep other inline functions from being built with AVX2.
+ */
+#include "hrtfbase.h"
+
+namespace {
+
+constexpr uint FracPhaseBitDiff{MixerFracBits - BSincPhaseBits};
+constexpr uint FracPhaseDiffOne{1 << FracPhaseBitDiff};
+
+inline float hsum8(const __m256 r8)
+{
+    __m128 r4{_mm_add_ps(_mm256_castps256_ps128(r8), _mm256_extractf128_ps(r8, 1))};
+    r4 = _mm_add_ps(r4, _mm_shuffle_ps(r4, r4, _MM_SHUFFLE(0, 1, 2, 3)));
+    r4 = _mm_add_ps(r4, _mm_movehl_ps(r4, r4));
+    return _mm_cvtss_f32(r4);
+}
+
+inline void ApplyCoeffs(float2 *RESTRICT Values, const size_t IrSize, const ConstHrirSpan Coeffs,
+    const float left, const float right)
+{
+    const __m256 lrlr{_mm256_setr_ps(left, right, left, right, left, right, left, right)};
+
+    ASSUME(IrSize >= MinIrLength);
+    /* Values alternates between 8- and 16-byte alignment, and the coefficients
+     * are only 16-byte aligned, so there's no point in trying to get aligned
+     * 8-wide loads. Unaligned loads that don't cross a cache line are
+     * generally as fast anyway.
+     */
+    size_t i{0};
+    for(size_t todo{IrSize >> 2};todo;--todo)
+    {
+        const __m256 coeffs{_mm256_loadu_ps(&Coeffs[i][0])};
+        __m256 vals{_mm256_loadu_ps(&Values[i][0])};
+        vals = _mm256_fmadd_ps(lrlr, coeffs, vals);
+        _mm256_storeu_ps(&Values[i][0], vals);
+        i += 4;
+    }
+    /* Like the SSE version, handle the remainder as pairs. */
+    for(;i < IrSize;i += 2)
+    {
+        const __m128 coeffs{_mm_load_ps(&Coeffs[i][0])};
+        __m128 vals{_mm_loadu_ps(&Values[i][0])};
+        vals = _mm_fmadd_ps(_mm256_castps256_ps128(lrlr), coeffs, vals);
+        _mm_storeu_ps(&Values[i][0], vals);
+    }
+}
+
+inline void InitPosVecs(uint frac, uint increment, __m256i &frac8, __m256i &pos8)
+{
+    alignas(32) uint pos_[8], frac_[8];
+    InitPosArrays(frac, increment, frac_, pos_);
+    frac8 = _mm256_load_si256(reinterpret_cast<const __m256i*>(frac_));
+    pos8 = _mm256_load_si256(reinterpret_cast<const __m256i*>(pos_));
+}
+
+} // namespace
+
+template<>
+float *Resample_<PointTag,AVX2Tag>(const InterpState*, float *RESTRICT src, uint frac,
+    uint increment, const al::span<float> dst)
+{
+    const __m256i increment8{_mm256_set1_epi32(static_cast<int>(increment*8))};
+    const __m256i fracMask8{_mm256_set1_epi32(MixerFracMask)};
+
+    __m256i frac8, pos8;
+    InitPosVecs(frac, increment, frac8, pos8);
+
+    auto dst_iter = dst.begin();
+    for(size_t todo{dst.size()>>3};todo;--todo)
+    {
+        _mm256_storeu_ps(dst_iter, _mm256_i32gather_ps(src, pos8, 4));
+        dst_iter += 8;
+
+        frac8 = _mm256_add_epi32(frac8, increment8);
+        pos8 = _mm256_add_epi32(pos8, _mm256_srli_epi32(frac8, MixerFracBits));
+        frac8 = _mm256_and_si256(frac8, fracMask8);
+    }
+
+    if(size_t todo{dst.size()&7})
+    {
+        src += static_cast<uint>(_mm_cvtsi128_si32(_mm256_castsi256_si128(pos8)));
+        frac = static_cast<uint>(_mm_cvtsi128_si32(_mm256_castsi256_si128(frac8)));
+
+        do {
+            *(dst_iter++) = src[0];
+
+            frac += increment;
+            src  += frac>>MixerFracBits;
+            frac &= MixerFracMask;
+        } while(--todo);
+    }
+    return dst.data();
+}
+
+template<>
+float *Resample_<LerpTag,AVX2Tag>(const InterpState*, float *RESTRICT src, uint frac,
+    uint increment, const al::span<float> dst)
+{
+    const __m256i increment8{_mm256_set1_epi32(static_cast<int>(increment*8))};
+    const __m256 fracOne8{_mm256_set1_ps(1.0f/MixerFracOne)};
+    const __m256i fracMask8{_mm256_set1_epi32(MixerFracMask)};
+
+    __m256i frac8, pos8;
+    InitPosVecs(frac, increment, frac8, pos8);
+
+    auto dst_iter = dst.begin();
+    for(size_t todo{dst.size()>>3};todo;--todo)
+    {
+        const __m256 val1{_mm256_i32gather_ps(src, pos8, 4)};
+        const __m256 val2{_mm256_i32gather_ps(src+1, pos8, 4)};
+
+        /* val1 + (val2-val1)*mu */
+        const __m256 r0{_mm256_sub_ps(val2, val1)};
+        const __m256 mu{_mm256_mul_ps(_mm256_cvtepi32_ps(frac8), fracOne8)};
+        const __m256 out{_mm256_fmadd_ps(mu, r0, val1)};
+
+        _mm256_storeu_ps(dst_iter, out);
+        dst_iter += 8;
+
+        frac8 = _mm256_add_epi32(frac8, increment8);
+        pos8 = _mm256_add_epi32(pos8, _mm256_srli_epi32(frac8, MixerFracBits));
+        frac8 = _mm256_and_si256(frac8, fracMask8);
+    }
+
+    if(size_t todo{dst.size()&7})
+    {
+        /* NOTE: These eight elements represent the position *after* the last
+         * eight samples, so the lowest element is the next position to
+         * resample.
+         */
+        src += static_cast<uint>(_mm_cvtsi128_si32(_mm256_castsi256_si128(pos8)));
+        frac = static_cast<uint>(_mm_cvtsi128_si32(_mm256_castsi256_si128(frac8)));
+
+        do {
+            *(dst_iter++) = lerpf(src[0], src[1], static_cast<float>(frac) * (1.0f/MixerFracOne));
+
+            frac += increment;
+            src  += frac>>MixerFracBits;
+            frac &= MixerFracMask;
+        } while(--todo);
+    }
+    return dst.data();
+}
+
+template<>
+float *Resample_<CubicTag,AVX2Tag>(const InterpState*, float *RESTRICT src, uint frac,
+    uint increment, const al::span<float> dst)
+{
+    const __m256i increment8{_mm256_set1_epi32(static_cast<int>(increment*8))};
+    const __m256 fracOne8{_mm256_set1_ps(1.0f/MixerFracOne)};
+    const __m256i fracMask8{_mm256_set1_epi32(MixerFracMask)};
+    const __m256 half8{_mm256_set1_ps(0.5f)};
+    const __m256 nhalf8{_mm256_set1_ps(-0.5f)};
+    const __m256 one8{_mm256_set1_ps(1.0f)};
+    const __m256 onehalf8{_mm256_set1_ps(1.5f)};
+    const __m256 nonehalf8{_mm256_set1_ps(-1.5f)};
+    const __m256 two8{_mm256_set1_ps(2.0f)};
+    const __m256 ntwohalf8{_mm256_set1_ps(-2.5f)};
+
+    /* The cubic filter is centered between the second and third sample. */
+    src -= 1;
+
+    __m256i frac8, pos8;
+    InitPosVecs(frac, increment, frac8, pos8);
+
+    auto dst_iter = dst.begin();
+    for(size_t todo{dst.size()>>3};todo;--todo)
+    {
+        const __m256 val1{_mm256_i32gather_ps(src  , pos8, 4)};
+        const __m256 val2{_mm256_i32gather_ps(src+1, pos8, 4)};
+        const __m256 val3{_mm256_i32gather_ps(src+2, pos8, 4)};
+        const __m256 val4{_mm256_i32gather_ps(src+3, pos8, 4)};
+
+        const __m256 mu{_mm256_mul_ps(_mm256_cvtepi32_ps(frac8), fracOne8)};
+        const __m256 mu2{_mm256_mul_ps(mu, mu)};
+        const __m256 mu3{_mm256_mul_ps(mu2, mu)};
+
+        /* a0 = -0.5*mu3 +     mu2 + -0.5*mu
+         * a1 =  1.5*mu3 + -2.5*mu2          + 1
+         * a2 = -1.5*mu3 +  2.0*mu2 +  0.5*mu
+         * a3 =  0.5*mu3 + -0.5*mu2
+         */
+        const __m256 a0{_mm256_fmadd_ps(nhalf8, mu3, _mm256_fmadd_ps(nhalf8, mu, mu2))};
+        const __m256 a1{_mm256_fmadd_ps(onehalf8, mu3, _mm256_fmadd_ps(ntwohalf8, mu2, one8))};
+        const __m256 a2{_mm256_fmadd_ps(nonehalf8, mu3,
+            _mm256_fmadd_ps(two8, mu2, _mm256_mul_ps(half8, mu)))};
+        const __m256 a3{_mm256_mul_ps(half8, _mm256_sub_ps(mu3, mu2))};
+
+        __m256 out{_mm256_mul_ps(val1, a0)};
+        out = _mm256_fmadd_ps(val2, a1, out);
+        out = _mm256_fmadd_ps(val3, a2, out);
+        out = _mm256_fmadd_ps(val4, a3, out);
+
+        _mm256_storeu_ps(dst_iter, out);
+        dst_iter += 8;
+
+        frac8 = _mm256_add_epi32(frac8, increment8);
+        pos8 = _mm256_add_epi32(pos8, _mm256_srli_epi32(frac8, MixerFracBits));
+        frac8 = _mm256_and_si256(frac8, fracMask8);
+    }
+
+    if(size_t todo{dst.size()&7})
+    {
+        src += static_cast<uint>(_mm_cvtsi128_si32(_mm256_castsi256_si128(pos8)));
+        frac = static_cast<uint>(_mm_cvtsi128_si32(_mm256_castsi256_si128(frac8)));
+
+        do {
+            *(dst_iter++) = cubic(src[0], src[1], src[2], src[3],
+                static_cast<float>(frac) * (1.0f/MixerFracOne));
+
+            frac += increment;
+            src  += frac>>MixerFracBits;
+            frac &= MixerFracMask;
+        } while(--todo);
+    }
+    return dst.data();
+}
+
+template<>
+float *Resample_<BSincTag,AVX2Tag>(const InterpState *state, float *RESTRICT src, uint frac,
+    uint increment, const al::span<float> dst)
+{
+    const float *const filter{state->bsinc.filter};
+    const __m256 sf8{_mm256_set1_ps(state->bsinc.sf)};
+    const size_t m{state->bsinc.m};
+    ASSUME(m > 0);
+
+    src -= state->bsinc.l;
+    for(float &out_sample : dst)
+    {
+        // Calculate the phase index and factor.
+        const uint pi{frac >> FracPhaseBitDiff};
+        const float pf{static_cast<float>(frac & (FracPhaseDiffOne-1)) * (1.0f/FracPhaseDiffOne)};
+
+        // Apply the scale and phase interpolated filter.
+        __m256 r8{_mm256_setzero_ps()};
+        {
+            const __m256 pf8{_mm256_set1_ps(pf)};
+            const float *RESTRICT fil{filter + m*pi*2};
+            const float *RESTRICT phd{fil + m};
+            const float *RESTRICT scd{fil + BSincPhaseCount*2*m};
+            const float *RESTRICT spd{scd + m};
+            size_t j{0u};
+
+            for(size_t td{m >> 3};td;--td)
+            {
+                /* f = ((fil + sf*scd) + pf*(phd + sf*spd)) */
+                const __m256 f8 = _mm256_fmadd_ps(pf8,
+                    _mm256_fmadd_ps(sf8, _mm256_loadu_ps(&spd[j]), _mm256_loadu_ps(&phd[j])),
+                    _mm256_fmadd_ps(sf8, _mm256_loadu_ps(&scd[j]), _mm256_loadu_ps(&fil[j])));
+                /* r += f*src */
+                r8 = _mm256_fmadd_ps(f8, _mm256_loadu_ps(&src[j]), r8);
+                j += 8;
+            }
+            /* The coefficient count is a multiple of 4, so there may be one
+             * group of 4 left over.
+             */
+            if((m&4))
+            {
+                const __m128 sf4{_mm256_castps256_ps128(sf8)};
+                const __m128 f4 = _mm_fmadd_ps(_mm256_castps256_ps128(pf8),
+                    _mm_fmadd_ps(sf4, _mm_load_ps(&spd[j]), _mm_load_ps(&phd[j])),
+                    _mm_fmadd_ps(sf4, _mm_load_ps(&scd[j]), _mm_load_ps(&fil[j])));
+                const __m128 r4{_mm_mul_ps(f4, _mm_loadu_ps(&src[j]))};
+                r8 = _mm256_add_ps(r8, _mm256_castps128_ps256(r4));
+            }
+        }
+        out_sample = hsum8(r8);
+
+        frac += increment;
+        src  += frac>>MixerFracBits;
+        frac &= MixerFracMask;
+    }
+    return dst.data();
+}
+
+template<>
+float *Resample_<FastBSincTag,AVX2Tag>(const InterpState *state, float *RESTRICT src, uint frac,
+    uint increment, const al::span<float> dst)
+{
+    const float *const filter{state->bsinc.filter};
+    const size_t m{state->bsinc.m};
+    ASSUME(m > 0);
+
+    src -= state->bsinc.l;
+    for(float &out_sample : dst)
+    {
+        // Calculate the phase index and factor.
+        const uint pi{frac >> FracPhaseBitDiff};
+        const float pf{static_cast<float>(frac & (FracPhaseDiffOne-1)) * (1.0f/FracPhaseDiffOne)};
+
+        // Apply the phase interpolated filter.
+        __m256 r8{_mm256_setzero_ps()};
+        {
+            const __m256 pf8{_mm256_set1_ps(pf)};
+            const float *RESTRICT fil{filter + m*pi*2};
+            const float *RESTRICT phd{fil + m};
+            size_t j{0u};
+
+            for(size_t td{m >> 3};td;--td)
+            {
+                /* f = fil + pf*phd */
+                const __m256 f8 = _mm256_fmadd_ps(pf8, _mm256_loadu_ps(&phd[j]),
+                    _mm256_loadu_ps(&fil[j]));
+                /* r += f*src */
+                r8 = _mm256_fmadd_ps(f8, _mm256_loadu_ps(&src[j]), r8);
+                j += 8;
+            }
+            if((m&4))
+            {
+                const __m128 f4 = _mm_fmadd_ps(_mm256_castps256_ps128(pf8), _mm_load_ps(&phd[j]),
+                    _mm_load_ps(&fil[j]));
+                const __m128 r4{_mm_mul_ps(f4, _mm_loadu_ps(&src[j]))};
+                r8 = _mm256_add_ps(r8, _mm256_castps128_ps256(r4));
+            }
+        }
+        out_sample = hsum8(r8);
+
+        frac += increment;
+        src  += frac>>MixerFracBits;
+        frac &= MixerFracMask;
+    }
+    return dst.data();
+}
+
+
+template<>
+void MixHrtf_<AVX2Tag>(const float *InSamples, float2 *AccumSamples, const uint IrSize,
+    const MixHrtfFilter *hrtfparams, const size_t BufferSize)
+{ MixHrtfBase<ApplyCoeffs>(InSamples, AccumSamples, IrSize, hrtfparams, BufferSize); }
+
+template<>
+void MixHrtfBlend_<AVX2Tag>(const float *InSamples, float2 *AccumSamples, const uint IrSize,
+    const HrtfFilter *oldparams, const MixHrtfFilter *newparams, const size_t BufferSize)
+{
+    MixHrtfBlendBase<ApplyCoeffs>(InSamples, AccumSamples, IrSize, oldparams, newparams,
+        BufferSize);
+}
+
+template<>
+void MixDirectHrtf_<AVX2Tag>(const FloatBufferSpan LeftOut, const FloatBufferSpan RightOut,
+    const al::span<const FloatBufferLine> InSamples, float2 *AccumSamples,
+    float *TempBuf, HrtfChannelState *ChanState, const size_t IrSize, const size_t BufferSize)
+{
+    MixDirectHrtfBase<ApplyCoeffs>(LeftOut, RightOut, InSamples, AccumSamples, TempBuf, ChanState,
+        IrSize, BufferSize);
+}
+
+
+template<>
+void Mix_<AVX2Tag>(const al::span<const float> InSamples, const al::span<FloatBufferLine> OutBuffer,
+    float *CurrentGains, const float *TargetGains, const size_t Counter, const size_t OutPos)
+{
+    const float delta{(Counter > 0) ? 1.0f / static_cast<float>(Counter) : 0.0f};
+    const auto min_len = minz(Counter, InSamples.size());
+    const auto aligned_len = minz((min_len+7) & ~size_t{7}, InSamples.size()) - min_len;
+
+    for(FloatBufferLine &output : OutBuffer)
+    {
+        float *RESTRICT dst{al::assume_aligned<16>(output.data()+OutPos)};
+        float gain{*CurrentGains};
+        const float step{(*TargetGains-gain) * delta};
+
+        size_t pos{0};
+        if(!(std::abs(step) > std::numeric_limits<float>::epsilon()))
+            gain = *TargetGains;
+        else
+        {
+            float step_count{0.0f};
+            /* Mix with applying gain steps in multiples of 8. */
+            if(size_t todo{min_len >> 3})
+            {
+                const __m256 eight8{_mm256_set1_ps(8.0f)};
+                const __m256 step8{_mm256_set1_ps(step)};
+                const __m256 gain8{_mm256_set1_ps(gain)};
+                __m256 step_count8{_mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f,
+                    7.0f)};
+                do {
+                    const __m256 val8{_mm256_loadu_ps(&InSamples[pos])};
+                    __m256 dry8{_mm256_loadu_ps(&dst[pos])};
+
+                    /* dry += val * (gain + step*step_count) */
+                    dry8 = _mm256_fmadd_ps(val8, _mm256_fmadd_ps(step8, step_count8, gain8),
+                        dry8);
+
+                    _mm256_storeu_ps(&dst[pos], dry8);
+                    step_count8 = _mm256_add_ps(step_count8, eight8);
+                    pos += 8;
+                } while(--todo);
+                /* NOTE: step_count8 now represents the next eight counts after
+                 * the last eight mixed samples, so the lowest element
+                 * represents the next step count to apply.
+                 */
+                step_count = _mm_cvtss_f32(_mm256_castps256_ps128(step_count8));
+            }
+            /* Mix with applying left over gain steps that aren't multiples of 8. */
+            for(size_t leftover{min_len&7};leftover;++pos,--leftover)
+            {
+                dst[pos] += InSamples[pos] * (gain + step*step_count);
+                step_count += 1.0f;
+            }
+            if(pos == Counter)
+                gain = *TargetGains;
+            else
+                gain += step*step_count;
+
+            /* Mix until pos is a multiple of 8 or the mix is done. */
+            for(size_t leftover{aligned_len&7};leftover;++pos,--leftover)
+                dst[pos] += InSamples[pos] * gain;
+        }
+        *CurrentGains = gain;
+        ++CurrentGains;
+        ++TargetGains;
+
+        if(!(std::abs(gain) > GainSilenceThreshold))
+            continue;
+        if(size_t todo{(InSamples.size()-pos) >> 3})
+        {
+            const __m256 gain8{_mm256_set1_ps(gain)};
+            do {
+                const __m256 val8{_mm256_loadu_ps(&InSamples[pos])};
+                __m256 dry8{_mm256_loadu_ps(&dst[pos])};
+                dry8 = _mm256_fmadd_ps(val8, gain8, dry8);
+                _mm256_storeu_ps(&dst[pos], dry8);
+                pos += 8;
+            } while(--todo);
+        }
+        for(size_t leftover{(InSamples.size()-pos)&7};leftover;++pos,--leftover)
+            dst[pos] += InSamples[pos] * gain;
+    }
+}
+
+
+namespace {
+
+/* Approximates sin(x) for 0 <= x <= 2pi, the same way as the SSE2 version. */
+inline __m256 sin_ps(const __m256 x)
+{
+    const __m256 pi8{_mm256_set1_ps(al::numbers::pi_v<float>)};
+    const __m256 npi8{_mm256_set1_ps(-al::numbers::pi_v<float>)};
+
+    const __m256 y{_mm256_sub_ps(x, pi8)};
+    __m256 t{_mm256_min_ps(y, _mm256_sub_ps(pi8, y))};
+    t = _mm256_max_ps(t, _mm256_sub_ps(npi8, t));
+
+    const __m256 t2{_mm256_mul_ps(t, t)};
+    __m256 r{_mm256_set1_ps(-1.0f/39916800.0f)};
+    r = _mm256_fmadd_ps(r, t2, _mm256_set1_ps(1.0f/362880.0f));
+    r = _mm256_fmadd_ps(r, t2, _mm256_set1_ps(-1.0f/5040.0f));
+    r = _mm256_fmadd_ps(r, t2, _mm256_set1_ps(1.0f/120.0f));
+    r = _mm256_fmadd_ps(r, t2, _mm256_set1_ps(-1.0f/6.0f));
+    r = _mm256_fmadd_ps(r, t2, _mm256_set1_ps(1.0f));
+    return _mm256_mul_ps(r, _mm256_sub_ps(_mm256_setzero_ps(), t));
+}
+
+template<typename F>
+inline void GenModDelays(uint *delays, const uint offset, const int delay, const size_t todo,
+    F calc_lfo)
+{
+    const __m256i delay8{_mm256_set1_epi32(delay)};
+    const __m256i eight8{_mm256_set1_epi32(8)};
+    __m256i offset8{_mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(offset)),
+        _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7))};
+
+    size_t i{0};
+    for(size_t count{todo>>3};count;--count)
+    {
+        const __m256i delays8{_mm256_add_epi32(_mm256_cvtps_epi32(calc_lfo(offset8)), delay8)};
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(delays+i), delays8);
+        offset8 = _mm256_add_epi32(offset8, eight8);
+        i += 8;
+    }
+    if(const size_t rem{todo&7})
+    {
+        alignas(32) uint vals[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(vals),
+            _mm256_add_epi32(_mm256_cvtps_epi32(calc_lfo(offset8)), delay8));
+        std::copy_n(vals, rem, delays+i);
+    }
+}
+
+} // namespace
+
+template<>
+void ModDelayTriangle_<AVX2Tag>(uint *delays, const uint offset, const float scale,
+    const float depth, const int delay, const size_t todo)
+{
+    const __m256 scale8{_mm256_set1_ps(scale)};
+    const __m256 depth8{_mm256_set1_ps(depth)};
+    const __m256 one8{_mm256_set1_ps(1.0f)};
+    const __m256 two8{_mm256_set1_ps(2.0f)};
+    const __m256 absmask8{_mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff))};
+
+    GenModDelays(delays, offset, delay, todo,
+        [=](const __m256i offset8) -> __m256
+        {
+            const __m256 offset_norm{_mm256_mul_ps(_mm256_cvtepi32_ps(offset8), scale8)};
+            const __m256 tri{_mm256_sub_ps(one8, _mm256_and_ps(_mm256_sub_ps(two8, offset_norm),
+                absmask8))};
+            return _mm256_mul_ps(tri, depth8);
+        });
+}
+
+template<>
+void ModDelaySinusoid_<AVX2Tag>(uint *delays, const uint offset, const float scale,
+    const float depth, const int delay, const size_t todo)
+{
+    const __m256 scale8{_mm256_set1_ps(scale)};
+    const __m256 depth8{_mm256_set1_ps(depth)};
+
+    GenModDelays(delays, offset, delay, todo,
+        [=](const __m256i offset8) -> __m256
+        {
+            const __m256 offset_norm{_mm256_mul_ps(_mm256_cvtepi32_ps(offset8), scale8)};
+            return _mm256_mul_ps(sin_ps(offset_norm), depth8);
+        });
+}
+
+template<>
+void ModDelayTaps_<AVX2Tag>(const float *delaybuf, const size_t bufmask, const uint offset,
+    const uint *delays, float *dst, const size_t todo)
+{
+    const __m256i bufMask8{_mm256_set1_epi32(static_cast<int>(bufmask))};
+    const __m256i fracMask8{_mm256_set1_epi32(MixerFracMask)};
+    const __m256i eight8{_mm256_set1_epi32(8)};
+    const __m256i one8i{_mm256_set1_epi32(1)};
+    const __m256i two8i{_mm256_set1_epi32(2)};
+    const __m256 fracOne8{_mm256_set1_ps(1.0f/MixerFracOne)};
+    const __m256 half8{_mm256_set1_ps(0.5f)};
+    const __m256 nhalf8{_mm256_set1_ps(-0.5f)};
+    const __m256 one8{_mm256_set1_ps(1.0f)};
+    const __m256 onehalf8{_mm256_set1_ps(1.5f)};
+    const __m256 nonehalf8{_mm256_set1_ps(-1.5f)};
+    const __m256 two8{_mm256_set1_ps(2.0f)};
+    const __m256 ntwohalf8{_mm256_set1_ps(-2.5f)};
+
+    __m256i offset8{_mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(offset)),
+        _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7))};
+
+    size_t i{0};
+    for(size_t count{todo>>3};count;--count)
+    {
+        const __m256i delays8{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(delays+i))};
+
+        /* The delay line wraps around, so each sample index is masked. */
+        const __m256i pos8{_mm256_sub_epi32(offset8, _mm256_srli_epi32(delays8,
+            MixerFracBits))};
+        const __m256i pos1{_mm256_and_si256(_mm256_add_epi32(pos8, one8i), bufMask8)};
+        const __m256i pos2{_mm256_and_si256(pos8, bufMask8)};
+        const __m256i pos3{_mm256_and_si256(_mm256_sub_epi32(pos8, one8i), bufMask8)};
+        const __m256i pos4{_mm256_and_si256(_mm256_sub_epi32(pos8, two8i), bufMask8)};
+        const __m256 val1{_mm256_i32gather_ps(delaybuf, pos1, 4)};
+        const __m256 val2{_mm256_i32gather_ps(delaybuf, pos2, 4)};
+        const __m256 val3{_mm256_i32gather_ps(delaybuf, pos3, 4)};
+        const __m256 val4{_mm256_i32gather_ps(delaybuf, pos4, 4)};
+
+        const __m256 mu{_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(delays8, fracMask8)),
+            fracOne8)};
+        const __m256 mu2{_mm256_mul_ps(mu, mu)};
+        const __m256 mu3{_mm256_mul_ps(mu2, mu)};
+
+        const __m256 a0{_mm256_fmadd_ps(nhalf8, mu3, _mm256_fmadd_ps(nhalf8, mu, mu2))};
+        const __m256 a1{_mm256_fmadd_ps(onehalf8, mu3, _mm256_fmadd_ps(ntwohalf8, mu2, one8))};
+        const __m256 a2{_mm256_fmadd_ps(nonehalf8, mu3,
+            _mm256_fmadd_ps(two8, mu2, _mm256_mul_ps(half8, mu)))};
+        const __m256 a3{_mm256_mul_ps(half8, _mm256_sub_ps(mu3, mu2))};
+
+        __m256 out{_mm256_mul_ps(val1, a0)};
+        out = _mm256_fmadd_ps(val2, a1, out);
+        out = _mm256_fmadd_ps(val3, a2, out);
+        out = _mm256_fmadd_ps(val4, a3, out);
+        _mm256_storeu_ps(&dst[i], out);
+
+        offset8 = _mm256_add_epi32(offset8, eight8);
+        i += 8;
+    }
+    for(;i < todo;++i)
+    {
+        const uint delay{offset + static_cast<uint>(i) - (delays[i]>>MixerFracBits)};
+        const float mu{static_cast<float>(delays[i]&MixerFracMask) * (1.0f/MixerFracOne)};
+        dst[i] = cubic(delaybuf[(delay+1) & bufmask], delaybuf[(delay  ) & bufmask],
+            delaybuf[(delay-1) & bufmask], delaybuf[(delay-2) & bufmask], mu);
+    }
+}
+
+#ifdef POP_CLANG_TARGET
+#pragma clang attribute pop
+#endif
@@ -198,3 +198,39 @@ void Mix_<CTag>(const al::span<const float> InSamples, const al::span<FloatBuffe
             dst[pos] += InSamples[pos] * gain;
     }
 }
+
+
+template<>
+void ModDelayTriangle_<CTag>(uint *delays, const uint offset, const float scale,
+    const float depth, const int delay, const size_t todo)
+{
+    for(size_t i{0};i < todo;++i)
+    {
+        const float offset_norm{static_cast<float>(offset+i) * scale};
+        delays[i] = static_cast<uint>(fastf2i((1.0f-std::abs(2.0f-offset_norm)) * depth) + delay);
+    }
+}
+
+template<>
+void ModDelaySinusoid_<CTag>(uint *delays, const uint offset, const float scale,
+    const float depth, const int delay, const size_t todo)
+{
+    for(size_t i{0};i < todo;++i)
+    {
+        const float offset_norm{static_cast<float>(offset+i) * scale};
+        delays[i] = static_cast<uint>(fastf2i(std::sin(offset_norm)*depth) + delay);
+    }
+}
+
+template<>
+void ModDelayTaps_<CTag>(const float *delaybuf, const size_t bufmask, const uint offset,
+    const uint *delays, float *dst, const size_t todo)
+{
+    for(size_t i{0};i < todo;++i)
+    {
+        const uint delay{offset + static_cast<uint>(i) - (delays[i]>>MixerFracBits)};
+        const float mu{static_cast<float>(delays[i]&MixerFracMask) * (1.0f/MixerFracOne)};
+        dst[i] = cubic(delaybuf[(delay+1) & bufmask], delaybuf[(delay  ) & bufmask],
+            delaybuf[(delay-1) & bufmask], delaybuf[(delay-2) & bufmask], mu);
+    }
+}
@@ -2,13 +2,16 @@
 
 #include <arm_neon.h>
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 
+#include "alnumbers.h"
 #include "alnumeric.h"
 #include "core/bsinc_defs.h"
 #include "defs.h"
 #include "hrtfbase.h"
+#include "opthelpers.h"
 
 struct NEONTag;
 struct LerpTag;
@@ -305,3 +308,175 @@ void Mix_<NEONTag>(const al::span<const float> InSamples, const al::span<FloatBu
             dst[pos] += InSamples[pos] * gain;
     }
 }
+
+
+namespace {
+
+/* Approximates sin(x) for 0 <= x <= 2pi, the same way as the SSE2 version. */
+inline float32x4_t sin_f4(const float32x4_t x)
+{
+    const float32x4_t pi4{vdupq_n_f32(al::numbers::pi_v<float>)};
+    const float32x4_t npi4{vdupq_n_f32(-al::numbers::pi_v<float>)};
+
+    const float32x4_t y{vsubq_f32(x, pi4)};
+    float32x4_t t{vminq_f32(y, vsubq_f32(pi4, y))};
+    t = vmaxq_f32(t, vsubq_f32(npi4, t));
+
+    const float32x4_t t2{vmulq_f32(t, t)};
+    float32x4_t r{vdupq_n_f32(-1.0f/39916800.0f)};
+    r = vmlaq_f32(vdupq_n_f32(1.0f/362880.0f), r, t2);
+    r = vmlaq_f32(vdupq_n_f32(-1.0f/5040.0f), r, t2);
+    r = vmlaq_f32(vdupq_n_f32(1.0f/120.0f), r, t2);
+    r = vmlaq_f32(vdupq_n_f32(-1.0f/6.0f), r, t2);
+    r = vmlaq_f32(vdupq_n_f32(1.0f), r, t2);
+    return vmulq_f32(r, vnegq_f32(t));
+}
+
+/* Converts to integer, rounding to nearest like fastf2i. */
+inline int32x4_t round_s4(const float32x4_t v)
+{
+    const uint32x4_t signmask{vdupq_n_u32(0x80000000u)};
+    const uint32x4_t half{vreinterpretq_u32_f32(vdupq_n_f32(0.5f))};
+    const float32x4_t bias{vreinterpretq_f32_u32(vorrq_u32(half,
+        vandq_u32(vreinterpretq_u32_f32(v), signmask)))};
+    return vcvtq_s32_f32(vaddq_f32(v, bias));
+}
+
+template<typename F>
+inline void GenModDelays(uint *delays, const uint offset, const int delay, const size_t todo,
+    F calc_lfo)
+{
+    const int32x4_t delay4{vdupq_n_s32(delay)};
+    const int32x4_t four4{vdupq_n_s32(4)};
+    alignas(16) static constexpr int iota[4]{0, 1, 2, 3};
+    int32x4_t offset4{vaddq_s32(vdupq_n_s32(static_cast<int>(offset)), vld1q_s32(iota))};
+
+    size_t i{0};
+    for(size_t count{todo>>2};count;--count)
+    {
+        const int32x4_t delays4{vaddq_s32(round_s4(calc_lfo(offset4)), delay4)};
+        vst1q_s32(reinterpret_cast<int*>(delays+i), delays4);
+        offset4 = vaddq_s32(offset4, four4);
+        i += 4;
+    }
+    if(const size_t rem{todo&3})
+    {
+        alignas(16) uint vals[4];
+        vst1q_s32(reinterpret_cast<int*>(vals), vaddq_s32(round_s4(calc_lfo(offset4)), delay4));
+        std::copy_n(vals, rem, delays+i);
+    }
+}
+
+} // namespace
+
+template<>
+void ModDelayTriangle_<NEONTag>(uint *delays, const uint offset, const float scale,
+    const float depth, const int delay, const size_t todo)
+{
+    const float32x4_t scale4{vdupq_n_f32(scale)};
+    const float32x4_t depth4{vdupq_n_f32(depth)};
+    const float32x4_t one4{vdupq_n_f32(1.0f)};
+    const float32x4_t two4{vdupq_n_f32(2.0f)};
+
+    GenModDelays(delays, offset, delay, todo,
+        [=](const int32x4_t offset4) -> float32x4_t
+        {
+            const float32x4_t offset_norm{vmulq_f32(vcvtq_f32_s32(offset4), scale4)};
+            const float32x4_t tri{vsubq_f32(one4, vabsq_f32(vsubq_f32(two4, offset_norm)))};
+            return vmulq_f32(tri, depth4);
+        });
+}
+
+template<>
+void ModDelaySinusoid_<NEONTag>(uint *delays, const uint offset, const float scale,
+    const float depth, const int delay, const size_t todo)
+{
+    const float32x4_t scale4{vdupq_n_f32(scale)};
+    const float32x4_t depth4{vdupq_n_f32(depth)};
+
+    GenModDelays(delays, offset, delay, todo,
+        [=](const int32x4_t offset4) -> float32x4_t
+        {
+            const float32x4_t offset_norm{vmulq_f32(vcvtq_f32_s32(offset4), scale4)};
+            return vmulq_f32(sin_f4(offset_norm), depth4);
+        });
+}
+
+template<>
+void ModDelayTaps_<NEONTag>(const float *delaybuf, const size_t bufmask, const uint offset,
+    const uint *delays, float *dst, const size_t todo)
+{
+    const uint32x4_t fracMask4{vdupq_n_u32(MixerFracMask)};
+    const float32x4_t fracOne4{vdupq_n_f32(1.0f/MixerFracOne)};
+    const float32x4_t half4{vdupq_n_f32(0.5f)};
+    const float32x4_t nhalf4{vdupq_n_f32(-0.5f)};
+    const float32x4_t one4{vdupq_n_f32(1.0f)};
+    const float32x4_t onehalf4{vdupq_n_f32(1.5f)};
+    const float32x4_t nonehalf4{vdupq_n_f32(-1.5f)};
+    const float32x4_t two4{vdupq_n_f32(2.0f)};
+    const float32x4_t ntwohalf4{vdupq_n_f32(-2.5f)};
+
+    /* Loads the four samples around a tap, starting with the oldest. They're
+     * contiguous unless the tap straddles the end of the delay line.
+     */
+    auto load_tap = [delaybuf,bufmask](const size_t pos) -> float32x4_t
+    {
+        const size_t pos0{(pos-2) & bufmask};
+        if LIKELY(pos0 <= bufmask-3)
+            return vld1q_f32(&delaybuf[pos0]);
+        return set_f4(delaybuf[pos0], delaybuf[(pos0+1)&bufmask], delaybuf[(pos0+2)&bufmask],
+            delaybuf[(pos0+3)&bufmask]);
+    };
+
+    size_t i{0};
+    for(size_t count{todo>>2};count;--count)
+    {
+        const uint32x4_t delays4{vld1q_u32(delays+i)};
+        const uint pos{offset + static_cast<uint>(i)};
+
+        const float32x4_t tap0{load_tap(pos   - (delays[i  ]>>MixerFracBits))};
+        const float32x4_t tap1{load_tap(pos+1 - (delays[i+1]>>MixerFracBits))};
+        const float32x4_t tap2{load_tap(pos+2 - (delays[i+2]>>MixerFracBits))};
+        const float32x4_t tap3{load_tap(pos+3 - (delays[i+3]>>MixerFracBits))};
+
+        /* Transpose the taps so each vector holds one sample of each tap. */
+        const float32x4x2_t t01{vtrnq_f32(tap0, tap1)};
+        const float32x4x2_t t23{vtrnq_f32(tap2, tap3)};
+        const float32x4_t val4{vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]))};
+        const float32x4_t val3{vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]))};
+        const float32x4_t val2{vcombine_f32(vget_high_f32(t01.val[0]),
+            vget_high_f32(t23.val[0]))};
+        const float32x4_t val1{vcombine_f32(vget_high_f32(t01.val[1]),
+            vget_high_f32(t23.val[1]))};
+
+        const float32x4_t mu{vmulq_f32(vcvtq_f32_u32(vandq_u32(delays4, fracMask4)), fracOne4)};
+        const float32x4_t mu2{vmulq_f32(mu, mu)};
+        const float32x4_t mu3{vmulq_f32(mu2, mu)};
+
+        /* a0 = -0.5*mu3 +     mu2 + -0.5*mu
+         * a1 =  1.5*mu3 + -2.5*mu2          + 1
+         * a2 = -1.5*mu3 +  2.0*mu2 +  0.5*mu
+         * a3 =  0.5*mu3 + -0.5*mu2
+         */
+        const float32x4_t a0{vmlaq_f32(vmlaq_f32(mu2, nhalf4, mu), nhalf4, mu3)};
+        const float32x4_t a1{vmlaq_f32(vmlaq_f32(one4, ntwohalf4, mu2), onehalf4, mu3)};
+        const float32x4_t a2{vmlaq_f32(vmlaq_f32(vmulq_f32(half4, mu), two4, mu2), nonehalf4,
+            mu3)};
+        const float32x4_t a3{vmulq_f32(half4, vsubq_f32(mu3, mu2))};
+
+        float32x4_t out{vmulq_f32(val1, a0)};
+        out = vmlaq_f32(out, val2, a1);
+        out = vmlaq_f32(out, val3, a2);
+        out = vmlaq_f32(out, val4, a3);
+        vst1q_f32(&dst[i], out);
+
+        i += 4;
+    }
+    for(;i < todo;++i)
+    {
+        const uint delay{offset + static_cast<uint>(i) - (delays[i]>>MixerFracBits)};
+        const float mu{static_cast<float>(delays[i]&MixerFracMask) * (1.0f/MixerFracOne)};
+        dst[i] = cubic(delaybuf[(delay+1) & bufmask], delaybuf[(delay  ) & bufmask],
+            delaybuf[(delay-1) & bufmask], delaybuf[(delay-2) & bufmask], mu);
+    }
+}
@@ -23,8 +23,12 @@
 #include <xmmintrin.h>
 #include <emmintrin.h>
 
+#include <algorithm>
+
+#include "alnumbers.h"
 #include "alnumeric.h"
 #include "defs.h"
+#include "opthelpers.h"
 
 struct SSE2Tag;
 struct LerpTag;
@@ -87,3 +91,167 @@ float *Resample_<LerpTag,SSE2Tag>(const InterpState*, float *RESTRICT src, uint
     }
     return dst.data();
 }
+
+
+namespace {
+
+/* Approximates sin(x) for 0 <= x <= 2pi. The input is shifted to -pi...+pi,
+ * then folded to -pi/2...+pi/2 where an 11th order Taylor polynomial is
+ * accurate to within float precision.
+ */
+inline __m128 sin_ps(const __m128 x)
+{
+    const __m128 pi4{_mm_set1_ps(al::numbers::pi_v<float>)};
+    const __m128 npi4{_mm_set1_ps(-al::numbers::pi_v<float>)};
+
+    /* sin(x) = -sin(x - pi) */
+    const __m128 y{_mm_sub_ps(x, pi4)};
+    /* sin(y) = sin(pi - y) = sin(-pi - y) */
+    __m128 t{_mm_min_ps(y, _mm_sub_ps(pi4, y))};
+    t = _mm_max_ps(t, _mm_sub_ps(npi4, t));
+
+    const __m128 t2{_mm_mul_ps(t, t)};
+    __m128 r{_mm_set1_ps(-1.0f/39916800.0f)};
+    r = _mm_add_ps(_mm_mul_ps(r, t2), _mm_set1_ps(1.0f/362880.0f));
+    r = _mm_add_ps(_mm_mul_ps(r, t2), _mm_set1_ps(-1.0f/5040.0f));
+    r = _mm_add_ps(_mm_mul_ps(r, t2), _mm_set1_ps(1.0f/120.0f));
+    r = _mm_add_ps(_mm_mul_ps(r, t2), _mm_set1_ps(-1.0f/6.0f));
+    r = _mm_add_ps(_mm_mul_ps(r, t2), _mm_set1_ps(1.0f));
+    return _mm_mul_ps(r, _mm_sub_ps(_mm_setzero_ps(), t));
+}
+
+template<typename F>
+inline void GenModDelays(uint *delays, const uint offset, const int delay, const size_t todo,
+    F calc_lfo)
+{
+    const __m128i delay4{_mm_set1_epi32(delay)};
+    const __m128i four4{_mm_set1_epi32(4)};
+    __m128i offset4{_mm_add_epi32(_mm_set1_epi32(static_cast<int>(offset)),
+        _mm_setr_epi32(0, 1, 2, 3))};
+
+    size_t i{0};
+    for(size_t count{todo>>2};count;--count)
+    {
+        const __m128i delays4{_mm_add_epi32(_mm_cvtps_epi32(calc_lfo(offset4)), delay4)};
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(delays+i), delays4);
+        offset4 = _mm_add_epi32(offset4, four4);
+        i += 4;
+    }
+    if(const size_t rem{todo&3})
+    {
+        alignas(16) uint vals[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(vals),
+            _mm_add_epi32(_mm_cvtps_epi32(calc_lfo(offset4)), delay4));
+        std::copy_n(vals, rem, delays+i);
+    }
+}
+
+} // namespace
+
+template<>
+void ModDelayTriangle_<SSE2Tag>(uint *delays, const uint offset, const float scale,
+    const float depth, const int delay, const size_t todo)
+{
+    const __m128 scale4{_mm_set1_ps(scale)};
+    const __m128 depth4{_mm_set1_ps(depth)};
+    const __m128 one4{_mm_set1_ps(1.0f)};
+    const __m128 two4{_mm_set1_ps(2.0f)};
+    const __m128 absmask4{_mm_castsi128_ps(_mm_set1_epi32(0x7fffffff))};
+
+    GenModDelays(delays, offset, delay, todo,
+        [=](const __m128i offset4) -> __m128
+        {
+            const __m128 offset_norm{_mm_mul_ps(_mm_cvtepi32_ps(offset4), scale4)};
+            const __m128 tri{_mm_sub_ps(one4, _mm_and_ps(_mm_sub_ps(two4, offset_norm),
+                absmask4))};
+            return _mm_mul_ps(tri, depth4);
+        });
+}
+
+template<>
+void ModDelaySinusoid_<SSE2Tag>(uint *delays, const uint offset, const float scale,
+    const float depth, const int delay, const size_t todo)
+{
+    const __m128 scale4{_mm_set1_ps(scale)};
+    const __m128 depth4{_mm_set1_ps(depth)};
+
+    GenModDelays(delays, offset, delay, todo,
+        [=](const __m128i offset4) -> __m128
+        {
+            const __m128 offset_norm{_mm_mul_ps(_mm_cvtepi32_ps(offset4), scale4)};
+            return _mm_mul_ps(sin_ps(offset_norm), depth4);
+        });
+}
+
+template<>
+void ModDelayTaps_<SSE2Tag>(const float *delaybuf, const size_t bufmask, const uint offset,
+    const uint *delays, float *dst, const size_t todo)
+{
+    const __m128i fracMask4{_mm_set1_epi32(MixerFracMask)};
+    const __m128 fracOne4{_mm_set1_ps(1.0f/MixerFracOne)};
+    const __m128 half4{_mm_set1_ps(0.5f)};
+    const __m128 nhalf4{_mm_set1_ps(-0.5f)};
+    const __m128 one4{_mm_set1_ps(1.0f)};
+    const __m128 onehalf4{_mm_set1_ps(1.5f)};
+    const __m128 nonehalf4{_mm_set1_ps(-1.5f)};
+    const __m128 two4{_mm_set1_ps(2.0f)};
+    const __m128 ntwohalf4{_mm_set1_ps(-2.5f)};
+
+    /* Loads the four samples around a tap, starting with the oldest. They're
+     * contiguous unless the tap straddles the end of the delay line.
+     */
+    auto load_tap = [delaybuf,bufmask](const size_t pos) -> __m128
+    {
+        const size_t pos0{(pos-2) & bufmask};
+        if LIKELY(pos0 <= bufmask-3)
+            return _mm_loadu_ps(&delaybuf[pos0]);
+        return _mm_setr_ps(delaybuf[pos0], delaybuf[(pos0+1)&bufmask],
+            delaybuf[(pos0+2)&bufmask], delaybuf[(pos0+3)&bufmask]);
+    };
+
+    size_t i{0};
+    for(size_t count{todo>>2};count;--count)
+    {
+        const __m128i delays4{_mm_loadu_si128(reinterpret_cast<const __m128i*>(delays+i))};
+        const uint pos{offset + static_cast<uint>(i)};
+
+        __m128 val4{load_tap(pos   - (delays[i  ]>>MixerFracBits))};
+        __m128 val3{load_tap(pos+1 - (delays[i+1]>>MixerFracBits))};
+        __m128 val2{load_tap(pos+2 - (delays[i+2]>>MixerFracBits))};
+        __m128 val1{load_tap(pos+3 - (delays[i+3]>>MixerFracBits))};
+        _MM_TRANSPOSE4_PS(val4, val3, val2, val1);
+
+        const __m128 mu{_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(delays4, fracMask4)),
+            fracOne4)};
+        const __m128 mu2{_mm_mul_ps(mu, mu)};
+        const __m128 mu3{_mm_mul_ps(mu2, mu)};
+
+        /* a0 = -0.5*mu3 +     mu2 + -0.5*mu
+         * a1 =  1.5*mu3 + -2.5*mu2          + 1
+         * a2 = -1.5*mu3 +  2.0*mu2 +  0.5*mu
+         * a3 =  0.5*mu3 + -0.5*mu2
+         */
+        const __m128 a0{_mm_add_ps(_mm_add_ps(_mm_mul_ps(nhalf4, mu3), mu2),
+            _mm_mul_ps(nhalf4, mu))};
+        const __m128 a1{_mm_add_ps(_mm_add_ps(_mm_mul_ps(onehalf4, mu3),
+            _mm_mul_ps(ntwohalf4, mu2)), one4)};
+        const __m128 a2{_mm_add_ps(_mm_add_ps(_mm_mul_ps(nonehalf4, mu3),
+            _mm_mul_ps(two4, mu2)), _mm_mul_ps(half4, mu))};
+        const __m128 a3{_mm_add_ps(_mm_mul_ps(half4, mu3), _mm_mul_ps(nhalf4, mu2))};
+
+        __m128 out{_mm_mul_ps(val1, a0)};
+        out = _mm_add_ps(out, _mm_mul_ps(val2, a1));
+        out = _mm_add_ps(out, _mm_mul_ps(val3, a2));
+        out = _mm_add_ps(out, _mm_mul_ps(val4, a3));
+        _mm_storeu_ps(&dst[i], out);
+
+        i += 4;
+    }
+    for(;i < todo;++i)
+    {
+        const uint delay{offset + static_cast<uint>(i) - (delays[i]>>MixerFracBits)};
+        const float mu{static_cast<float>(delays[i]&MixerFracMask) * (1.0f/MixerFracOne)};
+        dst[i] = cubic(delaybuf[(delay+1) & bufmask], delaybuf[(delay  ) & bufmask],
+            delaybuf[(delay-1) & bufmask], delaybuf[(delay-2) & bufmask], mu);
+    }
+}
@@ -0,0 +1,165 @@
+#include "config.h"
+
+#include "mixer_pool.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "alnumeric.h"
+#include "fpu_ctrl.h"
+#include "helpers.h"
+#include "logging.h"
+#include "opthelpers.h"
+
+
+MixerWorkerPool::Worker::Worker(size_t numlines) : mBusLines(numlines)
+{
+    mScratch.mHrtfAccumData = mHrtfAccumData.data();
+}
+
+
+MixerWorkerPool::MixerWorkerPool(size_t numthreads, size_t numlines)
+{
+    mWorkers.reserve(numthreads);
+    for(size_t i{0};i < numthreads;++i)
+        mWorkers.emplace_back(std::make_unique<Worker>(numlines));
+
+    try {
+        for(size_t i{0};i < mWorkers.size();++i)
+            mWorkers[i]->mThread = std::thread{std::mem_fn(&MixerWorkerPool::workerProc), this,
+                mWorkers[i].get(), i+1};
+    }
+    catch(std::exception& e) {
+        ERR("Failed to start mixer worker thread: %s\n", e.what());
+        /* Keep the workers that did start. */
+        auto iter = std::find_if(mWorkers.begin(), mWorkers.end(),
+            [](const std::unique_ptr<Worker> &worker) noexcept -> bool
+            { return !worker->mThread.joinable(); });
+        mWorkers.erase(iter, mWorkers.end());
+    }
+    TRACE("Started %zu mixer worker thread%s (%zu partial lines each)\n", mWorkers.size(),
+        (mWorkers.size()==1) ? "" : "s", numlines);
+}
+
+MixerWorkerPool::~MixerWorkerPool()
+{
+    mQuit.store(true, std::memory_order_release);
+    for(auto &worker : mWorkers)
+    {
+        worker->mSem.post();
+        worker->mThread.join();
+    }
+}
+
+
+FORCE_ALIGN void MixerWorkerPool::workerProc(Worker *self, size_t index)
+{
+    SetRTPriority();
+    althrd_setname(MIXER_WORKER_THREAD_NAME);
+
+    FPUCtl mixer_mode{};
+    while(true)
+    {
+        self->mSem.wait();
+        if(mQuit.load(std::memory_order_acquire))
+            break;
+
+        mTask(mTaskData, index, self->mScratch);
+        mDoneSem.post();
+    }
+}
+
+
+bool MixerWorkerPool::mapBuses(const al::span<const al::span<FloatBufferLine>> targets,
+    const size_t count, const uint samplesToDo)
+{
+    if(targets.size() > std::tuple_size<decltype(Worker::mBusMap)>::value)
+        return false;
+
+    size_t numlines{0};
+    for(const auto &target : targets)
+        numlines += target.size();
+    if(mWorkers.empty() || numlines > mWorkers.front()->mBusLines.size())
+        return false;
+
+    const size_t numworkers{minz(count, mWorkers.size()+1) - 1};
+    for(size_t i{0};i < numworkers;++i)
+    {
+        Worker *worker{mWorkers[i].get()};
+        FloatBufferLine *partial{worker->mBusLines.data()};
+
+        auto busmap = worker->mBusMap.begin();
+        for(const auto &target : targets)
+        {
+            busmap->mTarget = target.data();
+            busmap->mPartial = partial;
+            busmap->mCount = target.size();
+            busmap->mInUse = false;
+            partial += target.size();
+            ++busmap;
+        }
+        worker->mScratch.mBusMap = {worker->mBusMap.data(), targets.size()};
+        worker->mScratch.mSamplesToDo = samplesToDo;
+    }
+    return true;
+}
+
+void MixerWorkerPool::reduceBuses(const size_t count, float2 *hrtfAccum, const uint samplesToDo)
+{
+    ASSUME(samplesToDo > 0);
+
+    const size_t numworkers{minz(count, mWorkers.size()+1) - 1};
+    for(size_t i{0};i < numworkers;++i)
+    {
+        MixerScratch &scratch = mWorkers[i]->mScratch;
+        for(MixerScratch::BusMapping &bus : scratch.mBusMap)
+        {
+            if(!bus.mInUse) continue;
+            bus.mInUse = false;
+
+            for(size_t c{0};c < bus.mCount;++c)
+            {
+                const float *RESTRICT src{bus.mPartial[c].data()};
+                float *RESTRICT dst{bus.mTarget[c].data()};
+                std::transform(src, src+samplesToDo, dst, dst, std::plus<float>{});
+            }
+        }
+        scratch.mBusMap = {};
+
+        if(scratch.mHrtfAccumUsed)
+        {
+            /* Voices mixed with HRTF write up to HrirLength samples past the
+             * end of the update, which gets carried over to the next.
+             */
+            float2 *src{scratch.mHrtfAccumData};
+            const size_t total{samplesToDo + size_t{HrirLength}};
+            for(size_t j{0};j < total;++j)
+            {
+                hrtfAccum[j][0] += src[j][0];
+                hrtfAccum[j][1] += src[j][1];
+            }
+            std::fill_n(src, total, float2{});
+            scratch.mHrtfAccumUsed = false;
+        }
+    }
+}
+
+
+void MixerWorkerPool::execute(const size_t count, MixerScratch &scratch, TaskFunc task,
+    void *userdata)
+{
+    const size_t numworkers{minz(count, mWorkers.size()+1) - 1};
+
+    mTask = task;
+    mTaskData = userdata;
+    /* Posting the semaphore provides the necessary synchronization for the
+     * workers to see the task.
+     */
+    for(size_t i{0};i < numworkers;++i)
+        mWorkers[i]->mSem.post();
+
+    task(userdata, 0, scratch);
+
+    for(size_t i{0};i < numworkers;++i)
+        mDoneSem.wait();
+}
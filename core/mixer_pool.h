@@ -0,0 +1,118 @@
+#ifndef CORE_MIXER_POOL_H
+#define CORE_MIXER_POOL_H
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+#include <thread>
+#include <type_traits>
+
+#include "almalloc.h"
+#include "alspan.h"
+#include "bufferline.h"
+#include "device.h"
+#include "mixer/hrtfdefs.h"
+#include "threads.h"
+#include "vector.h"
+
+
+/* Must be less than 15 characters (16 including terminating null) for
+ * compatibility with pthread_setname_np limitations. */
+#define MIXER_WORKER_THREAD_NAME "alsoft-mixwork"
+
+/* The maximum number of effect slot buses the worker threads can hold partial
+ * mixes for. Contexts with more active effect slots mix their voices on the
+ * mixer thread alone.
+ */
+constexpr size_t MaxWorkerSlotBuses{16};
+
+/* The maximum number of threads to mix with, including the mixer thread. */
+constexpr uint MaxMixerThreads{16};
+
+
+/**
+ * A pool of threads the mixer can spread its work over. The calling (mixer)
+ * thread always handles the first part of the work itself, so a pool with N
+ * threads processes up to N+1 parts at once.
+ *
+ * Each worker has its own scratch storage for mixing voices, along with
+ * partial mixing buffers for the device and effect slot outputs, which get
+ * summed back into the real outputs by the mixer thread.
+ */
+class MixerWorkerPool {
+public:
+    using TaskFunc = void(*)(void *userdata, size_t index, MixerScratch &scratch);
+
+private:
+    struct Worker {
+        std::thread mThread;
+        al::semaphore mSem;
+
+        MixerScratch mScratch;
+        alignas(16) std::array<float2,BufferLineSize+HrirLength> mHrtfAccumData{};
+
+        al::vector<FloatBufferLine,16> mBusLines;
+        std::array<MixerScratch::BusMapping,MaxWorkerSlotBuses+2> mBusMap{};
+
+        Worker(size_t numlines);
+
+        DEF_NEWDEL(Worker)
+    };
+    al::vector<std::unique_ptr<Worker>> mWorkers;
+
+    al::semaphore mDoneSem;
+    std::atomic<bool> mQuit{false};
+
+    TaskFunc mTask{nullptr};
+    void *mTaskData{nullptr};
+
+    void workerProc(Worker *self, size_t index);
+
+public:
+    MixerWorkerPool(size_t numthreads, size_t numlines);
+    MixerWorkerPool(const MixerWorkerPool&) = delete;
+    ~MixerWorkerPool();
+
+    MixerWorkerPool& operator=(const MixerWorkerPool&) = delete;
+
+    /** Returns the number of worker threads, not counting the caller. */
+    size_t size() const noexcept { return mWorkers.size(); }
+
+    /**
+     * Sets up the workers to mix into partial buffers for the given output
+     * buffers, for the first count-1 workers. Returns false if the partial
+     * buffers aren't big enough to hold all the outputs.
+     */
+    bool mapBuses(const al::span<const al::span<FloatBufferLine>> targets, const size_t count,
+        const uint samplesToDo);
+
+    /**
+     * Adds the partial mixes of the first count-1 workers to the real output
+     * buffers, in worker order so the result is deterministic for a given
+     * number of parts.
+     */
+    void reduceBuses(const size_t count, float2 *hrtfAccum, const uint samplesToDo);
+
+    /**
+     * Calls the task function for each index in [0...count), with count no
+     * more than size()+1. Index 0 is called on the calling thread with the
+     * given scratch storage, while the rest are called on worker threads with
+     * their own. Returns once all calls have completed.
+     */
+    void execute(const size_t count, MixerScratch &scratch, TaskFunc task, void *userdata);
+
+    template<typename F>
+    void execute(const size_t count, MixerScratch &scratch, F&& func)
+    {
+        using FuncType = std::remove_reference_t<F>;
+        execute(count, scratch,
+            [](void *userdata, size_t index, MixerScratch &s) -> void
+            { (*static_cast<FuncType*>(userdata))(index, s); },
+            &func);
+    }
+
+    DEF_NEWDEL(MixerWorkerPool)
+};
+
+#endif /* CORE_MIXER_POOL_H */
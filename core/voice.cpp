@@ -7,11 +7,14 @@
 #include <array>
 #include <atomic>
 #include <cassert>
+#include <cmath>
 #include <cstdint>
 #include <iterator>
+#include <limits>
 #include <memory>
 #include <new>
 #include <stdlib.h>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -27,6 +30,7 @@
 #include "cpu_caps.h"
 #include "devformat.h"
 #include "device.h"
+#include "effectslot.h"
 #include "filters/biquad.h"
 #include "filters/nfc.h"
 #include "filters/splitter.h"
@@ -45,14 +49,17 @@ struct CTag;
 #ifdef HAVE_SSE
 struct SSETag;
 #endif
+#ifdef HAVE_AVX2
+struct AVX2Tag;
+#endif
 #ifdef HAVE_NEON
 struct NEONTag;
 #endif
 struct CopyTag;
 
 
-static_assert(!(sizeof(DeviceBase::MixerBufferLine)&15),
-    "DeviceBase::MixerBufferLine must be a multiple of 16 bytes");
+static_assert(!(sizeof(MixerScratch::MixerBufferLine)&15),
+    "MixerScratch::MixerBufferLine must be a multiple of 16 bytes");
 static_assert(!(MaxResamplerEdge&3), "MaxResamplerEdge is not a multiple of 4");
 
 Resampler ResamplerDefault{Resampler::Linear};
@@ -66,6 +73,9 @@ using HrtfMixerFunc = void(*)(const float *InSamples, float2 *AccumSamples, cons
 using HrtfMixerBlendFunc = void(*)(const float *InSamples, float2 *AccumSamples,
     const uint IrSize, const HrtfFilter *oldparams, const MixHrtfFilter *newparams,
     const size_t BufferSize);
+using LoadResamplerFunc = float*(*)(const ResamplerFunc resample, const InterpState *state,
+    const al::byte *src, const size_t srcStep, float *history, uint frac, const uint increment,
+    const al::span<float> dst);
 
 HrtfMixerFunc MixHrtfSamples{MixHrtf_<CTag>};
 HrtfMixerBlendFunc MixHrtfBlendSamples{MixHrtfBlend_<CTag>};
@@ -76,6 +86,10 @@ inline MixerFunc SelectMixer()
     if((CPUCapFlags&CPU_CAP_NEON))
         return Mix_<NEONTag>;
 #endif
+#ifdef HAVE_AVX2
+    if((CPUCapFlags&CPU_CAP_AVX2))
+        return Mix_<AVX2Tag>;
+#endif
 #ifdef HAVE_SSE
     if((CPUCapFlags&CPU_CAP_SSE))
         return Mix_<SSETag>;
@@ -89,6 +103,10 @@ inline HrtfMixerFunc SelectHrtfMixer()
     if((CPUCapFlags&CPU_CAP_NEON))
         return MixHrtf_<NEONTag>;
 #endif
+#ifdef HAVE_AVX2
+    if((CPUCapFlags&CPU_CAP_AVX2))
+        return MixHrtf_<AVX2Tag>;
+#endif
 #ifdef HAVE_SSE
     if((CPUCapFlags&CPU_CAP_SSE))
         return MixHrtf_<SSETag>;
@@ -102,6 +120,10 @@ inline HrtfMixerBlendFunc SelectHrtfBlendMixer()
     if((CPUCapFlags&CPU_CAP_NEON))
         return MixHrtfBlend_<NEONTag>;
 #endif
+#ifdef HAVE_AVX2
+    if((CPUCapFlags&CPU_CAP_AVX2))
+        return MixHrtfBlend_<AVX2Tag>;
+#endif
 #ifdef HAVE_SSE
     if((CPUCapFlags&CPU_CAP_SSE))
         return MixHrtfBlend_<SSETag>;
@@ -224,9 +246,84 @@ inline void LoadSamples(const al::span<float*> dstSamples, const size_t dstOffse
     }
 }
 
+/* Compressed samples are decoded forward from each channel's last position
+ * when possible, taking any samples loaded again from the kept tail. Anything
+ * else (a seek, loop, or different buffer) decodes from the start of the block
+ * containing the first sample.
+ */
+void LoadAdpcmChannel(float *dst, const al::byte *src, const size_t srcChan, size_t srcOffset,
+    const FmtType srcType, const size_t srcStep, const size_t samplesPerBlock, size_t samples,
+    Voice::AdpcmChannel &chan) noexcept
+{
+    if(chan.mSrc != src)
+    {
+        chan.mSrc = src;
+        chan.mState = al::AdpcmState{};
+        chan.mTailLen = 0;
+    }
+    else if(srcOffset < chan.mState.mPos && chan.mState.mPos-srcOffset <= chan.mTailLen)
+    {
+        const size_t back{chan.mState.mPos - srcOffset};
+        const size_t todo{minz(back, samples)};
+        std::copy_n(chan.mTail.end()-back, todo, dst);
+        dst += todo;
+        srcOffset += todo;
+        samples -= todo;
+        if(!samples) return;
+    }
+
+    const bool contiguous{srcOffset == chan.mState.mPos};
+    if(srcType == FmtIMA4)
+        al::LoadIMA4Array(dst, src, srcChan, srcOffset, srcStep, samplesPerBlock, samples,
+            chan.mState);
+    else
+        al::LoadMSADPCMArray(dst, src, srcChan, srcOffset, srcStep, samplesPerBlock, samples,
+            chan.mState);
+
+    /* Keep the last decoded samples for the next load. */
+    auto &tail = chan.mTail;
+    if(samples >= tail.size())
+    {
+        std::copy_n(dst+samples-tail.size(), tail.size(), tail.begin());
+        chan.mTailLen = tail.size();
+    }
+    else
+    {
+        std::copy(tail.begin()+samples, tail.end(), tail.begin());
+        std::copy_n(dst, samples, tail.end()-samples);
+        chan.mTailLen = minz(contiguous ? chan.mTailLen+samples : samples, tail.size());
+    }
+}
+
+void LoadCompressedSamples(const al::span<float*> dstSamples, const size_t dstOffset,
+    const al::byte *src, const size_t srcOffset, const FmtType srcType,
+    const FmtChannels srcChans, const size_t srcStep, const size_t samplesPerBlock,
+    const size_t samples, const al::span<Voice::AdpcmChannel> adpcmChans) noexcept
+{
+    auto load_channel = [=](float *dst, const size_t srcChan) noexcept -> void
+    {
+        LoadAdpcmChannel(dst+dstOffset, src, srcChan, srcOffset, srcType, srcStep,
+            samplesPerBlock, samples, adpcmChans[srcChan]);
+    };
+
+    if(srcChans == FmtUHJ2 || srcChans == FmtSuperStereo)
+    {
+        load_channel(dstSamples[0], 0);
+        load_channel(dstSamples[1], 1);
+        std::fill_n(dstSamples[2]+dstOffset, samples, 0.0f);
+    }
+    else
+    {
+        size_t srcChan{0};
+        for(auto *dst : dstSamples)
+            load_channel(dst, srcChan++);
+    }
+}
+
 void LoadSamples(const al::span<float*> dstSamples, const size_t dstOffset, const al::byte *src,
     const size_t srcOffset, const FmtType srcType, const FmtChannels srcChans,
-    const size_t srcStep, const size_t samples) noexcept
+    const size_t srcStep, const size_t samplesPerBlock, const size_t samples,
+    const al::span<Voice::AdpcmChannel> adpcmChans) noexcept
 {
 #define HANDLE_FMT(T) case T:                                                 \
     LoadSamples<T>(dstSamples, dstOffset, src, srcOffset, srcChans, srcStep,  \
@@ -241,13 +338,82 @@ void LoadSamples(const al::span<float*> dstSamples, const size_t dstOffset, cons
     HANDLE_FMT(FmtDouble);
     HANDLE_FMT(FmtMulaw);
     HANDLE_FMT(FmtAlaw);
+    case FmtIMA4:
+    case FmtMSADPCM:
+        LoadCompressedSamples(dstSamples, dstOffset, src, srcOffset, srcType, srcChans, srcStep,
+            samplesPerBlock, samples, adpcmChans);
+        break;
     }
 #undef HANDLE_FMT
 }
 
+/* Resamples a channel directly from the buffer storage, instead of converting
+ * the whole line of source samples first. Samples are converted a block at a
+ * time and resampled while they're still in cache, with the unused samples
+ * carried over to the next block so each one only gets converted once. The
+ * history is used and updated the same as for a loaded line.
+ */
+template<FmtType Type>
+float *LoadResample(const ResamplerFunc resample, const InterpState *state, const al::byte *src,
+    const size_t srcStep, float *history, uint frac, const uint increment,
+    const al::span<float> dst)
+{
+    constexpr size_t sampleSize{sizeof(typename al::FmtTypeTraits<Type>::Type)};
+    constexpr size_t BlockSize{512};
+    alignas(16) std::array<float,MaxResamplerEdge+BlockSize+MaxResamplerEdge> block;
+
+    std::copy_n(history, MaxResamplerEdge, block.begin());
+    size_t blockFill{MaxResamplerEdge};
+    size_t pos{0};
+    do {
+        /* Limit the output so the source samples fit in the block, keeping a
+         * multiple of 4 for the mixers' alignment.
+         */
+        const size_t maxtodo{((BlockSize<<MixerFracBits) - frac) / increment};
+        size_t todo{dst.size() - pos};
+        if(todo > maxtodo) todo = maxtodo & ~size_t{3};
+
+        const size_t lastpos{((todo-1)*size_t{increment} + frac) >> MixerFracBits};
+        const size_t srcOffset{(todo*size_t{increment} + frac) >> MixerFracBits};
+        const size_t srcsize{maxz(lastpos+1, srcOffset) + MaxResamplerPadding};
+
+        al::LoadSampleArray<Type>(block.data()+blockFill, src, srcStep, srcsize-blockFill);
+        src += (srcsize-blockFill)*srcStep*sampleSize;
+
+        resample(state, block.data()+MaxResamplerEdge, frac, increment, {dst.data()+pos, todo});
+
+        std::copy(block.begin()+srcOffset, block.begin()+srcsize, block.begin());
+        blockFill = srcsize - srcOffset;
+        frac = static_cast<uint>((todo*size_t{increment} + frac) & MixerFracMask);
+        pos += todo;
+    } while(pos < dst.size());
+
+    /* Store the last source samples used for next time. */
+    std::copy_n(block.begin(), MaxResamplerPadding, history);
+    return dst.data();
+}
+
+LoadResamplerFunc SelectLoadResampler(const FmtType srcType) noexcept
+{
+    switch(srcType)
+    {
+    case FmtUByte: return LoadResample<FmtUByte>;
+    case FmtShort: return LoadResample<FmtShort>;
+    case FmtFloat: return LoadResample<FmtFloat>;
+    case FmtDouble: return LoadResample<FmtDouble>;
+    case FmtMulaw: return LoadResample<FmtMulaw>;
+    case FmtAlaw: return LoadResample<FmtAlaw>;
+    case FmtIMA4:
+    case FmtMSADPCM:
+        break;
+    }
+    return nullptr;
+}
+
 void LoadBufferStatic(VoiceBufferItem *buffer, VoiceBufferItem *bufferLoopItem,
     const size_t dataPosInt, const FmtType sampleType, const FmtChannels sampleChannels,
-    const size_t srcStep, const size_t samplesToLoad, const al::span<float*> voiceSamples)
+    const size_t srcStep, const size_t samplesToLoad, const al::span<float*> voiceSamples,
+    const al::span<Voice::AdpcmChannel> adpcmChans)
 {
     const uint loopStart{buffer->mLoopStart};
     const uint loopEnd{buffer->mLoopEnd};
@@ -259,7 +425,7 @@ void LoadBufferStatic(VoiceBufferItem *buffer, VoiceBufferItem *bufferLoopItem,
         /* Load what's left to play from the buffer */
         const size_t remaining{minz(samplesToLoad, buffer->mSampleLen-dataPosInt)};
         LoadSamples(voiceSamples, 0, buffer->mSamples, dataPosInt, sampleType, sampleChannels,
-            srcStep, remaining);
+            srcStep, buffer->mBlockAlign, remaining, adpcmChans);
 
         if(const size_t toFill{samplesToLoad - remaining})
         {
@@ -275,7 +441,7 @@ void LoadBufferStatic(VoiceBufferItem *buffer, VoiceBufferItem *bufferLoopItem,
         /* Load what's left of this loop iteration */
         const size_t remaining{minz(samplesToLoad, loopEnd-dataPosInt)};
         LoadSamples(voiceSamples, 0, buffer->mSamples, dataPosInt, sampleType, sampleChannels,
-            srcStep, remaining);
+            srcStep, buffer->mBlockAlign, remaining, adpcmChans);
 
         /* Load repeats of the loop to fill the buffer. */
         const auto loopSize = static_cast<size_t>(loopEnd - loopStart);
@@ -283,7 +449,7 @@ void LoadBufferStatic(VoiceBufferItem *buffer, VoiceBufferItem *bufferLoopItem,
         while(const size_t toFill{minz(samplesToLoad - samplesLoaded, loopSize)})
         {
             LoadSamples(voiceSamples, samplesLoaded, buffer->mSamples, loopStart, sampleType,
-                sampleChannels, srcStep, toFill);
+                sampleChannels, srcStep, buffer->mBlockAlign, toFill, adpcmChans);
             samplesLoaded += toFill;
         }
     }
@@ -296,7 +462,7 @@ void LoadBufferCallback(VoiceBufferItem *buffer, const size_t numCallbackSamples
     /* Load what's left to play from the buffer */
     const size_t remaining{minz(samplesToLoad, numCallbackSamples)};
     LoadSamples(voiceSamples, 0, buffer->mSamples, 0, sampleType, sampleChannels, srcStep,
-        remaining);
+        buffer->mBlockAlign, remaining, {});
 
     if(const size_t toFill{samplesToLoad - remaining})
     {
@@ -310,7 +476,8 @@ void LoadBufferCallback(VoiceBufferItem *buffer, const size_t numCallbackSamples
 
 void LoadBufferQueue(VoiceBufferItem *buffer, VoiceBufferItem *bufferLoopItem,
     size_t dataPosInt, const FmtType sampleType, const FmtChannels sampleChannels,
-    const size_t srcStep, const size_t samplesToLoad, const al::span<float*> voiceSamples)
+    const size_t srcStep, const size_t samplesToLoad, const al::span<float*> voiceSamples,
+    const al::span<Voice::AdpcmChannel> adpcmChans)
 {
     /* Crawl the buffer queue to fill in the temp buffer */
     size_t samplesLoaded{0};
@@ -326,7 +493,7 @@ void LoadBufferQueue(VoiceBufferItem *buffer, VoiceBufferItem *bufferLoopItem,
 
         const size_t remaining{minz(samplesToLoad-samplesLoaded, buffer->mSampleLen-dataPosInt)};
         LoadSamples(voiceSamples, samplesLoaded, buffer->mSamples, dataPosInt, sampleType,
-            sampleChannels, srcStep, remaining);
+            sampleChannels, srcStep, buffer->mBlockAlign, remaining, adpcmChans);
 
         samplesLoaded += remaining;
         if(samplesLoaded == samplesToLoad)
@@ -349,13 +516,41 @@ void LoadBufferQueue(VoiceBufferItem *buffer, VoiceBufferItem *bufferLoopItem,
 }
 
 
+/* Keeps the HRTF history current for a voice that's panned while the device
+ * renders with HRTF, so it can switch to direct HRTF without a gap in the
+ * delayed input.
+ */
+void UpdateHrtfHistory(const al::span<const float> samples, DirectParams &parms)
+{
+    auto &history = parms.Hrtf.History;
+    if(samples.size() >= history.size())
+        std::copy(samples.end()-history.size(), samples.end(), history.begin());
+    else
+    {
+        auto hist_iter = std::copy(history.begin()+samples.size(), history.end(),
+            history.begin());
+        std::copy(samples.begin(), samples.end(), hist_iter);
+    }
+}
+
+/* Block convolution with FFTs is cheaper than directly applying the IR to
+ * each sample once the IR is long enough. Each block also has a fixed cost
+ * regardless of how many samples it mixes, so it's only cheaper when mixing
+ * enough samples too.
+ */
+constexpr uint HrtfFftMinIrSize{48};
+constexpr uint HrtfFftMinSamples{128};
+
+constexpr bool UseHrtfFft(const uint irSize, const uint count) noexcept
+{ return irSize >= HrtfFftMinIrSize && count >= HrtfFftMinSamples; }
+
 void DoHrtfMix(const float *samples, const uint DstBufferSize, DirectParams &parms,
     const float TargetGain, const uint Counter, uint OutPos, const bool IsPlaying,
-    DeviceBase *Device)
+    DeviceBase *Device, MixerScratch &Scratch)
 {
     const uint IrSize{Device->mIrSize};
-    auto &HrtfSamples = Device->HrtfSourceData;
-    auto &AccumSamples = Device->HrtfAccumData;
+    auto &HrtfSamples = Scratch.HrtfSourceData;
+    float2 *AccumSamples{Scratch.getHrtfAccum()};
 
     /* Copy the HRTF history and new input samples into a temp buffer. */
     auto src_iter = std::copy(parms.Hrtf.History.begin(), parms.Hrtf.History.end(),
@@ -389,8 +584,12 @@ void DoHrtfMix(const float *samples, const uint DstBufferSize, DirectParams &par
             parms.Hrtf.Target.Coeffs,
             parms.Hrtf.Target.Delay,
             0.0f, gain / static_cast<float>(fademix)};
-        MixHrtfBlendSamples(HrtfSamples, AccumSamples+OutPos, IrSize, &parms.Hrtf.Old, &hrtfparams,
-            fademix);
+        if(UseHrtfFft(IrSize, fademix))
+            MixHrtfBlendFft(HrtfSamples, AccumSamples+OutPos, IrSize, &parms.Hrtf.Old, &hrtfparams,
+                parms.Hrtf.Spectra, fademix);
+        else
+            MixHrtfBlendSamples(HrtfSamples, AccumSamples+OutPos, IrSize, &parms.Hrtf.Old,
+                &hrtfparams, fademix);
 
         /* Update the old parameters with the result. */
         parms.Hrtf.Old = parms.Hrtf.Target;
@@ -417,7 +616,11 @@ void DoHrtfMix(const float *samples, const uint DstBufferSize, DirectParams &par
             parms.Hrtf.Target.Delay,
             parms.Hrtf.Old.Gain,
             (gain - parms.Hrtf.Old.Gain) / static_cast<float>(todo)};
-        MixHrtfSamples(HrtfSamples+fademix, AccumSamples+OutPos, IrSize, &hrtfparams, todo);
+        if(UseHrtfFft(IrSize, todo))
+            MixHrtfFft(HrtfSamples+fademix, AccumSamples+OutPos, IrSize, &hrtfparams,
+                parms.Hrtf.Spectra, todo);
+        else
+            MixHrtfSamples(HrtfSamples+fademix, AccumSamples+OutPos, IrSize, &hrtfparams, todo);
 
         /* Store the now-current gain for next time. */
         parms.Hrtf.Old.Gain = gain;
@@ -425,7 +628,8 @@ void DoHrtfMix(const float *samples, const uint DstBufferSize, DirectParams &par
 }
 
 void DoNfcMix(const al::span<const float> samples, FloatBufferLine *OutBuffer, DirectParams &parms,
-    const float *TargetGains, const uint Counter, const uint OutPos, DeviceBase *Device)
+    const float *TargetGains, const uint Counter, const uint OutPos, DeviceBase *Device,
+    MixerScratch &Scratch)
 {
     using FilterProc = void (NfcFilter::*)(const al::span<const float>, float*);
     static constexpr FilterProc NfcProcess[MaxAmbiOrder+1]{
@@ -437,7 +641,7 @@ void DoNfcMix(const al::span<const float> samples, FloatBufferLine *OutBuffer, D
     ++CurrentGains;
     ++TargetGains;
 
-    const al::span<float> nfcsamples{Device->NfcSampleData, samples.size()};
+    const al::span<float> nfcsamples{Scratch.NfcSampleData, samples.size()};
     size_t order{1};
     while(const size_t chancount{Device->NumChannelsPerOrder[order]})
     {
@@ -451,9 +655,138 @@ void DoNfcMix(const al::span<const float> samples, FloatBufferLine *OutBuffer, D
     }
 }
 
+/* The filters and gains for mixing a voice channel to the dry path or a send. */
+struct FilterMixTarget {
+    BiquadFilter *LowPass;
+    BiquadFilter *HighPass;
+    int FilterType;
+    al::span<FloatBufferLine> Buffer;
+    float *CurrentGains;
+    const float *TargetGains;
+};
+
+/* Filters and mixes the samples to each target together, a chunk at a time,
+ * rather than filtering a whole line and mixing it separately for each
+ * target. The targets' filters run as the lanes of a biquad bank, so their
+ * otherwise serial recurrences are processed together, and the filtered
+ * chunks stay in cache for mixing. If firstOut isn't null, the samples mixed
+ * for the first target are also written to it.
+ */
+void FilterMixSamples(const al::span<const float> samples, const al::span<FilterMixTarget> targets,
+    const uint Counter, const uint OutPos, float *firstOut)
+{
+    /* Keep a multiple of 4 so the mixers stay aligned. */
+    constexpr size_t ChunkSize{256};
+    static_assert(!(ChunkSize&3), "ChunkSize is not a multiple of 4");
+    static_assert(MAX_SENDS+1 <= BiquadBank<1>::MaxLanes, "Too many filter targets");
+
+    std::array<const float*,MAX_SENDS+1> sources;
+    std::array<float*,MAX_SENDS+1> filtered;
+    alignas(16) std::array<std::array<float,ChunkSize>,MAX_SENDS+1> filterData;
+    size_t numFilters{0};
+    bool hasBandPass{false};
+
+    for(auto &target : targets)
+    {
+        if(!(target.FilterType&AF_LowPass)) target.LowPass->clear();
+        if(!(target.FilterType&AF_HighPass)) target.HighPass->clear();
+        if(target.FilterType == AF_None)
+            continue;
+
+        hasBandPass |= (target.FilterType == AF_BandPass);
+        filtered[numFilters] = filterData[numFilters].data();
+        ++numFilters;
+    }
+
+    /* Each filtered target gets a lane, with its low-pass and/or high-pass
+     * filters as the lane's stages. Any stage a lane doesn't need is left to
+     * pass through.
+     */
+    auto filter_mix = [=,&filtered,&sources](auto &bank)
+    {
+        size_t lane{0};
+        for(auto &target : targets)
+        {
+            if(target.FilterType == AF_None)
+                continue;
+            size_t stage{0};
+            if((target.FilterType&AF_LowPass))
+            {
+                bank.setParams(lane, stage, *target.LowPass);
+                const auto z = target.LowPass->getComponents();
+                bank.setComponents(lane, stage++, z.first, z.second);
+            }
+            if((target.FilterType&AF_HighPass))
+            {
+                bank.setParams(lane, stage, *target.HighPass);
+                const auto z = target.HighPass->getComponents();
+                bank.setComponents(lane, stage++, z.first, z.second);
+            }
+            ++lane;
+        }
+
+        for(size_t pos{0};pos < samples.size();pos += ChunkSize)
+        {
+            const size_t todo{minz(samples.size()-pos, ChunkSize)};
+            const al::span<const float> chunk{samples.subspan(pos, todo)};
+
+            if(numFilters > 0)
+            {
+                std::fill_n(sources.begin(), numFilters, chunk.data());
+                bank.process({sources.data(), numFilters}, filtered.data(), todo);
+            }
+
+            if(firstOut)
+                std::copy_n((targets[0].FilterType == AF_None) ? chunk.data() : filtered[0],
+                    todo, firstOut+pos);
+
+            const uint counter{(Counter > pos) ? static_cast<uint>(Counter-pos) : 0u};
+            size_t f{0};
+            for(auto &target : targets)
+            {
+                const float *src{(target.FilterType == AF_None) ? chunk.data() : filtered[f++]};
+                MixSamples({src, todo}, target.Buffer, target.CurrentGains, target.TargetGains,
+                    counter, OutPos+pos);
+            }
+        }
+
+        lane = 0;
+        for(auto &target : targets)
+        {
+            if(target.FilterType == AF_None)
+                continue;
+            size_t stage{0};
+            if((target.FilterType&AF_LowPass))
+            {
+                const auto z = bank.getComponents(lane, stage++);
+                target.LowPass->setComponents(z.first, z.second);
+            }
+            if((target.FilterType&AF_HighPass))
+            {
+                const auto z = bank.getComponents(lane, stage++);
+                target.HighPass->setComponents(z.first, z.second);
+            }
+            ++lane;
+        }
+    };
+
+    /* Only a band-pass needs two stages. */
+    if(hasBandPass)
+    {
+        BiquadBank<2> bank;
+        filter_mix(bank);
+    }
+    else
+    {
+        BiquadBank<1> bank;
+        filter_mix(bank);
+    }
+}
+
 } // namespace
 
-void Voice::mix(const State vstate, ContextBase *Context, const uint SamplesToDo)
+void Voice::mix(const State vstate, ContextBase *Context, const uint SamplesToDo,
+    MixerScratch &Scratch)
 {
     static constexpr std::array<float,MAX_OUTPUT_CHANNELS> SilentTarget{};
 
@@ -480,6 +813,12 @@ void Voice::mix(const State vstate, ContextBase *Context, const uint SamplesToDo
 
     ResamplerFunc Resample{(increment == MixerFracOne && DataPosFrac == 0) ?
                            Resample_<CopyTag,CTag> : mResampler};
+    /* Samples that only need converting can be resampled directly from the
+     * buffer storage. Not needed when copying, since the loaded samples are
+     * then used as-is.
+     */
+    const LoadResamplerFunc LoadResample{(Resample == mResampler && !mDecoder
+        && !mFlags.test(VoiceIsCallback)) ? SelectLoadResampler(mFmtType) : nullptr};
 
     uint Counter{mFlags.test(VoiceIsFading) ? SamplesToDo : 0};
     if(!Counter)
@@ -507,13 +846,97 @@ void Voice::mix(const State vstate, ContextBase *Context, const uint SamplesToDo
     else if UNLIKELY(!BufferListItem)
         Counter = std::min(Counter, 64u);
 
-    std::array<float*,DeviceBase::MixerChannelsMax> SamplePointers;
+    /* If the voice can't be heard, skip mixing and just update its position.
+     * Callback voices can't skip ahead without calling the callback, so those
+     * always get mixed.
+     */
+    if(vstate == Playing && BufferListItem && !mFlags.test(VoiceIsCallback)
+        && Device->Flags.test(VirtualVoices) && isInaudible(NumSends))
+    {
+        mFlags.set(VoiceIsVirtual);
+
+        const uint64_t DataPosFrac64{uint64_t{increment}*SamplesToDo + DataPosFrac};
+        DataPosInt += static_cast<uint>(DataPosFrac64 >> MixerFracBits);
+        DataPosFrac = static_cast<uint>(DataPosFrac64) & MixerFracMask;
+
+        uint buffers_done{0u};
+        if(mFlags.test(VoiceIsStatic))
+        {
+            if(BufferLoopItem)
+            {
+                const uint LoopStart{BufferListItem->mLoopStart};
+                const uint LoopEnd{BufferListItem->mLoopEnd};
+                if(DataPosInt >= LoopEnd)
+                {
+                    assert(LoopEnd > LoopStart);
+                    DataPosInt = ((DataPosInt-LoopStart)%(LoopEnd-LoopStart)) + LoopStart;
+                }
+            }
+            else if(DataPosInt >= BufferListItem->mSampleLen)
+                BufferListItem = nullptr;
+        }
+        else
+        {
+            do {
+                if(BufferListItem->mSampleLen > DataPosInt)
+                    break;
+
+                DataPosInt -= BufferListItem->mSampleLen;
+
+                ++buffers_done;
+                BufferListItem = BufferListItem->mNext.load(std::memory_order_relaxed);
+                if(!BufferListItem) BufferListItem = BufferLoopItem;
+            } while(BufferListItem);
+        }
+
+        mFlags.set(VoiceIsFading);
+        return updatePosition(Context, DataPosInt, DataPosFrac, BufferListItem, buffers_done);
+    }
+    if UNLIKELY(mFlags.test(VoiceIsVirtual))
+    {
+        /* The voice is audible again after being skipped. The sample history
+         * and filter states are from before it went quiet, so clear them out.
+         * The gains fade in from silence, so it starts smoothly from the
+         * current position.
+         */
+        mFlags.reset(VoiceIsVirtual);
+        for(auto &prevsamples : mPrevSamples)
+            prevsamples.fill(0.0f);
+        for(auto &chandata : mChans)
+        {
+            chandata.mDryParams.LowPass.clear();
+            chandata.mDryParams.HighPass.clear();
+            chandata.mDryParams.Hrtf.History.fill(0.0f);
+            for(auto &parms : chandata.mWetParams)
+            {
+                parms.LowPass.clear();
+                parms.HighPass.clear();
+            }
+        }
+    }
+
+    std::array<float*,MixerScratch::MixerChannelsMax> SamplePointers;
     const al::span<float*> MixingSamples{SamplePointers.data(), mChans.size()};
-    auto offset_bufferline = [](DeviceBase::MixerBufferLine &bufline) noexcept -> float*
+    auto offset_bufferline = [](MixerScratch::MixerBufferLine &bufline) noexcept -> float*
     { return bufline.data() + MaxResamplerEdge; };
-    std::transform(Device->mSampleData.end() - mChans.size(), Device->mSampleData.end(),
+    std::transform(Scratch.mSampleData.end() - mChans.size(), Scratch.mSampleData.end(),
         MixingSamples.begin(), offset_bufferline);
 
+    /* Get the buffers to mix into, which may be partial buffers when mixing
+     * on a worker thread.
+     */
+    const al::span<FloatBufferLine> DirectBuffer{Scratch.getBus(mDirect.Buffer)};
+    const al::span<FloatBufferLine> PrevDirectBuffer{mFlags.test(VoiceSwitchingHrtf) ?
+        Scratch.getBus(mPrevDirectBuffer) : al::span<FloatBufferLine>{}};
+    std::array<al::span<FloatBufferLine>,MAX_SENDS> SendBuffer;
+    for(uint send{0};send < NumSends;++send)
+    {
+        SendBuffer[send] = Scratch.getBus(mSend[send].Buffer);
+        /* Let the effect slot know it has input to process. */
+        if(EffectSlot *slot{mSend[send].Slot})
+            slot->mInputActive.store(true, std::memory_order_relaxed);
+    }
+
     const uint PostPadding{MaxResamplerEdge + mDecoderPadding};
     uint buffers_done{0u};
     uint OutPos{0u};
@@ -543,14 +966,14 @@ void Voice::mix(const State vstate, ContextBase *Context, const uint SamplesToDo
             DataSize64 = (DataSize64*increment + DataPosFrac) >> MixerFracBits;
             DataSize64 += PostPadding;
 
-            if(DataSize64 <= DeviceBase::MixerLineSize - MaxResamplerEdge)
+            if(DataSize64 <= MixerScratch::MixerLineSize - MaxResamplerEdge)
                 SrcBufferSize = static_cast<uint>(DataSize64);
             else
             {
                 /* If the source size got saturated, we can't fill the desired
                  * dst size. Figure out how many samples we can actually mix.
                  */
-                SrcBufferSize = DeviceBase::MixerLineSize - MaxResamplerEdge;
+                SrcBufferSize = MixerScratch::MixerLineSize - MaxResamplerEdge;
 
                 DataSize64 = SrcBufferSize - PostPadding;
                 DataSize64 = ((DataSize64<<MixerFracBits) - DataPosFrac) / increment;
@@ -570,6 +993,19 @@ void Voice::mix(const State vstate, ContextBase *Context, const uint SamplesToDo
             }
         }
 
+        /* Resample directly from the buffer when the samples needed for this
+         * update don't wrap around or go past the end of it. The samples are
+         * then read, and the history updated, as they're resampled.
+         */
+        const al::byte *DirectSamples{nullptr};
+        if(LoadResample && vstate == Playing && BufferListItem)
+        {
+            const uint BufferEnd{(mFlags.test(VoiceIsStatic) && BufferLoopItem) ?
+                BufferListItem->mLoopEnd : BufferListItem->mSampleLen};
+            if(DataPosInt < BufferEnd && SrcBufferSize <= BufferEnd-DataPosInt)
+                DirectSamples = BufferListItem->mSamples;
+        }
+
         if(unlikely(!BufferListItem))
         {
             const size_t srcOffset{(increment*DstBufferSize + DataPosFrac)>>MixerFracBits};
@@ -595,7 +1031,7 @@ void Voice::mix(const State vstate, ContextBase *Context, const uint SamplesToDo
                 ++prevSamples;
             }
         }
-        else
+        else if(!DirectSamples)
         {
             auto prevSamples = mPrevSamples.data();
             for(auto *chanbuffer : MixingSamples)
@@ -605,7 +1041,7 @@ void Voice::mix(const State vstate, ContextBase *Context, const uint SamplesToDo
             }
             if(mFlags.test(VoiceIsStatic))
                 LoadBufferStatic(BufferListItem, BufferLoopItem, DataPosInt, mFmtType,
-                    mFmtChannels, mFrameStep, SrcBufferSize, MixingSamples);
+                    mFmtChannels, mFrameStep, SrcBufferSize, MixingSamples, mAdpcmChans);
             else if(mFlags.test(VoiceIsCallback))
             {
                 if(!mFlags.test(VoiceCallbackStopped) && SrcBufferSize > mNumCallbackSamples)
@@ -630,7 +1066,7 @@ void Voice::mix(const State vstate, ContextBase *Context, const uint SamplesToDo
             }
             else
                 LoadBufferQueue(BufferListItem, BufferLoopItem, DataPosInt, mFmtType, mFmtChannels,
-                    mFrameStep, SrcBufferSize, MixingSamples);
+                    mFrameStep, SrcBufferSize, MixingSamples, mAdpcmChans);
 
             const size_t srcOffset{(increment*DstBufferSize + DataPosFrac)>>MixerFracBits};
             if(mDecoder)
@@ -653,20 +1089,69 @@ void Voice::mix(const State vstate, ContextBase *Context, const uint SamplesToDo
             }
         }
 
+        const size_t SampleSize{BytesFromFmt(mFmtType)};
+        const al::byte *directSamples{DirectSamples ?
+            DirectSamples + size_t{DataPosInt}*mFrameStep*SampleSize : nullptr};
+        auto prevSamples = mPrevSamples.begin();
         auto voiceSamples = MixingSamples.begin();
         for(auto &chandata : mChans)
         {
             /* Resample, then apply ambisonic upsampling as needed. */
-            float *ResampledData{Resample(&mResampleState, *voiceSamples, DataPosFrac, increment,
-                {Device->ResampledData, DstBufferSize})};
+            float *ResampledData{directSamples ?
+                LoadResample(Resample, &mResampleState, directSamples, mFrameStep,
+                    prevSamples->data(), DataPosFrac, increment,
+                    {Scratch.ResampledData, DstBufferSize}) :
+                Resample(&mResampleState, *voiceSamples, DataPosFrac, increment,
+                    {Scratch.ResampledData, DstBufferSize})};
+            if(directSamples)
+                directSamples += SampleSize;
+            ++prevSamples;
             ++voiceSamples;
 
             if(mFlags.test(VoiceIsAmbisonic))
                 chandata.mAmbiSplitter.processScale({ResampledData, DstBufferSize},
                     chandata.mAmbiHFScale, chandata.mAmbiLFScale);
 
+            /* Without HRTF or NFC, the dry path and sends can all be filtered
+             * and mixed in one pass.
+             */
+            if(!mFlags.test(VoiceHasHrtf) && !mFlags.test(VoiceHasNfc)
+                && !mFlags.test(VoiceSwitchingHrtf))
+            {
+                std::array<FilterMixTarget,MAX_SENDS+1> Targets;
+                size_t NumTargets{0};
+
+                DirectParams &dryparms = chandata.mDryParams;
+                Targets[NumTargets++] = FilterMixTarget{&dryparms.LowPass, &dryparms.HighPass,
+                    mDirect.FilterType, DirectBuffer, dryparms.Gains.Current.data(),
+                    likely(vstate == Playing) ? dryparms.Gains.Target.data()
+                        : SilentTarget.data()};
+                for(uint send{0};send < NumSends;++send)
+                {
+                    if(SendBuffer[send].empty())
+                        continue;
+
+                    SendParams &parms = chandata.mWetParams[send];
+                    Targets[NumTargets++] = FilterMixTarget{&parms.LowPass, &parms.HighPass,
+                        mSend[send].FilterType, SendBuffer[send], parms.Gains.Current.data(),
+                        likely(vstate == Playing) ? parms.Gains.Target.data()
+                            : SilentTarget.data()};
+                }
+
+                /* Keep the HRTF history current with the filtered dry samples,
+                 * so it's ready to fade in if the voice switches to HRTF.
+                 */
+                float *DryFiltered{(Device->mRenderMode == RenderMode::Hrtf && vstate == Playing)
+                    ? Scratch.FilteredData : nullptr};
+                FilterMixSamples({ResampledData, DstBufferSize}, {Targets.data(), NumTargets},
+                    Counter, OutPos, DryFiltered);
+                if(DryFiltered)
+                    UpdateHrtfHistory({DryFiltered, DstBufferSize}, dryparms);
+                continue;
+            }
+
             /* Now filter and mix to the appropriate outputs. */
-            const al::span<float,BufferLineSize> FilterBuf{Device->FilteredData};
+            const al::span<float,BufferLineSize> FilterBuf{Scratch.FilteredData};
             {
                 DirectParams &parms = chandata.mDryParams;
                 const float *samples{DoFilters(parms.LowPass, parms.HighPass, FilterBuf.data(),
@@ -676,24 +1161,45 @@ void Voice::mix(const State vstate, ContextBase *Context, const uint SamplesToDo
                 {
                     const float TargetGain{parms.Hrtf.Target.Gain * likely(vstate == Playing)};
                     DoHrtfMix(samples, DstBufferSize, parms, TargetGain, Counter, OutPos,
-                        (vstate == Playing), Device);
+                        (vstate == Playing), Device, Scratch);
                 }
                 else
                 {
                     const float *TargetGains{likely(vstate == Playing) ? parms.Gains.Target.data()
                         : SilentTarget.data()};
                     if(mFlags.test(VoiceHasNfc))
-                        DoNfcMix({samples, DstBufferSize}, mDirect.Buffer.data(), parms,
-                            TargetGains, Counter, OutPos, Device);
+                        DoNfcMix({samples, DstBufferSize}, DirectBuffer.data(), parms,
+                            TargetGains, Counter, OutPos, Device, Scratch);
                     else
-                        MixSamples({samples, DstBufferSize}, mDirect.Buffer,
+                        MixSamples({samples, DstBufferSize}, DirectBuffer,
                             parms.Gains.Current.data(), TargetGains, Counter, OutPos);
+
+                    /* When switching from HRTF, its history is updated when
+                     * fading it out below.
+                     */
+                    if(Device->mRenderMode == RenderMode::Hrtf && vstate == Playing
+                        && !mFlags.test(VoiceSwitchingHrtf))
+                        UpdateHrtfHistory({samples, DstBufferSize}, parms);
+                }
+
+                if UNLIKELY(mFlags.test(VoiceSwitchingHrtf))
+                {
+                    /* Fade out the path the voice switched from. */
+                    if(!mFlags.test(VoiceHasHrtf))
+                        DoHrtfMix(samples, DstBufferSize, parms, 0.0f, Counter, OutPos,
+                            (vstate == Playing), Device, Scratch);
+                    else if(mFlags.test(VoiceHadNfc))
+                        DoNfcMix({samples, DstBufferSize}, PrevDirectBuffer.data(), parms,
+                            SilentTarget.data(), Counter, OutPos, Device, Scratch);
+                    else
+                        MixSamples({samples, DstBufferSize}, PrevDirectBuffer,
+                            parms.Gains.Current.data(), SilentTarget.data(), Counter, OutPos);
                 }
             }
 
             for(uint send{0};send < NumSends;++send)
             {
-                if(mSend[send].Buffer.empty())
+                if(SendBuffer[send].empty())
                     continue;
 
                 SendParams &parms = chandata.mWetParams[send];
@@ -702,7 +1208,7 @@ void Voice::mix(const State vstate, ContextBase *Context, const uint SamplesToDo
 
                 const float *TargetGains{likely(vstate == Playing) ? parms.Gains.Target.data()
                     : SilentTarget.data()};
-                MixSamples({samples, DstBufferSize}, mSend[send].Buffer,
+                MixSamples({samples, DstBufferSize}, SendBuffer[send],
                     parms.Gains.Current.data(), TargetGains, Counter, OutPos);
             }
         }
@@ -779,7 +1285,7 @@ void Voice::mix(const State vstate, ContextBase *Context, const uint SamplesToDo
         }
     } while(OutPos < SamplesToDo);
 
-    mFlags.set(VoiceIsFading);
+    mFlags.set(VoiceIsFading).reset(VoiceSwitchingHrtf);
 
     /* Don't update positions and buffers if we were stopping. */
     if(unlikely(vstate == Stopping))
@@ -788,6 +1294,12 @@ void Voice::mix(const State vstate, ContextBase *Context, const uint SamplesToDo
         return;
     }
 
+    updatePosition(Context, DataPosInt, DataPosFrac, BufferListItem, buffers_done);
+}
+
+void Voice::updatePosition(ContextBase *Context, const uint DataPosInt, const uint DataPosFrac,
+    VoiceBufferItem *BufferListItem, const uint buffers_done)
+{
     /* Capture the source ID in case it's reset for stopping. */
     const uint SourceID{mSourceID.load(std::memory_order_relaxed)};
 
@@ -802,9 +1314,28 @@ void Voice::mix(const State vstate, ContextBase *Context, const uint SamplesToDo
     }
     std::atomic_thread_fence(std::memory_order_release);
 
-    /* Send any events now, after the position/buffer info was updated. */
+    /* Hold any events until all voices are mixed, since this may not be the
+     * mixer thread. They're sent after the position/buffer info was updated.
+     */
     const uint enabledevt{Context->mEnabledEvts.load(std::memory_order_acquire)};
-    if(buffers_done > 0 && (enabledevt&AsyncEvent::BufferCompleted))
+    mEventSourceID = SourceID;
+    if((enabledevt&AsyncEvent::BufferCompleted))
+        mEventBuffersDone += buffers_done;
+
+    if(!BufferListItem)
+    {
+        /* If the voice just ended, set it to Stopping so the next render
+         * ensures any residual noise fades to 0 amplitude.
+         */
+        mPlayState.store(Stopping, std::memory_order_release);
+        if((enabledevt&AsyncEvent::SourceStateChange))
+            mEventStopped = true;
+    }
+}
+
+void Voice::sendEvents(ContextBase *Context)
+{
+    if(mEventBuffersDone > 0)
     {
         RingBuffer *ring{Context->mAsyncEvents.get()};
         auto evt_vec = ring->getWriteVector();
@@ -812,21 +1343,54 @@ void Voice::mix(const State vstate, ContextBase *Context, const uint SamplesToDo
         {
             AsyncEvent *evt{al::construct_at(reinterpret_cast<AsyncEvent*>(evt_vec.first.buf),
                 AsyncEvent::BufferCompleted)};
-            evt->u.bufcomp.id = SourceID;
-            evt->u.bufcomp.count = buffers_done;
+            evt->u.bufcomp.id = mEventSourceID;
+            evt->u.bufcomp.count = mEventBuffersDone;
             ring->writeAdvance(1);
         }
+        mEventBuffersDone = 0;
     }
+    if(mEventStopped)
+    {
+        SendSourceStoppedEvent(Context, mEventSourceID);
+        mEventStopped = false;
+    }
+}
 
-    if(!BufferListItem)
+bool Voice::isInaudible(const uint NumSends) const noexcept
+{
+    auto is_silent = [](const float gain) noexcept -> bool
+    { return !(std::abs(gain) > GainSilenceThreshold); };
+    auto all_silent = [is_silent](const std::array<float,MAX_OUTPUT_CHANNELS> &gains,
+        const size_t count) noexcept -> bool
+    { return std::all_of(gains.cbegin(), gains.cbegin()+count, is_silent); };
+
+    /* The previous path may still be audible while fading out. */
+    if(mFlags.test(VoiceSwitchingHrtf))
+        return false;
+
+    const size_t numdry{minz(mDirect.Buffer.size(), MAX_OUTPUT_CHANNELS)};
+    for(const auto &chandata : mChans)
     {
-        /* If the voice just ended, set it to Stopping so the next render
-         * ensures any residual noise fades to 0 amplitude.
-         */
-        mPlayState.store(Stopping, std::memory_order_release);
-        if((enabledevt&AsyncEvent::SourceStateChange))
-            SendSourceStoppedEvent(Context, SourceID);
+        const DirectParams &dparms = chandata.mDryParams;
+        if(mFlags.test(VoiceHasHrtf))
+        {
+            if(!is_silent(dparms.Hrtf.Old.Gain) || !is_silent(dparms.Hrtf.Target.Gain))
+                return false;
+        }
+        else if(!all_silent(dparms.Gains.Current, numdry)
+            || !all_silent(dparms.Gains.Target, numdry))
+            return false;
+
+        for(uint send{0};send < NumSends;++send)
+        {
+            const size_t numwet{minz(mSend[send].Buffer.size(), MAX_OUTPUT_CHANNELS)};
+            const SendParams &wparms = chandata.mWetParams[send];
+            if(!all_silent(wparms.Gains.Current, numwet)
+                || !all_silent(wparms.Gains.Target, numwet))
+                return false;
+        }
     }
+    return true;
 }
 
 void Voice::prepare(DeviceBase *device)
@@ -836,11 +1400,11 @@ void Voice::prepare(DeviceBase *device)
      */
     uint num_channels{(mFmtChannels == FmtUHJ2 || mFmtChannels == FmtSuperStereo) ? 3 :
         ChannelsFromFmt(mFmtChannels, minu(mAmbiOrder, device->mAmbiOrder))};
-    if(unlikely(num_channels > device->mSampleData.size()))
+    if(unlikely(num_channels > MixerScratch::MixerChannelsMax))
     {
         ERR("Unexpected channel count: %u (limit: %zu, %d:%d)\n", num_channels,
-            device->mSampleData.size(), mFmtChannels, mAmbiOrder);
-        num_channels = static_cast<uint>(device->mSampleData.size());
+            MixerScratch::MixerChannelsMax, mFmtChannels, mAmbiOrder);
+        num_channels = static_cast<uint>(MixerScratch::MixerChannelsMax);
     }
     if(mChans.capacity() > 2 && num_channels < mChans.capacity())
     {
@@ -876,6 +1440,15 @@ void Voice::prepare(DeviceBase *device)
     /* Make sure the sample history is cleared. */
     std::fill(mPrevSamples.begin(), mPrevSamples.end(), HistoryLine{});
 
+    /* Start ADPCM buffers with fresh decoder states. */
+    if(mFmtType == FmtIMA4 || mFmtType == FmtMSADPCM)
+    {
+        mAdpcmChans.resize(num_channels);
+        std::fill(mAdpcmChans.begin(), mAdpcmChans.end(), AdpcmChannel{});
+    }
+    else
+        decltype(mAdpcmChans){}.swap(mAdpcmChans);
+
     /* Don't need to set the VoiceIsAmbisonic flag if the device is not higher
      * order than the voice. No HF scaling is necessary to mix it.
      */
@@ -18,6 +18,7 @@
 #include "filters/biquad.h"
 #include "filters/nfc.h"
 #include "filters/splitter.h"
+#include "fmt_traits.h"
 #include "mixer/defs.h"
 #include "mixer/hrtfdefs.h"
 #include "resampler_limits.h"
@@ -27,6 +28,7 @@
 struct ContextBase;
 struct DeviceBase;
 struct EffectSlot;
+struct MixerScratch;
 enum class DistanceModel : unsigned char;
 
 using uint = unsigned int;
@@ -72,6 +74,7 @@ struct DirectParams {
         HrtfFilter Old;
         HrtfFilter Target;
         alignas(16) std::array<float,HrtfHistoryLength> History;
+        HrirSpectra Spectra;
     } Hrtf;
 
     struct {
@@ -100,6 +103,8 @@ struct VoiceBufferItem {
     uint mSampleLen{0u};
     uint mLoopStart{0u};
     uint mLoopEnd{0u};
+    /* Sample frames per block, for compressed formats. */
+    uint mBlockAlign{1u};
 
     al::byte *mSamples{nullptr};
 };
@@ -150,7 +155,7 @@ struct VoiceProps {
         float LFReference;
     } Direct;
     struct SendData {
-        EffectSlot *Slot;
+        EffectSlot *Slot{nullptr};
         float Gain;
         float GainHF;
         float HFReference;
@@ -173,6 +178,16 @@ enum : uint {
     VoiceIsFading,
     VoiceHasHrtf,
     VoiceHasNfc,
+    VoiceIsVirtual,
+    /* The dry path is fading out from the previous update's path, after
+     * switching between HRTF and panning.
+     */
+    VoiceSwitchingHrtf,
+    VoiceHadNfc,
+    /* Panned to the ambisonic mix instead of using direct HRTF, for not being
+     * among the device's most important voices.
+     */
+    VoiceHrtfPanned,
 
     VoiceFlagCount
 };
@@ -232,13 +247,33 @@ struct Voice {
     std::bitset<VoiceFlagCount> mFlags{};
     uint mNumCallbackSamples{0};
 
+    /* The level of detail the voice is being mixed with (see DetailFull). */
+    uint mDetailTier{0};
+
     struct TargetData {
         int FilterType;
         al::span<FloatBufferLine> Buffer;
+        /* The effect slot being sent to, for auxiliary sends. */
+        EffectSlot *Slot;
     };
     TargetData mDirect;
     std::array<TargetData,MAX_SENDS> mSend;
 
+    /* The dry buffer being faded out from, while VoiceSwitchingHrtf is set. */
+    al::span<FloatBufferLine> mPrevDirectBuffer;
+
+    /* How important the voice is for getting direct HRTF, given its dry gain.
+     * Zero if it can't use direct HRTF.
+     */
+    float mHrtfPriority{0.0f};
+
+    /* Events from the last mix, held until every thread finishes mixing so
+     * they can be sent from the mixer thread alone.
+     */
+    uint mEventSourceID{0u};
+    uint mEventBuffersDone{0u};
+    bool mEventStopped{false};
+
     /* The first MaxResamplerPadding/2 elements are the sample history from the
      * previous mix, with an additional MaxResamplerPadding/2 elements that are
      * now current (which may be overwritten if the buffer data is still
@@ -247,6 +282,18 @@ struct Voice {
     using HistoryLine = std::array<float,MaxResamplerPadding>;
     al::vector<HistoryLine,16> mPrevSamples{2};
 
+    /* The decoding state for each channel of IMA4 and MSADPCM buffers. The
+     * last decoded samples are kept since each mix reloads the resampler and
+     * decoder padding of the previous one, and ADPCM can't decode backward.
+     */
+    struct AdpcmChannel {
+        const al::byte *mSrc{nullptr};
+        al::AdpcmState mState{};
+        size_t mTailLen{0};
+        std::array<float,MaxResamplerEdge+UhjFilterBase::sFilterDelay+1> mTail{};
+    };
+    al::vector<AdpcmChannel> mAdpcmChans;
+
     struct ChannelData {
         float mAmbiHFScale, mAmbiLFScale;
         BandSplitter mAmbiSplitter;
@@ -262,7 +309,27 @@ struct Voice {
     Voice(const Voice&) = delete;
     Voice& operator=(const Voice&) = delete;
 
-    void mix(const State vstate, ContextBase *Context, const uint SamplesToDo);
+    void mix(const State vstate, ContextBase *Context, const uint SamplesToDo,
+        MixerScratch &Scratch);
+
+    /**
+     * Sends the events held from the last mix to the context's event queue.
+     * Must only be called on the mixer thread, after all voices are mixed.
+     */
+    void sendEvents(ContextBase *Context);
+
+    /**
+     * Returns true if the voice's current and target gains are all too quiet
+     * to be heard, for the dry path and any active sends.
+     */
+    bool isInaudible(const uint NumSends) const noexcept;
+
+    /**
+     * Stores the playback position and buffer after a mix, sending any
+     * buffer-completed or stopped events.
+     */
+    void updatePosition(ContextBase *Context, const uint DataPosInt, const uint DataPosFrac,
+        VoiceBufferItem *BufferListItem, const uint buffers_done);
 
     void prepare(DeviceBase *device);
 